@@ -0,0 +1,52 @@
+#pragma once
+
+#include <sally/sally.hpp>
+#include <SDL.h>
+#include <cstdlib>
+
+// every benchmark gets the command line arguments following its name
+int bench_soft_raster(int argc, char** argv);
+int bench_capture(int argc, char** argv);
+int bench_tile_map(int argc, char** argv);
+int bench_hit_index(int argc, char** argv);
+int bench_sprites(int argc, char** argv);
+int bench_ecs(int argc, char** argv);
+int bench_particles(int argc, char** argv);
+int bench_search(int argc, char** argv);
+int bench_tablebase(int argc, char** argv);
+int bench_pixel_convert(int argc, char** argv);
+int bench_text(int argc, char** argv);
+int bench_frame_arena(int argc, char** argv);
+int bench_snapshot(int argc, char** argv);
+int bench_locks(int argc, char** argv);
+int bench_main_queue(int argc, char** argv);
+int bench_coroutines(int argc, char** argv);
+int bench_idle(int argc, char** argv);
+int bench_input_latency(int argc, char** argv);
+int bench_metrics(int argc, char** argv);
+int bench_dynamic_resolution(int argc, char** argv);
+int bench_culling(int argc, char** argv);
+int bench_audio(int argc, char** argv);
+int bench_rollback(int argc, char** argv);
+
+namespace bench {
+
+	inline double now_ms() {
+		return SDL_GetPerformanceCounter() * 1000.0 / SDL_GetPerformanceFrequency();
+	}
+
+	inline int int_arg(int argc, char** argv, int index_, int default_) {
+		return index_ < argc ? std::atoi(argv[index_]) : default_;
+	}
+
+	// small deterministic generator so runs are comparable
+	class rng {
+	public:
+		explicit rng(uint32_t seed_ = 0x12345678) : _state(seed_ ? seed_ : 1) {}
+		uint32_t next() { _state ^= _state << 13; _state ^= _state >> 17; _state ^= _state << 5; return _state; }
+		int range(int lo_, int hi_) { return lo_ + static_cast<int>(next() % static_cast<uint32_t>(hi_ - lo_)); }
+	private:
+		uint32_t _state;
+	};
+
+}
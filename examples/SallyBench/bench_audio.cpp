@@ -0,0 +1,87 @@
+#include "bench.hpp"
+#include <sally/audio/mixer.hpp>
+#include <iostream>
+#include <vector>
+#include <cmath>
+
+namespace {
+
+	using namespace sally;
+
+	shared_ptr<Sound> tone(const char* name_, float hz_, double seconds_)
+	{
+		const size_t frames = static_cast<size_t>(seconds_ * Sound::SAMPLE_RATE);
+		std::vector<float> samples(frames * 2);
+		for (size_t ii = 0; ii < frames; ++ii)
+			samples[2 * ii] = samples[2 * ii + 1] = 0.1f * std::sin(6.2831853f * hz_ * ii / Sound::SAMPLE_RATE);
+		return make_shared<Sound>(name_, std::move(samples));
+	}
+
+	void kernels(int frames_)
+	{
+		std::vector<float> dst(2 * frames_, 0.0f), src(2 * frames_, 0.25f);
+		const int rounds = 2000;
+		double t0 = bench::now_ms();
+		for (int rr = 0; rr < rounds; ++rr)
+			audio_kernels::mix_stereo_scalar(dst.data(), src.data(), dst.size(), 0.5f, 0.25f);
+		const double scalar_ms = bench::now_ms() - t0;
+		t0 = bench::now_ms();
+		for (int rr = 0; rr < rounds; ++rr)
+			audio_kernels::mix_stereo(dst.data(), src.data(), dst.size(), 0.5f, 0.25f);
+		const double simd_ms = bench::now_ms() - t0;
+		std::cout << "mix kernel (" << audio_kernels::isa() << "): " << 1e6 * simd_ms / (double(rounds) * frames_) << " ns per frame, scalar "
+			<< 1e6 * scalar_ms / (double(rounds) * frames_) << " ns per frame" << std::endl;
+	}
+
+}
+
+int bench_audio(int argc, char** argv)
+{
+	const int voices = std::min(bench::int_arg(argc, argv, 0, 48), AudioMixer::MAX_VOICES - 1);
+	const int seconds = std::max(1, bench::int_arg(argc, argv, 1, 3));
+	const char* driver = argc > 2 ? argv[2] : "dummy";
+
+	System::InitGuard initgrd(true);
+	AudioMixer& mixer = System::audio();
+	std::vector<shared_ptr<Sound> > music;
+	for (int vv = 0; vv < voices; ++vv)
+		music.push_back(tone("loop", 110.0f + 20 * vv, 2.0));
+	shared_ptr<Sound> blip = tone("blip", 880, 0.05);
+
+	// through the device: a game loop at 60 Hz triggering one shot sounds over the music
+	AudioMixer::Config config;
+	config.driver = driver;
+	mixer.open(config);
+	for (int vv = 0; vv < voices; ++vv)
+		mixer.play(music[vv], 0.5f, (vv % 3 - 1) * 0.5f, true);
+	int triggered = 0;
+	const double start = bench::now_ms();
+	while (bench::now_ms() - start < seconds * 1000.0) {
+		if (mixer.play(blip, 1.0f, (triggered % 5 - 2) * 0.5f))
+			++triggered;
+		mixer.update();
+		SDL_Delay(16);
+	}
+	const histogram& cb = mixer.callback_time();
+	const histogram& lat = mixer.command_latency();
+	std::cout << "device (" << driver << ", " << mixer.buffer_frames() << " frames per callback): " << mixer.callbacks() << " callbacks, "
+		<< triggered << " one shots, " << mixer.dropped_commands() << " dropped commands" << std::endl;
+	std::cout << "  callback us: p50 " << cb.percentile(50) << " p99 " << cb.percentile(99) << " max " << cb.max() << std::endl;
+	std::cout << "  play to mix us: p50 " << lat.percentile(50) << " p99 " << lat.percentile(99) << " max " << lat.max() << std::endl;
+	mixer.close();
+
+	// offline (device closed): how much faster than real time one core mixes the voices
+	for (int vv = 0; vv < voices; ++vv)
+		mixer.play(music[vv], 0.5f, (vv % 3 - 1) * 0.5f, true);
+	std::vector<float> out(2 * 48000);
+	const double t0 = bench::now_ms();
+	for (int ss = 0; ss < seconds; ++ss)
+		mixer.render(out.data(), 48000);
+	const double mix_ms = bench::now_ms() - t0;
+	std::cout << voices << " voices mixed offline: " << mix_ms / seconds << " ms per second of audio ("
+		<< 1000.0 * seconds / mix_ms << "x real time)" << std::endl;
+	mixer.close();
+
+	kernels(mixer.buffer_frames() ? mixer.buffer_frames() : 256);
+	return 0;
+}
@@ -0,0 +1,72 @@
+#include "bench.hpp"
+#include <sally/gfx/frame_capture.hpp>
+#include <iostream>
+#include <iomanip>
+#include <cstring>
+
+namespace {
+
+	using namespace sally;
+
+	// moving gradient bars, enough to keep the encoder honest
+	class capture_scene : public RenderProvider {
+	public:
+		capture_scene() : _frame(0) {}
+
+		virtual void render(Window& win_) {
+			Renderer& rend = win_.renderer();
+			rend.clear(Color(16, 16, 32));
+			const int bars = 64;
+			for (int ii = 0; ii < bars; ++ii) {
+				int x = (ii * win_.width() / bars + _frame * 7) % win_.width();
+				rend.draw_color(Color(ii * 4, 255 - ii * 4, (ii * 37 + _frame) & 0xff));
+				rend.fill_rect(Rect(x, (ii * 13) % win_.height(), win_.width() / bars, win_.height() / 2));
+			}
+			++_frame;
+		}
+
+	private:
+		int _frame;
+	};
+
+}
+
+int bench_capture(int argc, char** argv)
+{
+	const char* fmt = argc > 0 ? argv[0] : "y4m";
+	const char* path = argc > 1 ? argv[1] : "capture.y4m";
+	const int frames = bench::int_arg(argc, argv, 2, 300);
+	const int width = bench::int_arg(argc, argv, 3, 1920);
+	const int height = bench::int_arg(argc, argv, 4, 1080);
+
+	FrameCapture::format_t format = FrameCapture::FORMAT_Y4M;
+	if (std::strcmp(fmt, "rgba") == 0)
+		format = FrameCapture::FORMAT_RGBA;
+	else if (std::strcmp(fmt, "png") == 0)
+		format = FrameCapture::FORMAT_PNG;
+
+	System::InitGuard initgrd(true);
+	capture_scene scene;
+	Window win("capture", width, height, Window::FLG_OFFSCREEN | Window::FLG_SOFTWARE_RASTER, &scene);
+
+	double t0 = bench::now_ms();
+	FrameCapture::Stats stats;
+	{
+		FrameCapture capture(path, format, 60);
+		win.renderer().set_frame_capture(&capture);
+		for (int ii = 0; ii < frames; ++ii)
+			win.render();
+		win.renderer().set_frame_capture(nullptr);
+		double render_ms = bench::now_ms() - t0;
+		std::cout << std::fixed << std::setprecision(2)
+			<< "rendered " << frames << " frames " << width << "x" << height << " at " << frames * 1000.0 / render_ms << " fps" << std::endl;
+		stats = capture.stats();
+	} // waits for the writers
+	double total_ms = bench::now_ms() - t0;
+
+	std::cout << "captured " << stats._captured << " written " << stats._written << " dropped " << stats._dropped << std::endl
+		<< "readback " << stats._readback_ms / std::max<uint64_t>(stats._captured, 1) << " ms/frame on render thread, "
+		<< "writing " << stats._write_ms / std::max<uint64_t>(stats._written, 1) << " ms/frame on writer threads" << std::endl
+		<< "end to end " << frames * 1000.0 / total_ms << " fps" << std::endl;
+	return 0;
+}
@@ -0,0 +1,105 @@
+#include "bench.hpp"
+#include <sally/coroutine.hpp>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+#ifdef SALLY_COROUTINES
+
+namespace {
+
+	using namespace sally;
+
+	long resumes = 0;
+
+	// waits a while, does a little work, repeats
+	task wander(int period_ms_) {
+		for (;;) {
+			co_await delay(period_ms_);
+			++resumes;
+		}
+	}
+
+	task short_lived() {
+		co_await next_frame();
+		++resumes;
+	}
+
+	// the same behaviour as a polled state machine
+	struct wanderer {
+		ticks_t _next;
+		int _period;
+
+		void step(ticks_t now_) {
+			if (now_ >= _next) {
+				_next = now_ + _period;
+				++resumes;
+			}
+		}
+	};
+
+}
+
+int bench_coroutines(int argc, char** argv)
+{
+	const int behaviours = bench::int_arg(argc, argv, 0, 10000);
+	const int frames = bench::int_arg(argc, argv, 1, 200);
+
+	System::InitGuard initgrd(true);
+	coroutine_scheduler& sched = System::coroutines();
+	bench::rng rng;
+	std::cout << std::fixed << std::setprecision(3);
+
+	resumes = 0;
+	std::vector<wanderer> polled;
+	const ticks_t start = clock_tick();
+	for (int ii = 0; ii < behaviours; ++ii) {
+		const int period = rng.range(500, 5000);
+		polled.push_back(wanderer{ start + period, period });
+	}
+	double t0 = bench::now_ms(), busy = 0;
+	for (int ff = 0; ff < frames; ++ff) {
+		const double f0 = bench::now_ms();
+		const ticks_t now = clock_tick();
+		for (wanderer& w : polled)
+			w.step(now);
+		busy += bench::now_ms() - f0;
+		SDL_Delay(1);
+	}
+	std::cout << "polled:     " << busy * 1000 / frames << " us/frame for " << behaviours << " behaviours, "
+		<< resumes << " wakeups in " << bench::now_ms() - t0 << " ms" << std::endl;
+
+	resumes = 0;
+	for (int ii = 0; ii < behaviours; ++ii)
+		wander(rng.range(500, 5000)); // dropped tasks keep running
+	t0 = bench::now_ms();
+	busy = 0;
+	for (int ff = 0; ff < frames; ++ff) {
+		const double f0 = bench::now_ms();
+		sched.run(clock_tick());
+		busy += bench::now_ms() - f0;
+		SDL_Delay(1);
+	}
+	std::cout << "coroutines: " << busy * 1000 / frames << " us/frame for " << sched.suspended() << " suspended, "
+		<< resumes << " wakeups in " << bench::now_ms() - t0 << " ms" << std::endl;
+	sched.clear();
+
+	// frame allocation: short lived coroutines started and finished every frame
+	const int spawns = behaviours;
+	t0 = bench::now_ms();
+	for (int ii = 0; ii < spawns; ++ii)
+		short_lived();
+	sched.run(clock_tick());
+	std::cout << "spawn+resume+destroy: " << (bench::now_ms() - t0) * 1e6 / spawns << " ns per coroutine" << std::endl;
+	return 0;
+}
+
+#else
+
+int bench_coroutines(int, char**)
+{
+	std::cout << "coroutines need a C++20 compiler, rebuild with coroutine support" << std::endl;
+	return 0;
+}
+
+#endif
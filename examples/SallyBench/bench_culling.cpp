@@ -0,0 +1,67 @@
+#include "bench.hpp"
+#include <iostream>
+#include <vector>
+
+namespace {
+
+	using namespace sally;
+
+	// large scrolling world, only a small part of it is on screen at any time
+	class world_scene : public RenderProvider {
+	public:
+		world_scene(int objects_, int world_size_) : _frame(0) {
+			bench::rng rnd;
+			_objects.reserve(objects_);
+			for (int ii = 0; ii < objects_; ++ii)
+				_objects.push_back(Rect(rnd.range(0, world_size_), rnd.range(0, world_size_), rnd.range(8, 32), rnd.range(8, 32)));
+		}
+
+		virtual void render(Window& win_) {
+			Renderer& rend = win_.renderer();
+			rend.clear(Color(0, 0, 0));
+			rend.set_camera(float(_frame * 7 % 4096), float(_frame * 3 % 4096), 1.0f + (_frame % 64) / 128.0f);
+			rend.draw_color(Color(200, 120, 40));
+			for (const Rect& obj : _objects)
+				rend.fill_rect(obj);
+
+			// minimap overlay in window coordinates, clipped to its frame
+			rend.push_absolute_transform(Renderer::Transform(10, 10, 0.02f));
+			rend.push_clip(Rect(0, 0, 8192, 8192));
+			rend.draw_color(Color(255, 255, 255));
+			for (size_t ii = 0; ii < _objects.size(); ii += 16)
+				rend.fill_rect(_objects[ii]);
+			rend.pop_clip();
+			rend.pop_transform();
+			++_frame;
+		}
+
+	private:
+		std::vector<Rect> _objects;
+		int _frame;
+	};
+
+}
+
+int bench_culling(int argc, char** argv)
+{
+	const int frames = std::max(1, bench::int_arg(argc, argv, 0, 200));
+	const int objects = bench::int_arg(argc, argv, 1, 100000);
+	const bool soft = bench::int_arg(argc, argv, 2, 1) != 0;
+
+	System::InitGuard initgrd(true);
+	world_scene scene(objects, 8192);
+	Window win("culling", 1280, 720, Window::FLG_OFFSCREEN | (soft ? Window::FLG_SOFTWARE_RASTER : 0), &scene);
+
+	uint64_t draws = 0, culled = 0;
+	const double start = bench::now_ms();
+	for (int ff = 0; ff < frames; ++ff) {
+		win.render();
+		draws += win.renderer().draw_stats().draws;
+		culled += win.renderer().draw_stats().culled;
+	}
+	const double ms = bench::now_ms() - start;
+	std::cout << (soft ? "software raster" : "SDL renderer") << ": " << ms / frames << " ms per frame, "
+		<< draws / frames << " draws per frame, " << 100.0 * culled / std::max<uint64_t>(draws, 1) << "% culled, "
+		<< 1e6 * ms / std::max<uint64_t>(draws, 1) << " ns per draw call" << std::endl;
+	return 0;
+}
@@ -0,0 +1,66 @@
+#include "bench.hpp"
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+namespace {
+
+	using namespace sally;
+
+	// fill rate bound scene: layers_ rects covering most of the window
+	class overdraw : public RenderProvider {
+	public:
+		explicit overdraw(int layers_) : _layers(layers_), _frame(0) {}
+
+		virtual void render(Window& win_) {
+			Renderer& rend = win_.renderer();
+			const Rect out = rend.output_rect();
+			rend.clear(Color(0, 0, 0));
+			for (int ii = 0; ii < _layers; ++ii) {
+				rend.draw_color(Color(uint8_t(40 * ii), uint8_t(255 - 30 * ii), uint8_t(_frame)));
+				rend.fill_rect(Rect((ii * 17 + _frame) % 64, (ii * 11) % 48, out._width - 64, out._height - 48));
+			}
+			++_frame;
+		}
+
+	private:
+		const int _layers;
+		int _frame;
+	};
+
+	void run(const char* label_, int frames_, int layers_, float target_ms_) {
+		overdraw scene(layers_);
+		Window win(label_, 1280, 720, Window::FLG_OFFSCREEN | Window::FLG_SOFTWARE_RASTER, &scene);
+		Renderer::DynamicResolution config;
+		config.target_ms = target_ms_;
+		win.set_dynamic_resolution(config);
+
+		std::vector<double> times;
+		float min_scale = 1;
+		for (int ff = 0; ff < frames_; ++ff) {
+			const double start = bench::now_ms();
+			win.render();
+			times.push_back(bench::now_ms() - start);
+			min_scale = std::min(min_scale, win.renderer().render_scale());
+		}
+		std::sort(times.begin(), times.end());
+		double sum = 0;
+		for (double tt : times)
+			sum += tt;
+		std::cout << label_ << ": avg " << sum / frames_ << " ms, p50 " << times[times.size() / 2] << " ms, p90 "
+			<< times[times.size() * 9 / 10] << " ms, final scale " << win.renderer().render_scale() << ", lowest " << min_scale << std::endl;
+	}
+
+}
+
+int bench_dynamic_resolution(int argc, char** argv)
+{
+	const int frames = std::max(1, bench::int_arg(argc, argv, 0, 300));
+	const int target_ms = bench::int_arg(argc, argv, 1, 4);
+	const int layers = bench::int_arg(argc, argv, 2, 24);
+
+	System::InitGuard initgrd(true);
+	run("full resolution", frames, layers, 0);
+	run("dynamic resolution", frames, layers, static_cast<float>(target_ms));
+	return 0;
+}
@@ -0,0 +1,92 @@
+#include "bench.hpp"
+#include <sally/ecs/components.hpp>
+#include <sally/ecs/scheduler.hpp>
+#include <sally/util/worker_pool.hpp>
+#include <iostream>
+#include <iomanip>
+
+namespace {
+
+	using namespace sally;
+	using namespace sally::ecs;
+
+	struct Health {
+		float _value;
+		float _regen;
+	};
+
+	struct Lifetime {
+		float _left;
+	};
+
+}
+
+int bench_ecs(int argc, char** argv)
+{
+	const int count = bench::int_arg(argc, argv, 0, 1000000);
+	const int iterations = bench::int_arg(argc, argv, 1, 100);
+	const float dt = 1.0f / 60;
+
+	World world;
+	bench::rng rnd;
+	double t0 = bench::now_ms();
+	for (int ii = 0; ii < count; ++ii) {
+		// a few archetypes so queries span several of them
+		Position pos = { float(rnd.range(0, 1920)), float(rnd.range(0, 1080)) };
+		Velocity vel = { float(rnd.range(-100, 100)), float(rnd.range(-100, 100)) };
+		switch (ii % 4) {
+		case 0: world.create(pos, vel); break;
+		case 1: world.create(pos, vel, Health{ 100, 1 }); break;
+		case 2: world.create(pos, vel, Lifetime{ float(rnd.range(1, 1000)) }); break;
+		default: world.create(pos, Health{ 50, 2 }); break;
+		}
+	}
+	const double create_ms = bench::now_ms() - t0;
+
+	t0 = bench::now_ms();
+	for (int it = 0; it < iterations; ++it)
+		world.each<Position, const Velocity>([dt](Position& pos_, const Velocity& vel_) {
+			pos_._x += vel_._x * dt;
+			pos_._y += vel_._y * dt;
+		});
+	const double each_ms = (bench::now_ms() - t0) / iterations;
+
+	t0 = bench::now_ms();
+	for (int it = 0; it < iterations; ++it)
+		integrate_velocity(world, dt);
+	const double chunk_ms = (bench::now_ms() - t0) / iterations;
+
+	worker_pool& pool = worker_pool::shared();
+	t0 = bench::now_ms();
+	for (int it = 0; it < iterations; ++it)
+		world.each_chunk_parallel<Position, const Velocity>(pool, [dt](size_t count_, Position* pos_, const Velocity* vel_) {
+			for (size_t ii = 0; ii < count_; ++ii) {
+				pos_[ii]._x += vel_[ii]._x * dt;
+				pos_[ii]._y += vel_[ii]._y * dt;
+			}
+		});
+	const double parallel_ms = (bench::now_ms() - t0) / iterations;
+
+	// movement, health and lifetime systems touch disjoint components and share one parallel stage
+	Scheduler sched;
+	sched.add("move", Scheduler::reads<Velocity>(), Scheduler::writes<Position>(), [dt](World& w_) { integrate_velocity(w_, dt); });
+	sched.add("regen", 0, Scheduler::writes<Health>(), [dt](World& w_) {
+		w_.each<Health>([dt](Health& h_) { h_._value = std::min(h_._value + h_._regen * dt, 100.0f); });
+	});
+	sched.add("age", 0, Scheduler::writes<Lifetime>(), [dt](World& w_) {
+		w_.each<Lifetime>([dt](Lifetime& l_) { l_._left -= dt; });
+	});
+	t0 = bench::now_ms();
+	for (int it = 0; it < iterations; ++it)
+		sched.run(world, &pool);
+	const double sched_ms = (bench::now_ms() - t0) / iterations;
+
+	const double per = 1e6 / count;
+	std::cout << std::fixed << std::setprecision(3)
+		<< world.size() << " entities created in " << create_ms << " ms" << std::endl
+		<< "each<Position, const Velocity>: " << each_ms << " ms (" << each_ms * per << " ns/entity)" << std::endl
+		<< "integrate_velocity (chunks):     " << chunk_ms << " ms (" << chunk_ms * per << " ns/entity)" << std::endl
+		<< "each_chunk_parallel:             " << parallel_ms << " ms on " << pool.concurrency() << " threads" << std::endl
+		<< "scheduler, 3 systems in " << sched.stage_count() << " stage(s): " << sched_ms << " ms" << std::endl;
+	return 0;
+}
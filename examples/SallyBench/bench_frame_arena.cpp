@@ -0,0 +1,112 @@
+#include "bench.hpp"
+#include <iostream>
+#include <iomanip>
+#include <new>
+#include <cstdlib>
+
+// counts global operator new calls of the whole benchmark binary (SDL's own mallocs are not included)
+static SDL_atomic_t heap_allocations = { 0 };
+
+void* operator new(size_t size_)
+{
+	SDL_AtomicAdd(&heap_allocations, 1);
+	if (void* ptr = std::malloc(size_ ? size_ : 1))
+		return ptr;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* ptr_) SALLY_NOEXCEPT
+{
+	std::free(ptr_);
+}
+
+void operator delete(void* ptr_, size_t) SALLY_NOEXCEPT
+{
+	std::free(ptr_);
+}
+
+namespace {
+
+	using namespace sally;
+
+	// a typical HUD frame: labels rebuilt from numbers, named renderables, per frame lists and logging
+	class hud_scene : public RenderProvider {
+	public:
+		explicit hud_scene(Font* font_) : _font(font_), _frame(0) {}
+
+		virtual void initialize(Window& win_) {
+			if (!_font)
+				return;
+			win_.renderer().insert("fps", new TextLine(_font, Color(255, 255, 255), "fps", Font::RENDER_SOLID, TextLine::UPDATE_STREAMING));
+			win_.renderer().insert("frame", new TextLine(_font, Color(255, 255, 255), "frame", Font::RENDER_SOLID, TextLine::UPDATE_STREAMING));
+		}
+
+		virtual void render(Window& win_) {
+			Renderer& rend = win_.renderer();
+			frame_arena& arena = System::arena();
+			rend.clear(Color(20, 20, 20));
+
+			arena_vector<Rect> bars{ arena_allocator<Rect>(arena) };
+			for (int ii = 0; ii < 64; ++ii)
+				bars.push_back(Rect(10 + ii * 12, 400 - (ii * 37 + _frame) % 300, 10, (ii * 37 + _frame) % 300));
+			rend.draw_color(Color(80, 160, 240));
+			for (const Rect& bar : bars)
+				rend.fill_rect(bar);
+
+			if (_font) {
+				string_builder fps(arena);
+				fps << "fps " << 60.0 - (_frame % 7) * 0.1;
+				static_cast<TextLine*>(rend.lookup("fps"))->set_text(fps.c_str());
+				string_builder frame(arena);
+				frame << "frame " << _frame;
+				static_cast<TextLine*>(rend.lookup("frame"))->set_text(frame.c_str());
+				rend.render("fps", 10, 10);
+				rend.render("frame", 10, 40);
+			}
+			logi() << "frame " << _frame << " rendered " << bars.size() << " bars";
+			++_frame;
+		}
+
+	private:
+		Font* _font;
+		int _frame;
+	};
+
+}
+
+int bench_frame_arena(int argc, char** argv)
+{
+	const int frames = bench::int_arg(argc, argv, 0, 1000);
+
+	System::InitGuard initgrd(true);
+	Font* font = nullptr;
+	try {
+		font = System::font_manger().load_font("bench", argc > 1 ? argv[1] : System::resouce_path("examples/SlidingPawn/sample.ttf"), 20);
+	}
+	catch (sally::exception& e) {
+		std::cout << "no font, skipping labels: " << e.what() << std::endl;
+	}
+	hud_scene scene(font);
+	Window win("frame_arena", 800, 480, Window::FLG_OFFSCREEN, &scene);
+
+	// same per frame sequence as System::main_loop
+	for (int ii = 0; ii < 10; ++ii) { // warm up: buffers reach their steady state sizes
+		System::arena().reset();
+		win.render();
+	}
+	const int before = SDL_AtomicGet(&heap_allocations);
+	double t0 = bench::now_ms();
+	for (int ii = 0; ii < frames; ++ii) {
+		System::arena().reset();
+		win.render();
+	}
+	const double ms = (bench::now_ms() - t0) / frames;
+	const int allocations = SDL_AtomicGet(&heap_allocations) - before;
+
+	const frame_arena& arena = System::arena();
+	std::cout << std::fixed << std::setprecision(3)
+		<< frames << " frames, " << ms << " ms/frame, " << double(allocations) / frames << " heap allocations/frame" << std::endl
+		<< "arena: peak " << arena.peak() << " bytes/frame, capacity " << arena.capacity() << " bytes, "
+		<< arena.blocks_allocated() << " blocks allocated in total" << std::endl;
+	return 0;
+}
@@ -0,0 +1,83 @@
+#include "bench.hpp"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+namespace {
+
+	using namespace sally;
+
+	struct sprite {
+		Rect _rect;
+		int _z;
+	};
+
+	// what applications did before HitIndex: scan every object
+	sprite* linear_pick(std::vector<sprite>& sprites_, int x_, int y_) {
+		sprite* best = nullptr;
+		for (sprite& s : sprites_) {
+			const Rect& r = s._rect;
+			if (x_ >= r._x && y_ >= r._y && x_ < r._x + r._width && y_ < r._y + r._height && (!best || s._z >= best->_z))
+				best = &s;
+		}
+		return best;
+	}
+
+}
+
+int bench_hit_index(int argc, char** argv)
+{
+	const int count = bench::int_arg(argc, argv, 0, 10000);
+	const int queries = bench::int_arg(argc, argv, 1, 100000);
+	const int moves = bench::int_arg(argc, argv, 2, 1000); // sprites moved between query batches
+	const int width = 1920, height = 1080, batches = 10;
+
+	bench::rng rnd;
+	std::vector<sprite> sprites(count);
+	HitIndex index;
+	for (int ii = 0; ii < count; ++ii) {
+		sprite& s = sprites[ii];
+		s._rect = Rect(rnd.range(-32, width), rnd.range(-32, height), rnd.range(8, 64), rnd.range(8, 64));
+		s._z = ii; // distinct z so both methods agree on ties
+		index.update(&s, s._rect, s._z);
+	}
+
+	double linear_ms = 0, index_ms = 0, move_ms = 0;
+	int hits = 0, mismatches = 0;
+	std::vector<std::pair<int, int> > points(queries);
+	std::vector<sprite*> picked(queries);
+	for (int bb = 0; bb < batches; ++bb) {
+		double t0 = bench::now_ms();
+		for (int ii = 0; ii < moves; ++ii) {
+			sprite& s = sprites[rnd.range(0, count)];
+			s._rect._x += rnd.range(-8, 9);
+			s._rect._y += rnd.range(-8, 9);
+			index.update(&s, s._rect, s._z);
+		}
+		move_ms += bench::now_ms() - t0;
+
+		for (auto& pt : points)
+			pt = std::make_pair(rnd.range(0, width), rnd.range(0, height));
+
+		t0 = bench::now_ms();
+		for (int ii = 0; ii < queries; ++ii)
+			picked[ii] = linear_pick(sprites, points[ii].first, points[ii].second);
+		linear_ms += bench::now_ms() - t0;
+
+		t0 = bench::now_ms();
+		for (int ii = 0; ii < queries; ++ii) {
+			sprite* s = static_cast<sprite*>(index.pick(points[ii].first, points[ii].second));
+			hits += s != nullptr;
+			mismatches += s != picked[ii];
+		}
+		index_ms += bench::now_ms() - t0;
+	}
+
+	const double total = double(queries) * batches;
+	std::cout << std::fixed << std::setprecision(3)
+		<< count << " objects, " << total << " picks, " << hits << " hits, " << mismatches << " mismatches" << std::endl
+		<< "linear scan: " << linear_ms * 1000 / total << " us/pick" << std::endl
+		<< "hit index:   " << index_ms * 1000 / total << " us/pick, "
+		<< move_ms * 1000 / (double(moves) * batches) << " us/move" << std::endl;
+	return mismatches ? 1 : 0;
+}
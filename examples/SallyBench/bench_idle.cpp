@@ -0,0 +1,70 @@
+#include "bench.hpp"
+#include <iostream>
+#include <iomanip>
+#include <ctime>
+
+namespace {
+
+	using namespace sally;
+
+	// a kiosk clock: something to update every period_ms_, nothing else going on
+	class ticker : public step_event_handler {
+	public:
+		explicit ticker(int period_ms_) : _period(period_ms_), _next(clock_tick()), _updates(0) {}
+		virtual void on_step_event() {
+			if (clock_tick() >= _next) {
+				_next += _period;
+				++_updates;
+			}
+		}
+		virtual int next_step_in_ms() {
+			const ticks_t now = clock_tick();
+			return _next > now ? static_cast<int>(_next - now) : 0;
+		}
+		int _period;
+		ticks_t _next;
+		int _updates;
+	};
+
+	int shutdown_after(void* ms_) {
+		SDL_Delay(*static_cast<int*>(ms_));
+		System::request_shutdown();
+		return 0;
+	}
+
+	void run(bool idle_, int seconds_, int period_ms_) {
+		ticker tick(period_ms_);
+		step_event_handler* old_handler = System::set_step_event_handler(&tick);
+		System::set_idle_mode(idle_);
+		int ms = seconds_ * 1000;
+		SDL_Thread* thread = SDL_CreateThread(&shutdown_after, "bench_shutdown", &ms);
+		if (!thread)
+			throw sdl_exception("SDL_CreateThread failed");
+
+		const uint64_t wakeups = System::wakeups();
+		const std::clock_t cpu0 = std::clock();
+		const double t0 = bench::now_ms();
+		System::main_loop();
+		const double wall = bench::now_ms() - t0;
+		const double cpu = (std::clock() - cpu0) * 1000.0 / CLOCKS_PER_SEC;
+		SDL_WaitThread(thread, nullptr);
+		System::set_step_event_handler(old_handler);
+
+		std::cout << std::fixed << std::setprecision(1) << (idle_ ? "idle mode: " : "polling:   ")
+			<< (System::wakeups() - wakeups) * 1000.0 / wall << " wakeups/s, " << cpu << " ms cpu in "
+			<< wall << " ms, " << tick._updates << " updates" << std::endl;
+	}
+
+}
+
+int bench_idle(int argc, char** argv)
+{
+	const int seconds = bench::int_arg(argc, argv, 0, 3);
+	const int period_ms = bench::int_arg(argc, argv, 1, 250);
+
+	System::InitGuard initgrd(true);
+	run(false, seconds, period_ms);
+	run(true, seconds, period_ms);
+	System::set_idle_mode(true);
+	return 0;
+}
@@ -0,0 +1,70 @@
+#include "bench.hpp"
+#include <iostream>
+
+namespace {
+
+	using namespace sally;
+
+	// every frame a key press is injected, the handler moves a box and invalidates the window
+	class typist : public RenderProvider, public keyboard_event_handler, public step_event_handler {
+	public:
+		typist(int events_, int boxes_) : _win(nullptr), _remaining(events_), _boxes(boxes_), _x(0) {}
+
+		virtual void render(Window& win_) {
+			Renderer& rend = win_.renderer();
+			rend.clear(Color(255, 255, 255));
+			rend.draw_color(Color(0, 0, 0));
+			for (int ii = 0; ii < _boxes; ++ii)
+				rend.fill_rect(Rect((_x + ii * 7) % 600, (ii * 13) % 440, 20, 20));
+		}
+
+		virtual void on_key_event(const keyboard_event& event_, Window*) {
+			if (event_._type != keyboard_event::KEY_PRESSED)
+				return;
+			_x += 5;
+			_win->invalidate();
+			if (--_remaining == 0)
+				System::request_shutdown();
+		}
+
+		virtual void on_step_event() {
+			SDL_Event ev;
+			SDL_zero(ev);
+			ev.type = SDL_KEYDOWN;
+			ev.key.keysym.sym = SDLK_SPACE;
+			SDL_PushEvent(&ev); // handled next frame
+		}
+
+		Window* _win;
+		int _remaining;
+		int _boxes;
+		int _x;
+	};
+
+}
+
+int bench_input_latency(int argc, char** argv)
+{
+	const int events = bench::int_arg(argc, argv, 0, 500);
+	const int boxes = bench::int_arg(argc, argv, 1, 2000);
+
+	System::InitGuard initgrd(true);
+	typist app(events, boxes);
+	Window win("input latency", 640, 480, Window::FLG_OFFSCREEN, &app);
+	app._win = &win;
+	keyboard_event_handler* old_keys = System::set_keyboard_event_handler(&app);
+	step_event_handler* old_step = System::set_step_event_handler(&app);
+	System::input_latency().reset();
+	System::main_loop();
+	System::set_keyboard_event_handler(old_keys);
+	System::set_step_event_handler(old_step);
+
+	const InputLatency& lat = System::input_latency();
+	std::cout << lat.stage(InputLatency::STAGE_TOTAL).count() << " events, " << lat.unseen() << " without visible effect (us):" << std::endl;
+	for (int ss = 0; ss < InputLatency::STAGES; ++ss) {
+		const histogram& hist = lat.stage(static_cast<InputLatency::stage_t>(ss));
+		std::cout << "  " << InputLatency::stage_name(static_cast<InputLatency::stage_t>(ss)) << ": p50 " << hist.percentile(50)
+			<< " p90 " << hist.percentile(90) << " p99 " << hist.percentile(99) << " max " << hist.max() << std::endl;
+	}
+	return 0;
+}
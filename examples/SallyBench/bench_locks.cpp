@@ -0,0 +1,173 @@
+#include "bench.hpp"
+#include <sally/util/threading.hpp>
+#include <iostream>
+#include <iomanip>
+#include <functional>
+#include <vector>
+#include <unordered_map>
+
+namespace {
+
+	using namespace sally;
+
+	// runs op_(thread) iterations_ times on each of threads_ threads, returns the wall time in ms
+	double run_threads(int threads_, int iterations_, const std::function<void(int)>& op_)
+	{
+		struct worker {
+			const std::function<void(int)>* _op;
+			SDL_atomic_t* _go;
+			int _index;
+			int _iterations;
+			static int main(void* self_) {
+				worker& self = *static_cast<worker*>(self_);
+				while (!SDL_AtomicGet(self._go))
+					;
+				for (int ii = 0; ii < self._iterations; ++ii)
+					(*self._op)(self._index);
+				return 0;
+			}
+		};
+		SDL_atomic_t go = { 0 };
+		std::vector<worker> workers(threads_);
+		std::vector<SDL_Thread*> handles;
+		for (int tt = 0; tt < threads_; ++tt) {
+			workers[tt] = { &op_, &go, tt, iterations_ };
+			SDL_Thread* thread = SDL_CreateThread(&worker::main, "bench_lock", &workers[tt]);
+			if (!thread)
+				throw sdl_exception("SDL_CreateThread failed");
+			handles.push_back(thread);
+		}
+		const double t0 = bench::now_ms();
+		SDL_AtomicSet(&go, 1);
+		for (SDL_Thread* thread : handles)
+			SDL_WaitThread(thread, nullptr);
+		return bench::now_ms() - t0;
+	}
+
+	void report(const char* name_, int threads_, int iterations_, double ms_, bool ok_)
+	{
+		std::cout << std::fixed << std::setprecision(1) << std::setw(28) << std::left << name_ << std::right
+			<< std::setw(9) << ms_ << " ms, " << std::setw(7) << 1e6 * ms_ / (double(threads_) * iterations_)
+			<< " ns/op" << (ok_ ? "" : "  COUNT MISMATCH") << std::endl;
+	}
+
+	// short critical section hammered by every thread
+	void counter_benchmarks(int threads_, int iterations_)
+	{
+		const long expected = long(threads_) * iterations_;
+		long counter = 0;
+		double ms;
+
+		SDL_mutex* sdl_mutex = SDL_CreateMutex();
+		if (!sdl_mutex)
+			throw sdl_exception("SDL_CreateMutex failed");
+		ms = run_threads(threads_, iterations_, [&](int) { SDL_LockMutex(sdl_mutex); ++counter; SDL_UnlockMutex(sdl_mutex); });
+		report("SDL_mutex", threads_, iterations_, ms, counter == expected);
+		SDL_DestroyMutex(sdl_mutex);
+
+		counter = 0;
+		sally::mutex mtx;
+		ms = run_threads(threads_, iterations_, [&](int) { sally::mutex::Guard lg(mtx); ++counter; });
+		report("sally::mutex", threads_, iterations_, ms, counter == expected);
+
+		counter = 0;
+		SDL_SpinLock sdl_spin = 0;
+		ms = run_threads(threads_, iterations_, [&](int) { SDL_AtomicLock(&sdl_spin); ++counter; SDL_AtomicUnlock(&sdl_spin); });
+		report("SDL_AtomicLock", threads_, iterations_, ms, counter == expected);
+
+		counter = 0;
+		spinlock spin;
+		ms = run_threads(threads_, iterations_, [&](int) { spinlock::Guard lg(spin); ++counter; });
+		report("sally::spinlock (backoff)", threads_, iterations_, ms, counter == expected);
+
+		counter = 0;
+		shared_mutex smtx;
+		ms = run_threads(threads_, iterations_, [&](int) { shared_mutex::Guard lg(smtx); ++counter; });
+		report("sally::shared_mutex (excl)", threads_, iterations_, ms, counter == expected);
+	}
+
+	// name lookups like Renderer::lookup with an occasional insert
+	void lookup_benchmarks(int threads_, int iterations_)
+	{
+		const int KEYS = 256, WRITE_EVERY = 100;
+		std::unordered_map<int, int> map;
+		for (int kk = 0; kk < KEYS; ++kk)
+			map[kk] = kk;
+		std::vector<bench::rng> rngs;
+		for (int tt = 0; tt < threads_; ++tt)
+			rngs.push_back(bench::rng(tt + 1));
+		bool ok = true;
+
+		sally::mutex mtx;
+		double ms = run_threads(threads_, iterations_, [&](int t_) {
+			const int key = rngs[t_].range(0, KEYS);
+			sally::mutex::Guard lg(mtx);
+			if (key % WRITE_EVERY == 0)
+				map[key] = key;
+			else if (map.find(key)->second != key)
+				ok = false;
+		});
+		report("lookups, sally::mutex", threads_, iterations_, ms, ok);
+
+		shared_mutex smtx;
+		ms = run_threads(threads_, iterations_, [&](int t_) {
+			const int key = rngs[t_].range(0, KEYS);
+			if (key % WRITE_EVERY == 0) {
+				shared_mutex::Guard lg(smtx);
+				map[key] = key;
+			}
+			else {
+				shared_mutex::SharedGuard lg(smtx);
+				if (map.find(key)->second != key)
+					ok = false;
+			}
+		});
+		report("lookups, shared_mutex", threads_, iterations_, ms, ok);
+	}
+
+	// two threads passing a token back and forth, every hand-off is a sleep and a wake
+	void ping_pong_benchmarks(int rounds_)
+	{
+		int turn = 0;
+		SDL_mutex* sdl_mutex = SDL_CreateMutex();
+		SDL_cond* sdl_cond = SDL_CreateCond();
+		if (!sdl_mutex || !sdl_cond)
+			throw sdl_exception("SDL_CreateMutex or SDL_CreateCond failed");
+		double ms = run_threads(2, rounds_, [&](int t_) {
+			SDL_LockMutex(sdl_mutex);
+			while (turn != t_)
+				SDL_CondWait(sdl_cond, sdl_mutex);
+			turn = 1 - t_;
+			SDL_CondSignal(sdl_cond);
+			SDL_UnlockMutex(sdl_mutex);
+		});
+		report("ping-pong, SDL_cond", 2, rounds_, ms, true);
+		SDL_DestroyCond(sdl_cond);
+		SDL_DestroyMutex(sdl_mutex);
+
+		turn = 0;
+		sally::mutex mtx;
+		condition_variable cond;
+		ms = run_threads(2, rounds_, [&](int t_) {
+			sally::mutex::Guard lg(mtx);
+			cond.wait(mtx, [&] { return turn == t_; });
+			turn = 1 - t_;
+			cond.notify_one();
+		});
+		report("ping-pong, condition_var", 2, rounds_, ms, true);
+	}
+
+}
+
+int bench_locks(int argc, char** argv)
+{
+	const int threads = bench::int_arg(argc, argv, 0, 4);
+	const int iterations = bench::int_arg(argc, argv, 1, 200000);
+
+	System::InitGuard initgrd(true);
+	std::cout << threads << " threads x " << iterations << " iterations" << std::endl;
+	counter_benchmarks(threads, iterations);
+	lookup_benchmarks(threads, iterations);
+	ping_pong_benchmarks(iterations / 10);
+	return 0;
+}
@@ -0,0 +1,91 @@
+#include "bench.hpp"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+namespace {
+
+	using namespace sally;
+
+	struct frame_times {
+		std::vector<double> _ms;
+		int _frames_to_complete;
+
+		void report(const char* name_) {
+			std::vector<double> sorted = _ms;
+			std::sort(sorted.begin(), sorted.end());
+			std::cout << std::fixed << std::setprecision(2) << name_ << ": max frame " << sorted.back()
+				<< " ms, median " << sorted[sorted.size() / 2] << " ms, all labels shown after "
+				<< _frames_to_complete << " frames" << std::endl;
+		}
+	};
+
+	std::string label_name(int index_) { return "label" + std::to_string(index_); }
+
+	void add_labels(Renderer& rend_, Font* font_, int count_) {
+		for (int ii = 0; ii < count_; ++ii)
+			rend_.insert(label_name(ii), new TextLine(font_, Color(0, 0, 0), "label number " + std::to_string(ii)));
+	}
+
+	// draws the labels that are ready, returns the frame time
+	double frame(Renderer& rend_, const std::vector<char>& ready_, bool drain_) {
+		const double t0 = bench::now_ms();
+		if (drain_)
+			System::main_queue().drain();
+		rend_.begin_render();
+		for (size_t ii = 0; ii < ready_.size(); ++ii)
+			if (ready_[ii])
+				rend_.render(label_name(static_cast<int>(ii)), 10 + static_cast<int>(ii % 8) * 70, 10 + static_cast<int>(ii / 8 % 40) * 12);
+		rend_.end_render();
+		return bench::now_ms() - t0;
+	}
+
+}
+
+int bench_main_queue(int argc, char** argv)
+{
+	const int labels = bench::int_arg(argc, argv, 0, 300);
+	const int budget_ms = bench::int_arg(argc, argv, 1, 4);
+	const int frames = bench::int_arg(argc, argv, 2, 60);
+
+	System::InitGuard initgrd(true);
+	const std::string path = argc > 3 ? argv[3] : System::resouce_path("examples/SlidingPawn/sample.ttf");
+	Font* font = System::font_manger().load_font("bench", path, 12);
+
+	{
+		// every label is uploaded by the frame that first draws it
+		Window win("burst", 640, 480, Window::FLG_OFFSCREEN, nullptr);
+		Renderer& rend = win.renderer();
+		add_labels(rend, font, labels);
+		std::vector<char> ready(labels, 1);
+		frame_times times = { {}, 1 };
+		for (int ff = 0; ff < frames; ++ff)
+			times._ms.push_back(frame(rend, ready, false));
+		times.report("uploads in the first frame");
+	}
+	{
+		// uploads posted to the main thread queue, labels are shown once their texture exists
+		Window win("budgeted", 640, 480, Window::FLG_OFFSCREEN, nullptr);
+		Renderer& rend = win.renderer();
+		add_labels(rend, font, labels);
+		std::vector<char> ready(labels, 0);
+		for (int ii = 0; ii < labels; ++ii)
+			System::post_main([&rend, &ready, ii] { ready[ii] = rend.preload(label_name(ii)); });
+		System::main_queue().set_budget_ms(budget_ms);
+		frame_times times = { {}, 0 };
+		size_t deferred_frames = 0;
+		for (int ff = 0; ff < frames || System::main_queue().pending(); ++ff) {
+			times._ms.push_back(frame(rend, ready, true));
+			const main_thread_queue::Report& rep = System::main_queue().last_report();
+			if (rep.deferred)
+				++deferred_frames;
+			else if (!times._frames_to_complete && rep.executed)
+				times._frames_to_complete = ff + 1;
+		}
+		std::cout << deferred_frames << " frames deferred work with a " << budget_ms << " ms budget" << std::endl;
+		times.report("uploads through post_main");
+	}
+	return 0;
+}
@@ -0,0 +1,51 @@
+#include "bench.hpp"
+#include <sally/util/metrics_exporter.hpp>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <cstdio>
+
+namespace {
+
+	using namespace sally;
+
+	template <class F> double ns_per_op(int iterations_, F&& op_) {
+		const double t0 = bench::now_ms();
+		for (int ii = 0; ii < iterations_; ++ii)
+			op_(ii);
+		return (bench::now_ms() - t0) * 1e6 / iterations_;
+	}
+
+}
+
+int bench_metrics(int argc, char** argv)
+{
+	const int iterations = bench::int_arg(argc, argv, 0, 10000000);
+	const std::string path = argc > 1 ? argv[1] : "sally_metrics.prom";
+
+	System::InitGuard initgrd(true);
+	metrics_registry registry;
+	counter& cnt = registry.add_counter("bench_ops_total", "operations");
+	gauge& gge = registry.add_gauge("bench_level", "current level");
+	histogram& hist = registry.add_histogram("bench_latency_us", "latency", "stage=\"bench\"");
+
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout << "counter add:      " << ns_per_op(iterations, [&](int) { cnt.add(); }) << " ns" << std::endl;
+	std::cout << "gauge set:        " << ns_per_op(iterations, [&](int ii_) { gge.set(ii_); }) << " ns" << std::endl;
+	std::cout << "histogram record: " << ns_per_op(iterations, [&](int ii_) { hist.record(ii_ & 0xffff); }) << " ns" << std::endl;
+
+	// a registry the size of a real one: a few families with a series per window
+	for (int ww = 0; ww < 8; ++ww) {
+		const std::string labels = "window=\"" + std::to_string(ww) + "\"";
+		registry.add_histogram("bench_render_time_us", "render time", labels).record(1000 + ww);
+		registry.add_gauge("bench_texture_bytes", "texture bytes", labels).set(ww << 20);
+	}
+	std::ostringstream text;
+	const double t0 = bench::now_ms();
+	registry.write_prometheus(text);
+	std::cout << "snapshot:         " << (bench::now_ms() - t0) * 1000 << " us, " << text.str().size() << " bytes" << std::endl;
+
+	metrics_exporter exporter(registry, metrics_exporter::TARGET_FILE, path, 60000);
+	std::cout << "file export to " << path << (exporter.export_now() ? " ok" : " failed") << std::endl;
+	return 0;
+}
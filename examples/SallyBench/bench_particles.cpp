@@ -0,0 +1,126 @@
+#include "bench.hpp"
+#include <sally/gfx/particle_emitter.hpp>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+namespace {
+
+	using namespace sally;
+
+	const int DOT_SIZE = 8;
+
+	// a soft white dot, tinted per particle
+	SDL_Surface* make_dot() {
+		SDL_Surface* surf = SDL_CreateRGBSurfaceWithFormat(0, DOT_SIZE, DOT_SIZE, 32, SDL_PIXELFORMAT_ARGB8888);
+		if (!surf)
+			throw sdl_exception("SDL_CreateRGBSurfaceWithFormat failed");
+		Uint32* px = static_cast<Uint32*>(surf->pixels);
+		for (int yy = 0; yy < DOT_SIZE; ++yy)
+			for (int xx = 0; xx < DOT_SIZE; ++xx) {
+				const int dx = 2 * xx + 1 - DOT_SIZE, dy = 2 * yy + 1 - DOT_SIZE;
+				const int alpha = std::max(0, 255 - 255 * (dx * dx + dy * dy) / (DOT_SIZE * DOT_SIZE));
+				px[yy * surf->pitch / 4 + xx] = (Uint32(alpha) << 24) | 0xffffff;
+			}
+		return surf;
+	}
+
+	class particles_scene : public RenderProvider {
+	public:
+		particles_scene(int emitters_, size_t capacity_, bool per_particle_)
+			: _emitters(emitters_), _capacity(capacity_), _per_particle(per_particle_), _submit_ms(0) {}
+
+		virtual void initialize(Window& win_) {
+			SDL_Surface* surf = make_dot();
+			SDL_Texture* tex = win_.renderer().texture_from_surface(surf);
+			SDL_FreeSurface(surf);
+			SDL_SetTextureBlendMode(tex, SDL_BLENDMODE_BLEND);
+			Texture* dot = win_.renderer().insert("dot", new Texture(tex));
+
+			bench::rng rnd;
+			for (int ee = 0; ee < _emitters; ++ee) {
+				ParticleEmitter::Config config;
+				config.capacity = _capacity;
+				config.rate = float(_capacity); // about one second of life keeps the pool near full
+				config.life_min = 0.5f;
+				config.life_max = 1.0f;
+				config.speed_min = 40;
+				config.speed_max = 160;
+				config.gravity_y = 120;
+				config.size_start = 6;
+				config.size_end = 2;
+				config.color_start = Color(255, static_cast<unsigned char>(rnd.range(64, 256)), 32, 255);
+				config.color_end = Color(255, 0, 0, 0);
+				_pool.emplace_back(new ParticleEmitter(dot, config));
+				_pool.back()->set_position(float(rnd.range(0, win_.width())), float(rnd.range(0, win_.height())));
+			}
+		}
+
+		virtual void render(Window& win_) {
+			Renderer& rend = win_.renderer();
+			rend.clear(Color(0, 0, 0));
+			double t0 = bench::now_ms();
+			if (_per_particle)
+				render_per_particle(rend);
+			else
+				for (auto& emitter : _pool)
+					emitter->render(rend);
+			_submit_ms += bench::now_ms() - t0;
+		}
+
+		// what the emitter replaces: one Renderer::render call per particle
+		void render_per_particle(Renderer& rend_) {
+			Renderable* dot = rend_.lookup("dot");
+			for (auto& emitter : _pool)
+				for (size_t ii = 0; ii < emitter->alive(); ++ii) {
+					const int size = int(emitter->size()[ii] + 0.5f);
+					rend_.render(dot, Rect(int(emitter->pos_x()[ii]) - size / 2, int(emitter->pos_y()[ii]) - size / 2, size, size));
+				}
+		}
+
+		std::vector<unique_ptr<ParticleEmitter> >& emitters() { return _pool; }
+		double submit_ms() const { return _submit_ms; }
+
+	private:
+		const int _emitters;
+		const size_t _capacity;
+		const bool _per_particle;
+		std::vector<unique_ptr<ParticleEmitter> > _pool;
+		double _submit_ms;
+	};
+
+}
+
+int bench_particles(int argc, char** argv)
+{
+	const int emitters = std::max(bench::int_arg(argc, argv, 0, 16), 1);
+	const int capacity = std::max(bench::int_arg(argc, argv, 1, 8192), 1);
+	const int frames = bench::int_arg(argc, argv, 2, 300);
+	const bool per_particle = argc > 3 && std::string(argv[3]) == "render";
+
+	System::InitGuard initgrd(true);
+	particles_scene scene(emitters, size_t(capacity), per_particle);
+	Window win("particles", 1920, 1080, Window::FLG_OFFSCREEN, &scene);
+
+	double update_ms = 0, frame_ms = 0;
+	size_t alive = 0;
+	for (int ii = 0; ii < frames; ++ii) {
+		double t0 = bench::now_ms();
+		alive = 0;
+		for (auto& emitter : scene.emitters()) {
+			emitter->update(1.0f / 60);
+			alive += emitter->alive();
+		}
+		double t1 = bench::now_ms();
+		win.render();
+		update_ms += t1 - t0;
+		frame_ms += bench::now_ms() - t1;
+	}
+
+	std::cout << std::fixed << std::setprecision(3)
+		<< emitters << " emitters of " << capacity << " particles, " << alive << " alive in the last frame" << std::endl
+		<< "update: " << update_ms / frames << " ms/frame (" << 1e6 * update_ms / (double(frames) * std::max<size_t>(alive, 1)) << " ns per particle)" << std::endl
+		<< "submit: " << scene.submit_ms() / frames << " ms/frame (" << (per_particle ? "one Renderer::render per particle" : "one render_batch per emitter") << ")" << std::endl
+		<< "frame:  " << frame_ms / frames << " ms/frame (including SDL rasterization)" << std::endl;
+	return 0;
+}
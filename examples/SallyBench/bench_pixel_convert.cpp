@@ -0,0 +1,120 @@
+#include "bench.hpp"
+#include <sally/gfx/pixel_convert.hpp>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+namespace {
+
+	using namespace sally;
+
+	bool check_kernels()
+	{
+		bench::rng rnd(42);
+		bool ok = true;
+		for (size_t count : { 0, 1, 3, 7, 8, 15, 16, 17, 31, 1027 }) {
+			std::vector<uint32_t> src(count), dst(count), ref(count);
+			std::vector<uint8_t> alpha(count);
+			for (size_t ii = 0; ii < count; ++ii) {
+				src[ii] = rnd.next();
+				alpha[ii] = static_cast<uint8_t>(rnd.next());
+			}
+			pixel_kernels::swap_rb(src.data(), dst.data(), count);
+			pixel_kernels::swap_rb_scalar(src.data(), ref.data(), count);
+			ok = ok && dst == ref;
+			pixel_kernels::premultiply(src.data(), dst.data(), count);
+			pixel_kernels::premultiply_scalar(src.data(), ref.data(), count);
+			ok = ok && dst == ref;
+			for (uint32_t color : { 0xff204080u, 0x80ff4020u, 0u }) {
+				pixel_kernels::alpha_to_argb(alpha.data(), dst.data(), count, color);
+				pixel_kernels::alpha_to_argb_scalar(alpha.data(), ref.data(), count, color);
+				ok = ok && dst == ref;
+			}
+		}
+		return ok;
+	}
+
+	// runs fn_ repeatedly over pixels_ pixels, returns M pixels per second
+	template <class F> double mpix_per_s(size_t pixels_, F fn_)
+	{
+		const int reps = 20;
+		fn_(); // warm up
+		double t0 = bench::now_ms();
+		for (int ii = 0; ii < reps; ++ii)
+			fn_();
+		return pixels_ * double(reps) / ((bench::now_ms() - t0) * 1000.0);
+	}
+
+	SDL_Surface* make_image(int width_, int height_, Uint32 format_)
+	{
+		SDL_Surface* surf = SDL_CreateRGBSurfaceWithFormat(0, width_, height_, 32, format_);
+		if (!surf)
+			throw sdl_exception("SDL_CreateRGBSurfaceWithFormat failed");
+		bench::rng rnd;
+		for (int y = 0; y < height_; ++y) {
+			uint32_t* row = reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(surf->pixels) + y * surf->pitch);
+			for (int x = 0; x < width_; ++x)
+				row[x] = rnd.next();
+		}
+		return surf;
+	}
+
+}
+
+int bench_pixel_convert(int argc, char** argv)
+{
+	const int width = bench::int_arg(argc, argv, 0, 4096);
+	const int height = bench::int_arg(argc, argv, 1, 4096);
+	const int uploads = bench::int_arg(argc, argv, 2, 10);
+
+	std::cout << "kernels: " << pixel_kernels::isa() << ", simd == scalar: " << (check_kernels() ? "yes" : "NO") << std::endl;
+
+	const size_t count = size_t(width) * height;
+	std::vector<uint32_t> src(count), dst(count);
+	std::vector<uint8_t> alpha(count);
+	bench::rng rnd;
+	for (size_t ii = 0; ii < count; ++ii) {
+		src[ii] = rnd.next();
+		alpha[ii] = static_cast<uint8_t>(src[ii] >> 7);
+	}
+	std::cout << std::fixed << std::setprecision(0)
+		<< "swap_rb:       " << mpix_per_s(count, [&]() { pixel_kernels::swap_rb(src.data(), dst.data(), count); }) << " Mpix/s, scalar "
+		<< mpix_per_s(count, [&]() { pixel_kernels::swap_rb_scalar(src.data(), dst.data(), count); }) << " Mpix/s" << std::endl
+		<< "premultiply:   " << mpix_per_s(count, [&]() { pixel_kernels::premultiply(src.data(), dst.data(), count); }) << " Mpix/s, scalar "
+		<< mpix_per_s(count, [&]() { pixel_kernels::premultiply_scalar(src.data(), dst.data(), count); }) << " Mpix/s" << std::endl
+		<< "alpha_to_argb: " << mpix_per_s(count, [&]() { pixel_kernels::alpha_to_argb(alpha.data(), dst.data(), count, 0xff204080); }) << " Mpix/s, scalar "
+		<< mpix_per_s(count, [&]() { pixel_kernels::alpha_to_argb_scalar(alpha.data(), dst.data(), count, 0xff204080); }) << " Mpix/s" << std::endl;
+
+	// texture creation for a large image, SDL's generic path against the native format upload:
+	System::InitGuard initgrd(true);
+	Window win("pixel_convert", 64, 64, Window::FLG_OFFSCREEN, nullptr);
+	Renderer& rend = win.renderer();
+	// the offscreen window renders with SDL's software renderer, the reference uses another one
+	SDL_Surface* target = SDL_CreateRGBSurfaceWithFormat(0, 64, 64, 32, SDL_PIXELFORMAT_ARGB8888);
+	SDL_Renderer* sdl_rend = target ? SDL_CreateSoftwareRenderer(target) : nullptr;
+	if (!sdl_rend)
+		throw sdl_exception("failed creating SDL software renderer reference");
+	std::cout << "renderer native format: " << SDL_GetPixelFormatName(rend.native_format()) << std::endl;
+	for (Uint32 format : { Uint32(SDL_PIXELFORMAT_ARGB8888), Uint32(SDL_PIXELFORMAT_ABGR8888) }) {
+		SDL_Surface* image = make_image(width, height, format);
+		double t0 = bench::now_ms();
+		for (int ii = 0; ii < uploads; ++ii)
+			SDL_DestroyTexture(SDL_CreateTextureFromSurface(sdl_rend, image));
+		const double sdl_ms = (bench::now_ms() - t0) / uploads;
+		t0 = bench::now_ms();
+		for (int ii = 0; ii < uploads; ++ii)
+			Renderer::destroy_texture(rend.texture_from_surface(image));
+		const double native_ms = (bench::now_ms() - t0) / uploads;
+		t0 = bench::now_ms();
+		for (int ii = 0; ii < uploads; ++ii)
+			Renderer::destroy_texture(rend.texture_from_surface(image, true));
+		const double premul_ms = (bench::now_ms() - t0) / uploads;
+		std::cout << std::setprecision(2) << SDL_GetPixelFormatName(format) << " " << width << "x" << height
+			<< ": SDL_CreateTextureFromSurface " << sdl_ms << " ms, texture_from_surface " << native_ms
+			<< " ms (x" << sdl_ms / native_ms << "), premultiplied " << premul_ms << " ms" << std::endl;
+		SDL_FreeSurface(image);
+	}
+	SDL_DestroyRenderer(sdl_rend);
+	SDL_FreeSurface(target);
+	return 0;
+}
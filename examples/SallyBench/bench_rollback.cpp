@@ -0,0 +1,125 @@
+#include "bench.hpp"
+#include <sally/net/rollback.hpp>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+	using namespace sally;
+
+	// deterministic toy simulation whose snapshot and tick cost grow with the state size
+	class mix_game : public RollbackGame {
+	public:
+		explicit mix_game(int words_) : _state(words_, 1) {}
+
+		virtual size_t state_size() const { return _state.size() * sizeof(uint32_t); }
+		virtual void save_state(void* dst_) const { std::memcpy(dst_, _state.data(), state_size()); }
+		virtual void load_state(const void* src_) { std::memcpy(_state.data(), src_, state_size()); }
+
+		virtual void advance(input_t input0_, input_t input1_) {
+			uint32_t carry = (uint32_t(input0_) << 16) | input1_;
+			for (uint32_t& word : _state) {
+				word = (word ^ carry) * 16777619u;
+				carry = word >> 7;
+			}
+		}
+
+		virtual input_t on_local_key(const keyboard_event&, input_t input_) { return input_; }
+
+		bool operator==(const mix_game& other_) const { return _state == other_._state; }
+
+	private:
+		std::vector<uint32_t> _state;
+	};
+
+	// a held input which changes every few ticks, like a player steering
+	class bot {
+	public:
+		explicit bot(uint32_t seed_) : _rnd(seed_), _input(0), _hold(0) {}
+		RollbackGame::input_t next() {
+			if (--_hold <= 0) {
+				_input = static_cast<RollbackGame::input_t>(_rnd.next() & 0xf);
+				_hold = _rnd.range(2, 20);
+			}
+			return _input;
+		}
+	private:
+		bench::rng _rnd;
+		RollbackGame::input_t _input;
+		int _hold;
+	};
+
+}
+
+// two sessions in one process talking over loopback. each one ticks lag ticks in a row
+// before the other, so remote input arrives lag ticks late and every change is mispredicted.
+int bench_rollback(int argc, char** argv)
+{
+	const int ticks = std::max(bench::int_arg(argc, argv, 0, 3000), 1);
+	const int words = std::max(bench::int_arg(argc, argv, 1, 1024), 1);
+	const int lag = std::min(std::max(bench::int_arg(argc, argv, 2, 3), 1), 6);
+	const int drop = bench::int_arg(argc, argv, 3, 10);
+
+	System::InitGuard initgrd(true);
+	mix_game game0(words), game1(words);
+	uint16_t port0, port1;
+	{ // two free ports, released again for the sessions
+		UdpSocket probe0, probe1;
+		port0 = probe0.port();
+		port1 = probe1.port();
+	}
+
+	RollbackSession::Config config0, config1;
+	config0.local_player = 0;
+	config0.local_port = port0;
+	config0.remote = NetAddress::loopback(port1);
+	config0.drop_percent = drop;
+	config1 = config0;
+	config1.local_player = 1;
+	config1.local_port = port1;
+	config1.remote = NetAddress::loopback(port0);
+	RollbackSession session0(game0, config0), session1(game1, config1);
+
+	bot bot0(1), bot1(2);
+	double max_resim_us = 0;
+	const double start = bench::now_ms();
+	for (int tt = 0; tt < ticks; tt += lag) {
+		for (int ll = 0; ll < lag; ++ll) {
+			session0.add_local_input(bot0.next());
+			session0.tick();
+			max_resim_us = std::max(max_resim_us, session0.last_frame().resim_us);
+		}
+		for (int ll = 0; ll < lag; ++ll) {
+			session1.add_local_input(bot1.next());
+			session1.tick();
+			max_resim_us = std::max(max_resim_us, session1.last_frame().resim_us);
+		}
+	}
+	const double ms = bench::now_ms() - start;
+
+	// both players let go: once each side has the other's first idle input the rest is
+	// predicted correctly, so both states must match at the same frame
+	const int32_t idle_from = std::max(session0.frame(), session1.frame());
+	bool same = false;
+	for (int ii = 0; ii < 50 * RollbackSession::MAX_PREDICTION && !same; ++ii) {
+		const int32_t frame0 = session0.frame(), frame1 = session1.frame();
+		if (frame0 <= frame1)
+			session0.tick();
+		if (frame1 <= frame0)
+			session1.tick();
+		same = session0.frame() == session1.frame() && session0.confirmed_frame() > idle_from
+			&& session1.confirmed_frame() > idle_from && game0 == game1;
+	}
+
+	const int frames = session0.frame();
+	std::cout << frames << " ticks of " << words * 4 << " byte state, " << lag << " ticks of latency, " << drop << "% loss: "
+		<< ms * 1000.0 / (2.0 * frames) << " us per tick and session" << std::endl;
+	std::cout << "  rollbacks: " << session0.rollbacks() << ", " << double(session0.rollback_frames()) / frames << " re-simulated ticks per tick, depth p50 "
+		<< session0.rollback_depth().percentile(50) << " max " << session0.rollback_depth().max() << std::endl;
+	std::cout << "  re-simulation us: p50 " << session0.resim_time().percentile(50) << " p99 " << session0.resim_time().percentile(99)
+		<< " max " << max_resim_us << std::endl;
+	std::cout << "  bandwidth: " << double(session0.bytes_sent()) / frames << " bytes sent and " << double(session0.bytes_received()) / frames
+		<< " received per tick, " << session0.stalls() << " stalls" << std::endl;
+	std::cout << "  states " << (same ? "match" : "DIFFER") << ", " << session0.desyncs() + session1.desyncs() << " checksum mismatches" << std::endl;
+	return same ? 0 : 1;
+}
@@ -0,0 +1,42 @@
+#include "bench.hpp"
+#include "../SlidingPawn/pawn_game.hpp"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+int bench_search(int argc, char** argv)
+{
+	const int positions = bench::int_arg(argc, argv, 0, 200);
+	const int budget_ms = bench::int_arg(argc, argv, 1, 20); // per position
+	const int max_threads = bench::int_arg(argc, argv, 2, SDL_GetCPUCount());
+
+	typedef pawn_game<8, 8> game_t;
+	game_t game;
+
+	// random positions, opponent to move (like sliding_pawn asks):
+	bench::rng rnd;
+	std::vector<game_t::Position> roots;
+	while (static_cast<int>(roots.size()) < positions) {
+		int px = rnd.range(0, 8), py = rnd.range(0, 8), ox = rnd.range(0, 8), oy = rnd.range(0, 8);
+		if (px != ox || py != oy)
+			roots.push_back(game_t::Position(px, py, ox, oy, true));
+	}
+
+	std::cout << std::fixed << std::setprecision(1);
+	for (int threads = 1; threads <= max_threads; threads *= 2) {
+		sally::ai::Search<game_t> search(game, threads, 16);
+		uint64_t nodes = 0, ms = 0, depth = 0;
+		int decided = 0;
+		for (const game_t::Position& root : roots) {
+			sally::ai::Search<game_t>::Result res = search.run(root, budget_ms);
+			nodes += res._nodes;
+			ms += res._ms;
+			depth += res._depth;
+			decided += sally::ai::is_mate_score(res._score);
+		}
+		std::cout << threads << " thread(s): " << nodes << " nodes in " << ms << " ms, "
+			<< (ms ? nodes * 1000.0 / ms : 0.0) << " nodes/s, average depth " << double(depth) / positions
+			<< ", " << decided << "/" << positions << " positions solved" << std::endl;
+	}
+	return 0;
+}
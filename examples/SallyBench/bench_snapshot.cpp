@@ -0,0 +1,138 @@
+#include "bench.hpp"
+#include <sally/gfx/snapshot_render_provider.hpp>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+
+namespace {
+
+	using namespace sally;
+
+	// scene state written by a producer thread, every object must have _a == _b when drawn
+	struct scene_state {
+		struct object { int _a, _b; };
+		std::vector<object> _objects;
+		scene_state() : _objects(1000) {}
+	};
+
+	const int PRESENT_MS = 8; // stands in for drawing and the vsync wait of a real frame
+
+	int check_torn(const scene_state& state_)
+	{
+		for (const scene_state::object& obj : state_._objects)
+			if (obj._a != obj._b)
+				return 1;
+		return 0;
+	}
+
+	void update(scene_state& state_, int step_)
+	{
+		for (scene_state::object& obj : state_._objects) {
+			obj._a = step_;
+			obj._b = step_;
+		}
+	}
+
+	class locked_scene : public RenderProvider {
+	public:
+		locked_scene() : _torn(0) {}
+		virtual void render(Window&) {
+			_torn += check_torn(_state);
+			SDL_Delay(PRESENT_MS);
+		}
+		scene_state _state;
+		int _torn;
+	};
+
+	class snapshot_scene : public SnapshotRenderProvider<scene_state> {
+	public:
+		snapshot_scene() : _torn(0) {}
+		virtual void render_snapshot(Window&, const scene_state& state_) {
+			_torn += check_torn(state_);
+			SDL_Delay(PRESENT_MS);
+		}
+		int _torn;
+	};
+
+	struct producer {
+		RenderProvider* _locked;              // lock this provider around updates (or nullptr)
+		scene_state* _state;                  // updated in place when locked
+		snapshot_scene* _snapshot;            // otherwise published through this
+		int _updates;
+		std::vector<double> _waits_ms;        // time each update took, including waiting for the lock
+		SDL_atomic_t _done;
+
+		producer(RenderProvider* locked_, scene_state* state_, snapshot_scene* snapshot_, int updates_)
+			: _locked(locked_), _state(state_), _snapshot(snapshot_), _updates(updates_), _done({ 0 })
+		{ _waits_ms.reserve(updates_); }
+
+		static int main(void* self_) {
+			producer& self = *static_cast<producer*>(self_);
+			for (int ii = 1; ii <= self._updates; ++ii) {
+				const double t0 = bench::now_ms();
+				if (self._locked) {
+					RenderProvider::Guard lg(*self._locked);
+					update(*self._state, ii);
+				}
+				else {
+					update(self._snapshot->back(), ii);
+					self._snapshot->publish();
+				}
+				self._waits_ms.push_back(bench::now_ms() - t0);
+				SDL_Delay(1);
+			}
+			SDL_AtomicSet(&self._done, 1);
+			return 0;
+		}
+	};
+
+	void report(const char* name_, producer& prod_, int frames_, int torn_)
+	{
+		std::vector<double>& waits = prod_._waits_ms;
+		std::sort(waits.begin(), waits.end());
+		double sum = 0;
+		for (double w : waits)
+			sum += w;
+		std::cout << std::fixed << std::setprecision(3) << name_ << ": producer update avg " << sum / waits.size()
+			<< " ms, p99 " << waits[waits.size() * 99 / 100] << " ms, max " << waits.back() << " ms; "
+			<< frames_ << " frames, " << torn_ << " torn" << std::endl;
+	}
+
+	int render_while_producing(Window& win_, producer& prod_)
+	{
+		SDL_Thread* thread = SDL_CreateThread(&producer::main, "bench_producer", &prod_);
+		if (!thread)
+			throw sdl_exception("SDL_CreateThread failed");
+		int frames = 0, status = 0;
+		while (SDL_AtomicGet(&prod_._done) == 0) {
+			win_.render();
+			++frames;
+		}
+		SDL_WaitThread(thread, &status);
+		return frames;
+	}
+
+}
+
+int bench_snapshot(int argc, char** argv)
+{
+	const int updates = bench::int_arg(argc, argv, 0, 500);
+
+	System::InitGuard initgrd(true);
+	{
+		locked_scene scene;
+		Window win("locked", 64, 64, Window::FLG_OFFSCREEN, &scene);
+		producer prod(&scene, &scene._state, nullptr, updates);
+		const int frames = render_while_producing(win, prod);
+		report("locked RenderProvider", prod, frames, scene._torn);
+	}
+	{
+		snapshot_scene scene;
+		Window win("snapshot", 64, 64, Window::FLG_OFFSCREEN, &scene);
+		producer prod(nullptr, nullptr, &scene, updates);
+		const int frames = render_while_producing(win, prod);
+		report("SnapshotRenderProvider", prod, frames, scene._torn);
+	}
+	return 0;
+}
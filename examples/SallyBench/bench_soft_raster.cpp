@@ -0,0 +1,174 @@
+#include "bench.hpp"
+#include <sally/gfx/soft_raster.hpp>
+#include <sally/util/worker_pool.hpp>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+
+namespace {
+
+	using namespace sally;
+
+	struct scene_draw {
+		enum { FILL, BLEND_FILL, BLIT } _type;
+		Rect _dst;
+		Color _color;
+	};
+
+	// procedural sprite: opaque center fading to transparent edges
+	SDL_Surface* make_sprite(int size_)
+	{
+		SDL_Surface* surf = SDL_CreateRGBSurfaceWithFormat(0, size_, size_, 32, SDL_PIXELFORMAT_ARGB8888);
+		if (!surf)
+			throw sdl_exception("SDL_CreateRGBSurfaceWithFormat failed");
+		for (int y = 0; y < size_; ++y) {
+			uint32_t* row = reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(surf->pixels) + y * surf->pitch);
+			for (int x = 0; x < size_; ++x) {
+				int dx = 2 * x - size_, dy = 2 * y - size_;
+				int a = std::max(0, 255 - 255 * (dx * dx + dy * dy) / (size_ * size_));
+				row[x] = (uint32_t(a) << 24) | (uint32_t(x * 255 / size_) << 16) | (uint32_t(y * 255 / size_) << 8) | 0x80;
+			}
+		}
+		return surf;
+	}
+
+	std::vector<scene_draw> make_scene(int width_, int height_)
+	{
+		bench::rng rnd;
+		std::vector<scene_draw> scene;
+		for (int ii = 0; ii < 3000; ++ii) {
+			scene_draw d;
+			d._type = static_cast<decltype(d._type)>(ii % 3);
+			int w = rnd.range(16, 160), h = rnd.range(16, 160);
+			d._dst = Rect(rnd.range(-w, width_), rnd.range(-h, height_), w, h);
+			d._color = Color(rnd.next() & 0xff, rnd.next() & 0xff, rnd.next() & 0xff, d._type == scene_draw::BLEND_FILL ? rnd.range(16, 240) : 255);
+			scene.push_back(d);
+		}
+		return scene;
+	}
+
+	void draw_soft(SoftRaster& raster_, const std::vector<scene_draw>& scene_, SDL_Surface* sprite_)
+	{
+		raster_.clear(0xff202020);
+		for (const scene_draw& d : scene_)
+			switch (d._type) {
+			case scene_draw::FILL: raster_.fill_rect(d._dst, SoftRaster::argb(d._color), false); break;
+			case scene_draw::BLEND_FILL: raster_.fill_rect(d._dst, SoftRaster::argb(d._color), true); break;
+			case scene_draw::BLIT: raster_.blit(sprite_, Rect(0, 0, sprite_->w, sprite_->h), d._dst, true); break;
+			}
+	}
+
+	void draw_sdl(SDL_Renderer* rend_, SDL_Texture* sprite_, const std::vector<scene_draw>& scene_)
+	{
+		SDL_SetRenderDrawBlendMode(rend_, SDL_BLENDMODE_NONE);
+		SDL_SetRenderDrawColor(rend_, 0x20, 0x20, 0x20, 0xff);
+		SDL_RenderClear(rend_);
+		for (const scene_draw& d : scene_) {
+			SDL_SetRenderDrawBlendMode(rend_, d._type == scene_draw::BLEND_FILL ? SDL_BLENDMODE_BLEND : SDL_BLENDMODE_NONE);
+			SDL_SetRenderDrawColor(rend_, d._color._r, d._color._g, d._color._b, d._color._a);
+			if (d._type == scene_draw::BLIT)
+				SDL_RenderCopy(rend_, sprite_, nullptr, &d._dst.sdl_rect());
+			else
+				SDL_RenderFillRect(rend_, &d._dst.sdl_rect());
+		}
+		SDL_RenderFlush(rend_);
+	}
+
+	bool check_kernels()
+	{
+		bench::rng rnd(42);
+		std::vector<uint32_t> src(1027), dst(src.size()), ref;
+		for (size_t ii = 0; ii < src.size(); ++ii) {
+			src[ii] = rnd.next();
+			dst[ii] = rnd.next();
+		}
+		ref = dst;
+		soft_kernels::blend_row(dst.data(), src.data(), static_cast<int>(dst.size()));
+		soft_kernels::blend_row_scalar(ref.data(), src.data(), static_cast<int>(ref.size()));
+		bool ok = dst == ref;
+		soft_kernels::blend_color_row(dst.data(), static_cast<int>(dst.size()), 0x80ff4020);
+		soft_kernels::blend_color_row_scalar(ref.data(), static_cast<int>(ref.size()), 0x80ff4020);
+		ok = ok && dst == ref;
+		soft_kernels::modulate_row(dst.data(), src.data(), static_cast<int>(dst.size()), 0xc0ff8010);
+		soft_kernels::modulate_row_scalar(ref.data(), src.data(), static_cast<int>(ref.size()), 0xc0ff8010);
+		return ok && dst == ref;
+	}
+
+}
+
+int bench_soft_raster(int argc, char** argv)
+{
+	const int width = bench::int_arg(argc, argv, 0, 1920);
+	const int height = bench::int_arg(argc, argv, 1, 1080);
+	const int frames = bench::int_arg(argc, argv, 2, 60);
+
+	std::cout << "kernels: " << soft_kernels::isa() << ", simd == scalar: " << (check_kernels() ? "yes" : "NO") << std::endl;
+
+	SDL_Surface* sprite = make_sprite(64);
+	const std::vector<scene_draw> scene = make_scene(width, height);
+
+	// SDL software renderer reference:
+	SDL_Surface* ref = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_ARGB8888);
+	SDL_Renderer* sdl_rend = ref ? SDL_CreateSoftwareRenderer(ref) : nullptr;
+	SDL_Texture* sdl_sprite = sdl_rend ? SDL_CreateTextureFromSurface(sdl_rend, sprite) : nullptr;
+	if (!sdl_sprite)
+		throw sdl_exception("failed creating SDL software renderer reference");
+	SDL_SetTextureBlendMode(sdl_sprite, SDL_BLENDMODE_BLEND);
+
+	double t0 = bench::now_ms();
+	for (int ii = 0; ii < frames; ++ii)
+		draw_sdl(sdl_rend, sdl_sprite, scene);
+	double sdl_ms = (bench::now_ms() - t0) / frames;
+	std::cout << std::fixed << std::setprecision(2)
+		<< "SDL software renderer: " << sdl_ms << " ms/frame" << std::endl;
+
+	// scaling with thread count:
+	SoftRaster raster(width, height);
+	double single_ms = 0;
+	const int cores = std::max(SDL_GetCPUCount(), 1);
+	for (int threads = 1; ; threads = std::min(threads * 2, cores)) {
+		worker_pool pool(threads - 1);
+		draw_soft(raster, scene, sprite); // warm up
+		raster.flush(pool);
+		t0 = bench::now_ms();
+		for (int ii = 0; ii < frames; ++ii) {
+			draw_soft(raster, scene, sprite);
+			raster.flush(pool);
+		}
+		double ms = (bench::now_ms() - t0) / frames;
+		if (threads == 1)
+			single_ms = ms;
+		std::cout << "SoftRaster " << std::setw(2) << pool.concurrency() << " threads: " << ms << " ms/frame"
+			<< "  speedup x" << single_ms / ms << "  vs SDL x" << sdl_ms / ms << std::endl;
+		if (threads == cores)
+			break;
+	}
+
+	// parity with the SDL software renderer, blend rounding may differ by a couple of levels
+	// while scaled blits may sample a neighbouring texel along sprite edges:
+	const int TOLERANCE = 2;
+	size_t diff_pixels = 0, mismatched_pixels = 0;
+	for (int y = 0; y < height; ++y) {
+		const uint32_t* a = raster.pixels() + size_t(y) * width;
+		const uint32_t* b = reinterpret_cast<const uint32_t*>(static_cast<uint8_t*>(ref->pixels) + y * ref->pitch);
+		for (int x = 0; x < width; ++x)
+			if (a[x] != b[x]) {
+				++diff_pixels;
+				int diff = 0;
+				for (int c = 0; c < 24; c += 8)
+					diff = std::max(diff, std::abs(int((a[x] >> c) & 0xff) - int((b[x] >> c) & 0xff)));
+				if (diff > TOLERANCE)
+					++mismatched_pixels;
+			}
+	}
+	const double mismatched_pct = 100.0 * mismatched_pixels / (double(width) * height);
+	std::cout << "parity: " << diff_pixels << " pixels differ, " << mismatched_pixels
+		<< " beyond tolerance (" << mismatched_pct << "%)" << std::endl;
+
+	SDL_DestroyTexture(sdl_sprite);
+	SDL_DestroyRenderer(sdl_rend);
+	SDL_FreeSurface(ref);
+	SDL_FreeSurface(sprite);
+	return mismatched_pct < 1.0 ? 0 : 1;
+}
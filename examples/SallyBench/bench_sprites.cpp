@@ -0,0 +1,93 @@
+#include "bench.hpp"
+#include <sally/gfx/sprite_system.hpp>
+#include <sally/util/worker_pool.hpp>
+#include <iostream>
+#include <iomanip>
+
+namespace {
+
+	using namespace sally;
+
+	const int FRAME_SIZE = 16;
+	const int FRAMES = 8;
+
+	// FRAMES frames in a 4 column atlas, a square growing frame by frame
+	SDL_Surface* make_atlas() {
+		SDL_Surface* surf = SDL_CreateRGBSurfaceWithFormat(0, 4 * FRAME_SIZE, (FRAMES / 4) * FRAME_SIZE, 32, SDL_PIXELFORMAT_ARGB8888);
+		if (!surf)
+			throw sdl_exception("SDL_CreateRGBSurfaceWithFormat failed");
+		SDL_FillRect(surf, nullptr, 0);
+		for (int ff = 0; ff < FRAMES; ++ff) {
+			int inset = FRAMES - 1 - ff;
+			SDL_Rect rc = { (ff % 4) * FRAME_SIZE + inset, (ff / 4) * FRAME_SIZE + inset, FRAME_SIZE - 2 * inset, FRAME_SIZE - 2 * inset };
+			SDL_FillRect(surf, &rc, 0xffffffff);
+		}
+		return surf;
+	}
+
+	class sprites_scene : public RenderProvider {
+	public:
+		sprites_scene() : _sprites(nullptr), _submit_ms(0) {}
+
+		virtual void initialize(Window& win_) {
+			SDL_Surface* surf = make_atlas();
+			Texture* atlas = win_.renderer().insert("atlas", new Texture(win_.renderer().texture_from_surface(surf)));
+			SDL_FreeSurface(surf);
+			_sprites.reset(new SpriteSystem(atlas, FRAME_SIZE, FRAME_SIZE));
+			_sprites->set_wrap(Rect(-FRAME_SIZE, -FRAME_SIZE, win_.width() + FRAME_SIZE, win_.height() + FRAME_SIZE));
+		}
+
+		virtual void render(Window& win_) {
+			win_.renderer().clear(Color(0, 0, 0));
+			double t0 = bench::now_ms();
+			_sprites->render(win_.renderer());
+			_submit_ms += bench::now_ms() - t0;
+		}
+
+		SpriteSystem& sprites() { return *_sprites; }
+		double submit_ms() const { return _submit_ms; }
+
+	private:
+		unique_ptr<SpriteSystem> _sprites;
+		double _submit_ms;
+	};
+
+}
+
+int bench_sprites(int argc, char** argv)
+{
+	const int count = bench::int_arg(argc, argv, 0, 100000);
+	const int frames = bench::int_arg(argc, argv, 1, 300);
+	const int threads = bench::int_arg(argc, argv, 2, 0); // extra update threads, 0 updates on this thread only
+
+	System::InitGuard initgrd(true);
+	sprites_scene scene;
+	Window win("sprites", 1920, 1080, Window::FLG_OFFSCREEN, &scene);
+
+	bench::rng rnd;
+	SpriteSystem& sprites = scene.sprites();
+	sprites.reserve(count);
+	for (int ii = 0; ii < count; ++ii)
+		sprites.add(float(rnd.range(0, win.width())), float(rnd.range(0, win.height())),
+			float(rnd.range(-200, 200)), float(rnd.range(-200, 200)),
+			0, FRAMES, float(rnd.range(4, 30)),
+			Color(rnd.range(64, 256), rnd.range(64, 256), rnd.range(64, 256)), static_cast<uint8_t>(rnd.range(0, 4)));
+
+	unique_ptr<worker_pool> pool(threads > 0 ? new worker_pool(threads) : nullptr);
+	double update_ms = 0, frame_ms = 0;
+	for (int ii = 0; ii < frames; ++ii) {
+		double t0 = bench::now_ms();
+		sprites.update(1.0f / 60, pool.get());
+		double t1 = bench::now_ms();
+		win.render();
+		update_ms += t1 - t0;
+		frame_ms += bench::now_ms() - t1;
+	}
+
+	std::cout << std::fixed << std::setprecision(3)
+		<< count << " sprites, " << sprites.drawn() << " drawn in last frame, " << (pool ? pool->concurrency() : 1) << " update thread(s)" << std::endl
+		<< "update: " << update_ms / frames << " ms/frame" << std::endl
+		<< "submit: " << scene.submit_ms() / frames << " ms/frame (cull, sort, one render_batch)" << std::endl
+		<< "frame:  " << frame_ms / frames << " ms/frame (including SDL rasterization)" << std::endl;
+	return 0;
+}
@@ -0,0 +1,52 @@
+#include "bench.hpp"
+#include "../SlidingPawn/pawn_tablebase.hpp"
+#include <iostream>
+#include <iomanip>
+
+int bench_tablebase(int argc, char** argv)
+{
+	using namespace sally;
+
+	const int width = bench::int_arg(argc, argv, 0, 8);
+	const int height = bench::int_arg(argc, argv, 1, 8);
+	const char* path = argc > 2 ? argv[2] : "sliding_pawn_bench.tb";
+
+	pawn_tablebase_game game(width, height);
+	ai::TablebaseGenerator<pawn_tablebase_game> gen(game);
+	const ai::TablebaseGenerator<pawn_tablebase_game>::Stats& stats = gen.generate(worker_pool::shared());
+
+	const double scanned = double(stats._positions) * (stats._passes + 1);
+	std::cout << std::fixed << std::setprecision(1)
+		<< width << "x" << height << ": " << stats._positions << " positions (" << stats._positions / (1024.0 * 1024) << " MB), "
+		<< stats._decided << " decided, " << stats._passes << " passes" << (stats._truncated ? " (truncated)" : "") << std::endl
+		<< "generated in " << stats._ms << " ms on " << worker_pool::shared().concurrency() << " threads, "
+		<< (stats._ms ? scanned / stats._ms / 1000 : 0.0) << " M positions scanned/s" << std::endl;
+
+	const int32_t params[] = { width, height };
+	double t0 = bench::now_ms();
+	gen.write(path, params, 2);
+	std::cout << "written to " << path << " in " << bench::now_ms() - t0 << " ms" << std::endl;
+
+	// probe every position through the mapping and check it matches the generator
+	ai::Tablebase tb(path);
+	bench::rng rnd;
+	const int probes = 1000000;
+	size_t mismatches = 0, sum = 0;
+	t0 = bench::now_ms();
+	for (int ii = 0; ii < probes; ++ii) {
+		size_t index = (size_t(rnd.next()) << 16 ^ rnd.next()) % tb.positions();
+		uint8_t val = tb.value(index);
+		sum += val;
+		mismatches += val != gen.value(index);
+	}
+	std::cout << std::setprecision(3) << "probe: " << (bench::now_ms() - t0) * 1e6 / probes << " ns, "
+		<< mismatches << " mismatches (checksum " << sum << ")" << std::endl;
+
+	// the start position of sliding_pawn, opponent to move:
+	if (width >= 8 && height >= 8) {
+		uint8_t val = tb.value(game.index(3, 6, 4, 1, true));
+		std::cout << "start position: " << (val == ai::Tablebase::DRAW ? "draw" : (ai::Tablebase::wins(val) ? "opponent wins" : "opponent loses"))
+			<< (val == ai::Tablebase::DRAW ? "" : " in " + std::to_string(val) + " plies") << std::endl;
+	}
+	return mismatches ? 1 : 0;
+}
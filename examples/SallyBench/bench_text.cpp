@@ -0,0 +1,50 @@
+#include "bench.hpp"
+#include <iostream>
+#include <iomanip>
+
+namespace {
+
+	using namespace sally;
+
+	// a frame counter label rendered every frame, returns ms per frame
+	double run_counter(Renderer& rend_, TextLine& label_, int frames_, size_t& pixels_)
+	{
+		pixels_ = 0;
+		double t0 = bench::now_ms();
+		for (int ii = 0; ii < frames_; ++ii) {
+			rend_.begin_render();
+			label_.set_text("frame " + std::to_string(100000 + ii) + "  fps 60.0");
+			rend_.render(&label_, 10, 10);
+			rend_.end_render();
+			pixels_ += label_.last_update_pixels();
+		}
+		return (bench::now_ms() - t0) / frames_;
+	}
+
+}
+
+int bench_text(int argc, char** argv)
+{
+	const int frames = bench::int_arg(argc, argv, 0, 2000);
+	const int size = bench::int_arg(argc, argv, 1, 24);
+
+	System::InitGuard initgrd(true);
+	const std::string path = argc > 2 ? argv[2] : System::resouce_path("examples/SlidingPawn/sample.ttf");
+	Font* font = System::font_manger().load_font("bench", path, size);
+	Window win("text", 640, 480, Window::FLG_OFFSCREEN, nullptr);
+	Renderer& rend = win.renderer();
+
+	std::cout << std::fixed << std::setprecision(4);
+	for (Font::render_mode_t mode : { Font::RENDER_SOLID, Font::RENDER_BLENDED }) {
+		TextLine recreate(font, Color(0, 0, 0), "", mode, TextLine::UPDATE_RECREATE);
+		TextLine streaming(font, Color(0, 0, 0), "", mode, TextLine::UPDATE_STREAMING);
+		size_t pixels = 0;
+		const double recreate_ms = run_counter(rend, recreate, frames, pixels);
+		const double streaming_ms = run_counter(rend, streaming, frames, pixels);
+		std::cout << (mode == Font::RENDER_SOLID ? "solid:   " : "blended: ")
+			<< "recreate " << recreate_ms << " ms/frame, streaming " << streaming_ms << " ms/frame (x" << recreate_ms / streaming_ms << "), "
+			<< std::setprecision(0) << double(pixels) / frames << " of " << streaming.width() * streaming.height()
+			<< " pixels written per frame" << std::setprecision(4) << std::endl;
+	}
+	return 0;
+}
@@ -0,0 +1,73 @@
+#include "bench.hpp"
+#include <sally/gfx/tile_map.hpp>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+namespace {
+
+	using namespace sally;
+
+	class tile_map_scene : public RenderProvider {
+	public:
+		tile_map_scene(int map_size_)
+			: _map(map_size_, map_size_, 16, 16, palette()), _scroll(0)
+		{
+			// noisy terrain, every chunk is allocated:
+			bench::rng rnd;
+			for (int y = 0; y < map_size_; ++y)
+				for (int x = 0; x < map_size_; ++x)
+					_map.set(x, y, static_cast<TileMap::tile_t>(1 + (rnd.next() & 7)));
+		}
+
+		virtual void render(Window& win_) {
+			Renderer& rend = win_.renderer();
+			rend.clear(Color(0, 0, 0));
+			_map.render(rend, rend.output_rect(), _scroll, _scroll / 2);
+			_scroll += 7;
+		}
+
+		TileMap& map() { return _map; }
+
+	private:
+		static std::vector<Color> palette() {
+			std::vector<Color> colors;
+			for (int ii = 0; ii < 8; ++ii)
+				colors.push_back(Color(ii * 32, 255 - ii * 32, (ii * 97) & 0xff));
+			return colors;
+		}
+
+		TileMap _map;
+		int _scroll;
+	};
+
+}
+
+int bench_tile_map(int argc, char** argv)
+{
+	const int map_size = bench::int_arg(argc, argv, 0, 10000);
+	const int frames = bench::int_arg(argc, argv, 1, 600);
+	const int width = bench::int_arg(argc, argv, 2, 1920);
+	const int height = bench::int_arg(argc, argv, 3, 1080);
+
+	System::InitGuard initgrd(true);
+
+	double t0 = bench::now_ms();
+	tile_map_scene scene(map_size);
+	std::cout << std::fixed << std::setprecision(2)
+		<< "filled " << map_size << "x" << map_size << " map in " << bench::now_ms() - t0 << " ms" << std::endl;
+
+	Window win("tile_map", width, height, Window::FLG_OFFSCREEN, &scene);
+	t0 = bench::now_ms();
+	for (int ii = 0; ii < frames; ++ii)
+		win.render();
+	double ms = (bench::now_ms() - t0) / frames;
+
+	const TileMap::Stats& stats = scene.map().stats();
+	const double raw_mb = double(map_size) * map_size * sizeof(TileMap::tile_t) / (1024 * 1024);
+	std::cout << "scrolling: " << ms << " ms/frame, " << double(stats._chunks_drawn) / frames << " chunks drawn/frame, "
+		<< stats._bakes << " chunk bakes" << std::endl
+		<< "memory: raw tiles " << raw_mb << " MB, tile chunks " << stats._tile_bytes / (1024.0 * 1024) << " MB, "
+		<< stats._baked_chunks << " baked chunks " << stats._texture_bytes / (1024.0 * 1024) << " MB" << std::endl;
+	return 0;
+}
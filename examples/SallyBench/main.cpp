@@ -0,0 +1,66 @@
+#include "bench.hpp"
+#include <iostream>
+#include <cstring>
+
+namespace {
+
+	struct benchmark {
+		const char* _name;
+		int(*_run)(int argc, char** argv);
+		const char* _usage;
+	};
+
+	const benchmark benchmarks[] = {
+		{ "soft_raster", &bench_soft_raster, "[width height frames] - software rasterizer scaling and SDL parity" },
+		{ "capture", &bench_capture, "[rgba|y4m|png path frames width height] - headless offscreen rendering and frame capture" },
+		{ "tile_map", &bench_tile_map, "[map_size frames width height] - scrolling a huge chunked TileMap" },
+		{ "hit_index", &bench_hit_index, "[objects picks moves] - mouse picking with HitIndex vs. a linear scan" },
+		{ "sprites", &bench_sprites, "[sprites frames threads] - SpriteSystem update and batched submit" },
+		{ "ecs", &bench_ecs, "[entities iterations] - iterating one million ECS entities" },
+		{ "particles", &bench_particles, "[emitters capacity frames render] - ParticleEmitter update and one render_batch per emitter (render: one call per particle)" },
+		{ "search", &bench_search, "[positions budget_ms max_threads] - sliding_pawn alpha-beta search nodes per second" },
+		{ "tablebase", &bench_tablebase, "[width height path] - sliding_pawn retrograde tablebase generation and probing" },
+		{ "pixel_convert", &bench_pixel_convert, "[width height uploads] - pixel conversion kernels and native format texture uploads" },
+		{ "text", &bench_text, "[frames size font_path] - TextLine counter updated every frame, recreated vs. streamed" },
+		{ "frame_arena", &bench_frame_arena, "[frames font_path] - heap allocations of a typical frame using System::arena()" },
+		{ "snapshot", &bench_snapshot, "[updates] - producer thread latency with a locked vs. a snapshot RenderProvider" },
+		{ "locks", &bench_locks, "[threads iterations] - futex mutex, shared_mutex, condition_variable and spinlock vs. SDL under contention" },
+		{ "main_queue", &bench_main_queue, "[labels budget_ms frames font_path] - frame times of a burst of label uploads, in one frame vs. through System::post_main" },
+		{ "coroutines", &bench_coroutines, "[behaviours frames] - per frame cost of suspended coroutines vs. polled state machines (needs C++20)" },
+		{ "idle", &bench_idle, "[seconds period_ms] - main loop wakeups and cpu time of a mostly idle app, polling vs. idle mode" },
+		{ "input_latency", &bench_input_latency, "[events boxes] - injected key presses through main_loop, latency per stage" },
+		{ "metrics", &bench_metrics, "[iterations path] - cost of recording counters, gauges and histograms and of a Prometheus snapshot" },
+		{ "dynamic_resolution", &bench_dynamic_resolution, "[frames target_ms layers] - software raster frame time at full and at dynamic resolution" },
+		{ "culling", &bench_culling, "[frames objects soft] - scrolling scene drawn through a camera, most draws culled before reaching the rasterizer" },
+		{ "audio", &bench_audio, "[voices seconds driver] - mixer throughput, callback time and play to mix latency on a headless audio driver" },
+		{ "rollback", &bench_rollback, "[ticks state_words lag_ticks drop_percent] - rollback netcode over loopback: re-simulation cost, bandwidth and determinism" },
+	};
+
+}
+
+int main(int argc, char **argv)
+{
+	using namespace sally;
+
+	generic_logger::set_active_logger(make_shared<console_logger>());
+
+	if (argc >= 2)
+		for (const benchmark& b : benchmarks)
+			if (std::strcmp(argv[1], b._name) == 0) {
+				try {
+					return b._run(argc - 2, argv + 2);
+				}
+				catch (sally::exception& e) {
+					logf() << typeid(e).name() << " : " << e.what();
+				}
+				catch (std::exception& e) {
+					logf() << typeid(e).name() << " : " << e.what();
+				}
+				return 1;
+			}
+
+	std::cout << "usage: SallyBench <benchmark> [args...]" << std::endl;
+	for (const benchmark& b : benchmarks)
+		std::cout << "  " << b._name << " " << b._usage << std::endl;
+	return 1;
+}
@@ -1,5 +1,6 @@
 #include "sliding_pawn.hpp"
 #include <iostream>
+#include <cstdlib>
 
 template<typename Scenario, typename... Args>
 int run(const Args&... args_)
@@ -17,10 +18,33 @@ int main(int argc, char **argv)
 		System::InitGuard initgrd;
 
 		sliding_pawn scen;
-		Window win("Sliding Pawn", sliding_pawn::WINDOW_WIDTH, sliding_pawn::WINDOW_HEIGHT, 0, &scen);
+
+		// two player mode: SlidingPawn --net <0 (white) or 1 (black)> <local port> <remote host> <remote port> [drop percent]
+		// i.e. "--net 0 7000 127.0.0.1 7001" and "--net 1 7001 127.0.0.1 7000" in two terminals
+		unique_ptr<RollbackSession> net;
+		if (argc >= 6 && std::string(argv[1]) == "--net") {
+			RollbackSession::Config config;
+			config.local_player = std::atoi(argv[2]);
+			config.local_port = static_cast<uint16_t>(std::atoi(argv[3]));
+			config.remote = NetAddress::resolve(argv[4], static_cast<uint16_t>(std::atoi(argv[5])));
+			config.drop_percent = argc > 6 ? std::atoi(argv[6]) : 0;
+			net.reset(new RollbackSession(scen, config));
+			scen.set_session(net.get());
+		}
+
+		Window win(net ? "Sliding Pawn (network)" : "Sliding Pawn", sliding_pawn::WINDOW_WIDTH, sliding_pawn::WINDOW_HEIGHT, 0, &scen);
 		System::set_step_event_handler(&scen);
 		System::set_keyboard_event_handler(&scen);
+		if (net)
+			net->attach(); // steps the game and forwards keys to scen
 		System::main_loop();
+		if (net) {
+			net->detach();
+			logi() << "network: " << net->frame() << " ticks, " << net->rollbacks() << " rollbacks re-simulating " << net->rollback_frames()
+				<< " ticks (p99 " << net->resim_time().percentile(99) << " us), " << net->stalls() << " stalls, "
+				<< net->bytes_sent() << " bytes sent, " << net->bytes_received() << " received, " << net->desyncs() << " desyncs";
+		}
+		System::set_step_event_handler(nullptr);
 		System::set_keyboard_event_handler(nullptr);
 	}
 	catch (sally::exception& e) {
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <sally/ai/bitboard.hpp>
+#include <sally/ai/search.hpp>
+#include <cstdlib>
+
+// sliding_pawn rules for sally::ai::Search: the opponent pawn flees the player pawn and is
+// captured when both stand on the same square. turns alternate, the opponent must step to
+// a neighbouring square while the player may also stay in place.
+// scores are from the side to move, positive is good for the opponent when it is to move.
+template <int W, int H>
+class pawn_game {
+public:
+	typedef sally::ai::Bitboard<W, H> board_t;
+
+	struct Position {
+		board_t _player;
+		board_t _opponent;
+		bool _opponent_to_move;
+
+		Position() : _opponent_to_move(true) {}
+		Position(int px_, int py_, int ox_, int oy_, bool opponent_to_move_)
+			: _player(board_t::at(px_, py_)), _opponent(board_t::at(ox_, oy_)), _opponent_to_move(opponent_to_move_)
+		{}
+
+		bool operator==(const Position& o_) const {
+			return _player == o_._player && _opponent == o_._opponent && _opponent_to_move == o_._opponent_to_move;
+		}
+		bool operator!=(const Position& o_) const { return !(*this == o_); }
+	};
+
+	enum { MOVE_NORTH, MOVE_SOUTH, MOVE_WEST, MOVE_EAST, MOVE_STAY };
+	typedef int Move;
+	static const int MAX_MOVES = 5;
+
+	pawn_game() : _keys(2 * board_t::SQUARES + 1) {}
+
+	static board_t step(const board_t& pawn_, Move move_) {
+		switch (move_) {
+		case MOVE_NORTH: return pawn_.north();
+		case MOVE_SOUTH: return pawn_.south();
+		case MOVE_WEST: return pawn_.west();
+		case MOVE_EAST: return pawn_.east();
+		default: return pawn_;
+		}
+	}
+
+	// applies move_ to board coordinates (for the UI)
+	static void step(Move move_, int& x_, int& y_) {
+		static const int dx[] = { 0, 0, -1, 1, 0 };
+		static const int dy[] = { -1, 1, 0, 0, 0 };
+		x_ += dx[move_];
+		y_ += dy[move_];
+	}
+
+	int generate(const Position& pos_, Move* moves_) const {
+		const board_t& pawn = pos_._opponent_to_move ? pos_._opponent : pos_._player;
+		int count = 0;
+		for (Move mm = MOVE_NORTH; mm <= MOVE_EAST; ++mm)
+			if (!step(pawn, mm).empty())
+				moves_[count++] = mm;
+		if (!pos_._opponent_to_move)
+			moves_[count++] = MOVE_STAY;
+		return count;
+	}
+
+	Position play(const Position& pos_, Move move_) const {
+		Position next = pos_;
+		if (pos_._opponent_to_move)
+			next._opponent = step(pos_._opponent, move_);
+		else
+			next._player = step(pos_._player, move_);
+		next._opponent_to_move = !pos_._opponent_to_move;
+		return next;
+	}
+
+	bool terminal(const Position& pos_, int ply_, int& score_) const {
+		if ((pos_._player & pos_._opponent).empty())
+			return false;
+		// the side that just moved made the capture (or walked into it)
+		score_ = pos_._opponent_to_move ? -(sally::ai::SCORE_MATE - ply_) : sally::ai::SCORE_MATE - ply_;
+		return true;
+	}
+
+	int evaluate(const Position& pos_) const {
+		const int ps = pos_._player.first(), os = pos_._opponent.first();
+		const int dist = std::abs(ps % W - os % W) + std::abs(ps / W - os / W);
+		// far away and with room to run is good for the opponent
+		const int score = 16 * dist + 4 * pos_._opponent.neighbours().count();
+		return pos_._opponent_to_move ? score : -score;
+	}
+
+	uint64_t hash(const Position& pos_) const {
+		return _keys[pos_._player.first()] ^ _keys[board_t::SQUARES + pos_._opponent.first()]
+			^ (pos_._opponent_to_move ? _keys[2 * board_t::SQUARES] : 0);
+	}
+
+private:
+	sally::ai::ZobristKeys _keys;
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <sally/ai/tablebase.hpp>
+
+// sliding_pawn rules for sally::ai::TablebaseGenerator, on boards of any size.
+// position index: ((opponent_to_move * squares) + player_square) * squares + opponent_square.
+// moves are numbered like pawn_game's (north, south, west, east, stay). the opponent never
+// steps onto the player, that always loses and it has another move on boards of at least 2x2.
+class pawn_tablebase_game {
+public:
+	static const int MAX_MOVES = 5;
+
+	pawn_tablebase_game(int width_, int height_) : _width(width_), _height(height_), _squares(size_t(width_) * height_) {}
+
+	int width() const { return _width; }
+	int height() const { return _height; }
+	size_t position_count() const { return 2 * _squares * _squares; }
+
+	size_t index(int px_, int py_, int ox_, int oy_, bool opponent_to_move_) const {
+		return ((opponent_to_move_ ? _squares : 0) + size_t(py_) * _width + px_) * _squares + size_t(oy_) * _width + ox_;
+	}
+
+	bool lost(size_t index_) const {
+		// the player stepped onto the opponent
+		return index_ >= _squares * _squares && (index_ / _squares) % _squares == index_ % _squares;
+	}
+
+	int successors(size_t index_, size_t* out_) const {
+		const bool opponent_to_move = index_ >= _squares * _squares;
+		const size_t player = (index_ / _squares) % _squares, opponent = index_ % _squares;
+		if (player == opponent)
+			return 0; // decided (or unreachable) positions
+		size_t steps[MAX_MOVES];
+		const int count = neighbours(opponent_to_move ? opponent : player, steps, !opponent_to_move);
+		int moves = 0;
+		for (int mm = 0; mm < count; ++mm) {
+			if (opponent_to_move) {
+				if (steps[mm] != player)
+					out_[moves++] = player * _squares + steps[mm];
+			}
+			else
+				out_[moves++] = (_squares + steps[mm]) * _squares + opponent;
+		}
+		return moves;
+	}
+
+	// perfect opponent move from the tablebase, -1 if the position is not in it
+	int best_opponent_move(const sally::ai::Tablebase& tb_, int px_, int py_, int ox_, int oy_) const {
+		if (tb_.positions() != position_count())
+			return -1;
+		static const int dx[] = { 0, 0, -1, 1 };
+		static const int dy[] = { -1, 1, 0, 0 };
+		int best = -1, best_rank = 0;
+		for (int mm = 0; mm < 4; ++mm) {
+			const int nx = ox_ + dx[mm], ny = oy_ + dy[mm];
+			if (nx < 0 || ny < 0 || nx >= _width || ny >= _height || (nx == px_ && ny == py_))
+				continue;
+			const int rank = sally::ai::Tablebase::move_rank(tb_.value(index(px_, py_, nx, ny, false)));
+			if (best < 0 || rank > best_rank) {
+				best = mm;
+				best_rank = rank;
+			}
+		}
+		return best;
+	}
+
+private:
+	// squares reachable from square_ in one step (plus square_ itself if stay_)
+	int neighbours(size_t square_, size_t* out_, bool stay_) const {
+		const int x = static_cast<int>(square_ % _width), y = static_cast<int>(square_ / _width);
+		int count = 0;
+		if (y > 0) out_[count++] = square_ - _width;
+		if (y < _height - 1) out_[count++] = square_ + _width;
+		if (x > 0) out_[count++] = square_ - 1;
+		if (x < _width - 1) out_[count++] = square_ + 1;
+		if (stay_) out_[count++] = square_;
+		return count;
+	}
+
+	const int _width, _height;
+	const size_t _squares;
+};
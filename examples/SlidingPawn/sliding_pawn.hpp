@@ -1,12 +1,17 @@
 #pragma once
 
 #include <sally/sally.hpp>
+#include <sally/gfx/tile_map.hpp>
+#include <sally/net/rollback.hpp>
+#include "pawn_game.hpp"
+#include "pawn_tablebase.hpp"
 #include <cmath>
 
 class sliding_pawn :
 	public::sally::step_event_handler,
 	public sally::keyboard_event_handler,
-	public sally::RenderProvider
+	public sally::RenderProvider,
+	public sally::RollbackGame
 {
 public:
 	static const int BOARD_WIDTH = 8;
@@ -15,7 +20,7 @@ public:
 	static const int PLYR_START_POS_Y = 6;
 	static const int OPP_START_POS_X = BOARD_WIDTH-1 - PLYR_START_POS_X;
 	static const int OPP_START_POS_Y = BOARD_HEIGHT-1 - PLYR_START_POS_Y;
-	static const int AI_MOVE_INTERVAL_MS = 300;
+	static const int AI_MOVE_INTERVAL_MS = 300; // also the opponent's thinking budget
 
 	static const int TILE_WIDTH = 64;
 	static const int TILE_HEIGHT = TILE_WIDTH;
@@ -33,8 +38,17 @@ public:
 		_oy(OPP_START_POS_Y),
 		_plyr_wins(0),
 		_next_ai_move(0),
-		_win(nullptr)
-	{}
+		_win(nullptr),
+		_net(nullptr),
+		_board(BOARD_WIDTH, BOARD_HEIGHT, TILE_WIDTH, TILE_HEIGHT, { sally::Color(255, 255, 255), sally::Color(0, 0, 0) }),
+		_search(_game, std::max(SDL_GetCPUCount() / 2, 1)),
+		_tb_game(BOARD_WIDTH, BOARD_HEIGHT),
+		_alive(std::make_shared<int>(0))
+	{
+		for (int ii = 0; ii < BOARD_WIDTH; ++ii)
+			for (int jj = 0; jj < BOARD_HEIGHT; ++jj)
+				_board.set(ii, jj, (ii + jj) % 2 ? BLACK_TILE : WHITE_TILE);
+	}
 
 	virtual void initialize(sally::Window& win_) {
 		using namespace sally;
@@ -55,14 +69,82 @@ public:
 		update_pawn_position_label("opp_pos", _ox, _oy);
 		update_wins_label();
 
+		if (_net) {
+			// the opponent is the other process, see on_state_changed
+			win_.renderer().insert("net_rollback", new TextLine(fnt, text_color, ""));
+			win_.renderer().insert("net_bytes", new TextLine(fnt, text_color, ""));
+			return;
+		}
+
+		load_tablebase();
+
 		_next_ai_move = clock_tick() + AI_MOVE_INTERVAL_MS;
+		start_thinking();
+	}
+
+	// solved positions make the opponent play perfectly without searching. a table shipped with
+	// the resources or cached by an earlier run is mapped right away, otherwise it is generated
+	// on a worker (the opponent searches meanwhile) and cached in the user's pref path.
+	void load_tablebase() {
+		using namespace sally;
+		const std::string cache = tablebase_cache_path();
+		for (const std::string& path : { System::resouce_path("examples/SlidingPawn/sliding_pawn.tb"), cache }) {
+			if (path.empty())
+				continue;
+			try {
+				_tablebase.reset(new ai::Tablebase(path));
+				return;
+			}
+			catch (sally::exception&) {
+			}
+		}
+
+		const std::weak_ptr<int> alive = _alive;
+		const pawn_tablebase_game game = _tb_game;
+		worker_pool::shared().post([this, alive, game, cache] {
+			shared_ptr<ai::Tablebase> table;
+			try {
+				worker_pool pool; // run() on the shared pool belongs to the main thread
+				ai::TablebaseGenerator<pawn_tablebase_game> gen(game);
+				const ai::TablebaseGenerator<pawn_tablebase_game>::Stats& stats = gen.generate(pool);
+				logi() << "generated sliding_pawn tablebase: " << stats._positions << " positions, "
+					<< stats._passes << " passes, " << stats._ms << " ms";
+				const int32_t params[] = { BOARD_WIDTH, BOARD_HEIGHT };
+				try {
+					if (cache.empty())
+						throw general_exception("no user directory to cache it in");
+					gen.write(cache, params, 2);
+					table.reset(new ai::Tablebase(cache));
+				}
+				catch (sally::exception& e) {
+					logw() << "tablebase kept in memory only: " << e.what();
+					table = gen.table(params, 2);
+				}
+			}
+			catch (sally::exception& e) {
+				logw() << "no tablebase, the opponent will search instead: " << e.what();
+				return;
+			}
+			System::post_main([this, alive, table] {
+				if (!alive.expired())
+					_tablebase = table;
+			});
+		});
+	}
+
+	static std::string tablebase_cache_path() {
+		char* dir = SDL_GetPrefPath("sally", "SlidingPawn");
+		if (!dir)
+			return std::string();
+		const std::string path = std::string(dir) + "sliding_pawn.tb";
+		SDL_free(dir);
+		return path;
 	}
 
 	virtual void render(sally::Window& win_) {
 		using namespace sally;
 
 		static const Color white{ 255, 255, 255 };
-		static const Color black{   0,   0,   0 };
 		static const Color padding{ 240, 240, 240 };
 
 		Renderer& rend = win_.renderer();
@@ -96,21 +178,24 @@ public:
 				x0 += FONT_SIZE;
 				y0 += skip;
 				rend.render("opp_pos", x0, y0);
+				if (_net) {
+					x0 -= FONT_SIZE;
+					y0 += 2 * skip;
+					rend.render("net_rollback", x0, y0);
+					y0 += skip;
+					rend.render("net_bytes", x0, y0);
+				}
 			}
 		}
 
-		// draw board by first filling board+border white and then drawing black tiles:
+		// draw board by first filling board+border white and then drawing the tiles:
 		rend.draw_color(white);
 		Rect area = rend.output_rect();
 		area._x = area._width - BOARD_PIXEL_WIDTH;
 		area._width = BOARD_PIXEL_WIDTH;
 		rend.fill_rect(area);
-		rend.draw_color(black);
 		scalar x0 = area._x + BOARD_BORDER, y0 = BOARD_BORDER;
-		for (int ii = 0; ii < BOARD_WIDTH; ++ii)
-			for (int jj = 0; jj < BOARD_HEIGHT; ++jj)
-			if ((ii + jj) % 2)
-				rend.fill_rect(Rect(x0+ii*TILE_WIDTH, y0+jj*TILE_HEIGHT, TILE_WIDTH, TILE_HEIGHT));
+		_board.render(rend, Rect(x0, y0, BOARD_WIDTH*TILE_WIDTH, BOARD_HEIGHT*TILE_HEIGHT), 0, 0);
 
 		// draw pawns:
 		rend.render("black_pawn", Rect(x0 + _ox*TILE_WIDTH, y0 + _oy*TILE_HEIGHT, TILE_WIDTH, TILE_HEIGHT));
@@ -129,7 +214,18 @@ public:
 		}
 	}
 
+	// lets the main loop sleep until the opponent's next move
+	virtual int next_step_in_ms() {
+		sally::ticks_t now = sally::clock_tick();
+		return _next_ai_move > now ? static_cast<int>(_next_ai_move - now) : 0;
+	}
+
 	virtual void on_key_event(const sally::keyboard_event& event_, sally::Window* win_) {
+		if (_net) { // moves are inputs of the session, see on_local_key
+			if (event_._type == sally::keyboard_event::KEY_PRESSED && event_._keycode == SDLK_ESCAPE)
+				sally::System::request_shutdown();
+			return;
+		}
 		int oldpx = _px, oldpy = _py;
 		if (event_._type == sally::keyboard_event::KEY_PRESSED)
 			switch (event_._keycode) {
@@ -157,10 +253,74 @@ public:
 		{
 			if (!check_and_handle_game_reset())
 				update_pawn_position_label("plyr_pos", _px, _py);
+			start_thinking(); // the position the opponent was thinking about is gone
 			_win->invalidate();
 		}
 	}
 
+	// two player mode: the local player is white (player 0) or black (player 1) and the session
+	// is attached instead of this step and keyboard handler. set before the window is created.
+	void set_session(sally::RollbackSession* net_) { _net = net_; }
+
+	virtual size_t state_size() const { return sizeof(net_state); }
+
+	virtual void save_state(void* dst_) const {
+		net_state state = { static_cast<int8_t>(_px), static_cast<int8_t>(_py), static_cast<int8_t>(_ox), static_cast<int8_t>(_oy), _plyr_wins };
+		std::memcpy(dst_, &state, sizeof(state));
+	}
+
+	virtual void load_state(const void* src_) {
+		net_state state;
+		std::memcpy(&state, src_, sizeof(state));
+		_px = state._px; _py = state._py; _ox = state._ox; _oy = state._oy;
+		_plyr_wins = state._wins;
+	}
+
+	// same rules as against the AI: white wins by landing on black
+	virtual void advance(input_t white_, input_t black_) {
+		net_move(_px, _py, white_);
+		net_move(_ox, _oy, black_);
+		if (_px == _ox && _py == _oy) {
+			++_plyr_wins;
+			_px = PLYR_START_POS_X;
+			_py = PLYR_START_POS_Y;
+			_ox = OPP_START_POS_X;
+			_oy = OPP_START_POS_Y;
+		}
+	}
+
+	virtual input_t on_local_key(const sally::keyboard_event& event_, input_t input_) {
+		if (event_._type == sally::keyboard_event::KEY_PRESSED)
+			switch (event_._keycode) {
+			case SDLK_KP_8: case SDLK_UP:    return input_ | INPUT_UP;
+			case SDLK_KP_2: case SDLK_DOWN:  return input_ | INPUT_DOWN;
+			case SDLK_KP_4: case SDLK_LEFT:  return input_ | INPUT_LEFT;
+			case SDLK_KP_6: case SDLK_RIGHT: return input_ | INPUT_RIGHT;
+			}
+		return input_;
+	}
+
+	// moves are presses, a remote player rarely presses on consecutive ticks
+	virtual input_t predict(input_t) { return 0; }
+
+	virtual void on_state_changed() {
+		update_pawn_position_label("plyr_pos", _px, _py);
+		update_pawn_position_label("opp_pos", _ox, _oy);
+		update_wins_label();
+
+		const sally::RollbackSession::FrameStats& stats = _net->last_frame();
+		sally::string_builder text(sally::System::arena());
+		if (!_net->connected())
+			text << "waiting for the other player";
+		else
+			text << "rollback: " << stats.rollback_frames << " frames, " << static_cast<int>(stats.resim_us) << " us";
+		update_label_text("net_rollback", text.c_str());
+		sally::string_builder bytes(sally::System::arena());
+		bytes << "sent " << stats.bytes_sent << " B, recv " << stats.bytes_received << " B";
+		update_label_text("net_bytes", bytes.c_str());
+		_win->invalidate();
+	}
+
 	bool check_and_handle_game_reset() {
 		if (_px != _ox || _py != _oy)
 			return false;
@@ -181,24 +341,53 @@ public:
 	}
 
 	void update_wins_label() {
-		std::ostringstream ost;
-		ost << "wins: " << _plyr_wins;
-		update_label_text("plyr_wins", ost.str());
+		sally::string_builder text(sally::System::arena());
+		text << "wins: " << _plyr_wins;
+		update_label_text("plyr_wins", text.c_str());
 	}
 
 	void update_pawn_position_label(const char* label_name_, int x_, int y_) {
-		std::ostringstream ost;
-		ost << static_cast<char>('a' + x_) << static_cast<char>('1' + y_);
-		ost << " (" << x_ << "," << y_ << ")";
-		update_label_text(label_name_, ost.str());
+		sally::string_builder text(sally::System::arena());
+		text << static_cast<char>('a' + x_) << static_cast<char>('1' + y_);
+		text << " (" << x_ << "," << y_ << ")";
+		update_label_text(label_name_, text.c_str());
 	}
 
-	void update_label_text(const char* label_name_, const std::string& text_) {
+	void update_label_text(const char* label_name_, const char* text_) {
 		if (auto label = dynamic_cast<sally::TextLine*>(_win->renderer().lookup(label_name_)))
 			label->set_text(text_);
 	}
 
+	// the opponent searches the current position in the background until its next move is due
+	void start_thinking() {
+		if (_tablebase)
+			return;
+		_thinking_about = game_t::Position(_px, _py, _ox, _oy, true);
+		sally::ticks_t now = sally::clock_tick();
+		_search.start(_thinking_about, _next_ai_move > now ? _next_ai_move - now : 1);
+	}
+
 	void move_opponent() {
+		_search.stop();
+		sally::ai::Search<game_t>::Result res = _search.wait();
+		int tb_move = _tablebase ? _tb_game.best_opponent_move(*_tablebase, _px, _py, _ox, _oy) : -1;
+		if (tb_move >= 0)
+			game_t::step(tb_move, _ox, _oy);
+		else if (res._valid && _thinking_about == game_t::Position(_px, _py, _ox, _oy, true)) {
+			sally::logi() << "opponent searched depth " << res._depth << ", " << res._nodes << " nodes, score " << res._score;
+			game_t::step(res._move, _ox, _oy);
+		}
+		else
+			move_opponent_greedy();
+
+		if (!check_and_handle_game_reset())
+			update_pawn_position_label("opp_pos", _ox, _oy);
+		start_thinking();
+		_win->invalidate();
+	}
+
+	// one ply heuristic, used if the search has no answer for the current position
+	void move_opponent_greedy() {
 		int sx = 0, sy = 0;
 
 		if (_ox == 0)
@@ -219,16 +408,38 @@ public:
 			_oy += (sy > 0 || sy == 0 && _oy >= BOARD_HEIGHT / 2) ? -1 : 1;
 		else
 			_ox += (sx > 0 || sx == 0 && _ox >= BOARD_WIDTH / 2) ? -1 : 1;
-
-		if (!check_and_handle_game_reset())
-			update_pawn_position_label("opp_pos", _ox, _oy);
-		_win->invalidate();
 	}
 
 private:
+	enum { WHITE_TILE = 1, BLACK_TILE = 2 }; // indices into the board TileMap colors
+	enum { INPUT_UP = 1, INPUT_DOWN = 2, INPUT_LEFT = 4, INPUT_RIGHT = 8 };
+
+	// everything advance changes, snapshot by the rollback session every tick
+	struct net_state {
+		int8_t _px, _py, _ox, _oy;
+		int _wins;
+	};
+
+	static void net_move(int& x_, int& y_, input_t input_) {
+		if (input_ & INPUT_UP)    y_ = inc(y_, -1, 0, BOARD_HEIGHT);
+		if (input_ & INPUT_DOWN)  y_ = inc(y_, +1, 0, BOARD_HEIGHT);
+		if (input_ & INPUT_LEFT)  x_ = inc(x_, -1, 0, BOARD_WIDTH);
+		if (input_ & INPUT_RIGHT) x_ = inc(x_, +1, 0, BOARD_WIDTH);
+	}
+
 	static int inc(int v_, int d_, int l_, int h_) { v_ += d_; return v_<l_ ? l_ : (v_>=h_ ? h_ - 1 : v_); }
 
 	int _px, _py, _ox, _oy, _plyr_wins;
 	sally::ticks_t _next_ai_move;
 	sally::Window* _win;
+	sally::RollbackSession* _net;
+	sally::TileMap _board;
+
+	typedef pawn_game<BOARD_WIDTH, BOARD_HEIGHT> game_t;
+	game_t _game;
+	sally::ai::Search<game_t> _search;
+	game_t::Position _thinking_about;
+	pawn_tablebase_game _tb_game;
+	std::shared_ptr<sally::ai::Tablebase> _tablebase;
+	std::shared_ptr<int> _alive; // expires with this object, checked by tasks posted to the main thread
 };
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <sally/common.hpp>
+
+#ifdef SALLY_WINDOWS
+# include <intrin.h>
+#endif
+
+namespace sally {
+	namespace ai {
+
+		inline int popcount64(uint64_t v_) {
+#ifdef SALLY_WINDOWS
+			return static_cast<int>(__popcnt64(v_));
+#else
+			return __builtin_popcountll(v_);
+#endif
+		}
+
+		// index of the lowest set bit, v_ must not be 0
+		inline int lowest_bit64(uint64_t v_) {
+#ifdef SALLY_WINDOWS
+			unsigned long index;
+			_BitScanForward64(&index, v_);
+			return static_cast<int>(index);
+#else
+			return __builtin_ctzll(v_);
+#endif
+		}
+
+		// set of squares of a W x H board packed in 64 bits, square (x,y) is bit y*W+x.
+		// shifts move every square one step and drop squares leaving the board.
+		template <int W, int H>
+		struct Bitboard {
+			static_assert(W > 0 && H > 0 && W * H <= 64, "Bitboard supports up to 64 squares");
+
+			static const int WIDTH = W;
+			static const int HEIGHT = H;
+			static const int SQUARES = W * H;
+			static const uint64_t FULL = SQUARES == 64 ? ~uint64_t(0) : (uint64_t(1) << (SQUARES % 64)) - 1;
+
+			uint64_t _bits;
+
+			Bitboard() : _bits(0) {}
+			explicit Bitboard(uint64_t bits_) : _bits(bits_ & FULL) {}
+
+			static int square(int x_, int y_) { return y_ * W + x_; }
+			static Bitboard at(int square_) { return Bitboard(uint64_t(1) << square_); }
+			static Bitboard at(int x_, int y_) { return at(square(x_, y_)); }
+
+			bool empty() const { return _bits == 0; }
+			bool test(int square_) const { return (_bits >> square_) & 1; }
+			bool test(int x_, int y_) const { return test(square(x_, y_)); }
+			int count() const { return popcount64(_bits); }
+			int first() const { return lowest_bit64(_bits); } // lowest square, must not be empty
+
+			// all squares of column x_ (from row y_ down)
+			static constexpr uint64_t column_mask(int x_, int y_ = 0) {
+				return y_ >= H ? 0 : (uint64_t(1) << (y_ * W + x_)) | column_mask(x_, y_ + 1);
+			}
+
+			Bitboard north() const { return H > 1 ? Bitboard(_bits >> (W % 64)) : Bitboard(); } // y-1
+			Bitboard south() const { return H > 1 ? Bitboard(_bits << (W % 64)) : Bitboard(); } // y+1
+			Bitboard west() const { return Bitboard((_bits & ~column_mask(0)) >> 1); } // x-1
+			Bitboard east() const { return Bitboard((_bits & ~column_mask(W - 1)) << 1); } // x+1
+			Bitboard neighbours() const { return north() | south() | west() | east(); }
+
+			Bitboard operator|(const Bitboard& o_) const { return Bitboard(_bits | o_._bits); }
+			Bitboard operator&(const Bitboard& o_) const { return Bitboard(_bits & o_._bits); }
+			Bitboard operator^(const Bitboard& o_) const { return Bitboard(_bits ^ o_._bits); }
+			Bitboard operator~() const { return Bitboard(~_bits); }
+			bool operator==(const Bitboard& o_) const { return _bits == o_._bits; }
+			bool operator!=(const Bitboard& o_) const { return _bits != o_._bits; }
+		};
+
+	}
+}
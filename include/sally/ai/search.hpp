@@ -0,0 +1,351 @@
+#pragma once
+
+#include <sally/common.hpp>
+#include <SDL_atomic.h>
+#include <SDL_thread.h>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+
+namespace sally {
+	namespace ai {
+
+		static const int SCORE_INF = 32000;
+		static const int SCORE_MATE = 30000; // decided positions score +-(SCORE_MATE - ply)
+		static const int MAX_PLY = 128;
+
+		inline bool is_mate_score(int score_) { return score_ >= SCORE_MATE - MAX_PLY || score_ <= -(SCORE_MATE - MAX_PLY); }
+
+		// deterministic pseudo random keys for Zobrist hashing
+		class ZobristKeys {
+		public:
+			explicit ZobristKeys(size_t count_, uint64_t seed_ = 0x9e3779b97f4a7c15ull);
+
+			uint64_t operator[](size_t index_) const { return _keys[index_]; }
+			size_t size() const { return _keys.size(); }
+
+		private:
+			std::vector<uint64_t> _keys;
+		};
+
+		// fixed size hash table of search results, shared by all search threads without locking.
+		// every slot keeps key^data next to the data, so a slot torn by concurrent stores fails
+		// the key check and simply reads as empty.
+		class TranspositionTable {
+		public:
+			enum bound_t { BOUND_NONE = 0, BOUND_EXACT = 1, BOUND_LOWER = 2, BOUND_UPPER = 3 };
+
+			struct Entry {
+				int16_t _score;
+				int16_t _move;
+				uint8_t _depth;
+				uint8_t _bound;
+			};
+
+			explicit TranspositionTable(size_t megabytes_ = 16);
+
+			bool probe(uint64_t key_, Entry& entry_) const;
+			void store(uint64_t key_, const Entry& entry_);
+			void clear();
+			size_t slots() const { return _mask + 1; }
+
+		private:
+			struct Slot {
+				std::atomic<uint64_t> _check;
+				std::atomic<uint64_t> _data;
+			};
+
+			TranspositionTable(const TranspositionTable&) = delete;
+			TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+			unique_ptr<Slot[]> _slots;
+			size_t _mask;
+		};
+
+		// alpha-beta negamax with iterative deepening and a shared transposition table. with more
+		// than one thread, helper threads search the same root (lazy SMP) and mostly contribute
+		// through the table. the search stops once the time budget is spent, returning the best
+		// move of the deepest completed iteration (depth 1 always completes).
+		//
+		// Game must provide:
+		//   typedef ... Position;               copyable and default constructible
+		//   typedef ... Move;                   convertible to and from int16_t, non negative
+		//   static const int MAX_MOVES;
+		//   int generate(const Position&, Move* moves_) const;     legal moves of the side to move
+		//   Position play(const Position&, Move) const;
+		//   bool terminal(const Position&, int ply_, int& score_) const;   decided positions, score for side to move
+		//   int evaluate(const Position&) const;                            heuristic score for side to move
+		//   uint64_t hash(const Position&) const;                           i.e. Zobrist key
+		template <class Game>
+		class Search {
+		public:
+			typedef typename Game::Position Position;
+			typedef typename Game::Move Move;
+
+			struct Result {
+				bool _valid;     // false if the root has no moves
+				Move _move;
+				int _score;
+				int _depth;      // deepest completed iteration
+				uint64_t _nodes; // over all threads
+				ticks_t _ms;
+
+				Result() : _valid(false), _move(), _score(0), _depth(0), _nodes(0), _ms(0) {}
+			};
+
+			// threads_ search threads, including the thread running the search
+			Search(const Game& game_, int threads_ = 1, size_t tt_megabytes_ = 16)
+				: _game(game_), _threads(std::max(threads_, 1)), _table(tt_megabytes_), _root(), _max_depth(1),
+				  _deadline(0), _stop({ 0 }), _driver(nullptr), _done({ 1 })
+			{}
+			~Search() { stop(); wait(); }
+
+			// searches root_ on the calling thread (and helpers) for at most budget_ms_
+			Result run(const Position& root_, ticks_t budget_ms_, int max_depth_ = MAX_PLY - 1) {
+				stop();
+				wait();
+				SDL_AtomicSet(&_stop, 0);
+				return search(root_, budget_ms_, max_depth_);
+			}
+
+			// same as run on a background thread, a running search is stopped first
+			void start(const Position& root_, ticks_t budget_ms_, int max_depth_ = MAX_PLY - 1) {
+				stop();
+				wait();
+				SDL_AtomicSet(&_stop, 0);
+				SDL_AtomicSet(&_done, 0);
+				_pending_root = root_;
+				_pending_budget = budget_ms_;
+				_max_depth = max_depth_;
+				_driver = SDL_CreateThread(&Search::driver_main, "sally_search", this);
+				if (!_driver) {
+					SDL_AtomicSet(&_done, 1);
+					throw sdl_exception("SDL_CreateThread failed (search)");
+				}
+			}
+
+			bool running() const { return SDL_AtomicGet(const_cast<SDL_atomic_t*>(&_done)) == 0; }
+			// asks a running search to finish as soon as possible
+			void stop() { SDL_AtomicSet(&_stop, 1); }
+			// waits for the background search and returns its result
+			Result wait() {
+				if (_driver) {
+					SDL_WaitThread(_driver, nullptr);
+					_driver = nullptr;
+				}
+				return _async_result;
+			}
+
+			TranspositionTable& table() { return _table; }
+			int threads() const { return _threads; }
+
+		private:
+			struct Worker {
+				Search* _search;
+				int _id;
+				bool _may_stop; // false until the first iteration completed
+				uint64_t _nodes;
+				Result _result;
+			};
+
+			Search(const Search&) = delete;
+			Search& operator=(const Search&) = delete;
+
+			static int driver_main(void* self_) {
+				Search* self = static_cast<Search*>(self_);
+				self->_async_result = self->search(self->_pending_root, self->_pending_budget, self->_max_depth);
+				SDL_AtomicSet(&self->_done, 1);
+				return 0;
+			}
+
+			static int helper_main(void* worker_) {
+				Worker* worker = static_cast<Worker*>(worker_);
+				worker->_search->iterate(*worker);
+				return 0;
+			}
+
+			Result search(const Position& root_, ticks_t budget_ms_, int max_depth_) {
+				const ticks_t start = clock_tick();
+				_root = root_;
+				_max_depth = std::min(std::max(max_depth_, 1), MAX_PLY - 1);
+				_deadline = start + budget_ms_;
+
+				std::vector<Worker> workers(_threads);
+				std::vector<SDL_Thread*> helpers;
+				for (int ii = 0; ii < _threads; ++ii) {
+					workers[ii]._search = this;
+					workers[ii]._id = ii;
+					workers[ii]._may_stop = ii > 0;
+					workers[ii]._nodes = 0;
+				}
+				for (int ii = 1; ii < _threads; ++ii)
+					if (SDL_Thread* thread = SDL_CreateThread(&Search::helper_main, "sally_search_helper", &workers[ii]))
+						helpers.push_back(thread);
+
+				iterate(workers[0]);
+				SDL_AtomicSet(&_stop, 1); // release the helpers
+				for (SDL_Thread* thread : helpers)
+					SDL_WaitThread(thread, nullptr);
+
+				Result res = workers[0]._result;
+				res._nodes = 0;
+				for (const Worker& worker : workers)
+					res._nodes += worker._nodes;
+				res._ms = clock_tick() - start;
+				return res;
+			}
+
+			bool stopped(Worker& worker_) {
+				if (!worker_._may_stop)
+					return false;
+				if ((worker_._nodes & 1023) == 0 && clock_tick() >= _deadline)
+					SDL_AtomicSet(&_stop, 1);
+				return SDL_AtomicGet(&_stop) != 0;
+			}
+
+			void iterate(Worker& worker_) {
+				// helpers start one ply deeper every other thread so they do not all search the same tree
+				for (int depth = 1 + (worker_._id & 1); depth <= _max_depth; ++depth) {
+					Move best = Move();
+					bool found = false;
+					int score = search_root(worker_, depth, best, found);
+					if (stopped(worker_))
+						break;
+					worker_._result._valid = found;
+					worker_._result._move = best;
+					worker_._result._score = score;
+					worker_._result._depth = depth;
+					worker_._may_stop = true;
+					if (!found || is_mate_score(score))
+						break;
+				}
+			}
+
+			static int score_to_table(int score_, int ply_) {
+				return score_ >= SCORE_MATE - MAX_PLY ? score_ + ply_ : (score_ <= -(SCORE_MATE - MAX_PLY) ? score_ - ply_ : score_);
+			}
+			static int score_from_table(int score_, int ply_) {
+				return score_ >= SCORE_MATE - MAX_PLY ? score_ - ply_ : (score_ <= -(SCORE_MATE - MAX_PLY) ? score_ + ply_ : score_);
+			}
+
+			// moves the table's best move to the front
+			static void order_moves(Move* moves_, int count_, int table_move_) {
+				for (int ii = 1; ii < count_; ++ii)
+					if (static_cast<int>(moves_[ii]) == table_move_) {
+						std::swap(moves_[0], moves_[ii]);
+						break;
+					}
+			}
+
+			int search_root(Worker& worker_, int depth_, Move& best_, bool& found_) {
+				Move moves[Game::MAX_MOVES];
+				const int count = _game.generate(_root, moves);
+				if (count == 0) {
+					int score;
+					return _game.terminal(_root, 0, score) ? score : _game.evaluate(_root);
+				}
+
+				const uint64_t key = _game.hash(_root);
+				TranspositionTable::Entry entry;
+				if (_table.probe(key, entry))
+					order_moves(moves, count, entry._move);
+
+				int alpha = -SCORE_INF;
+				for (int ii = 0; ii < count; ++ii) {
+					int score = -negamax(worker_, _game.play(_root, moves[ii]), depth_ - 1, -SCORE_INF, -alpha, 1);
+					if (stopped(worker_))
+						return 0;
+					if (score > alpha || !found_) {
+						alpha = score;
+						best_ = moves[ii];
+						found_ = true;
+					}
+				}
+				store(key, alpha, static_cast<int>(best_), depth_, TranspositionTable::BOUND_EXACT, 0);
+				return alpha;
+			}
+
+			int negamax(Worker& worker_, const Position& pos_, int depth_, int alpha_, int beta_, int ply_) {
+				++worker_._nodes;
+				if (stopped(worker_))
+					return 0;
+
+				int score;
+				if (_game.terminal(pos_, ply_, score))
+					return score;
+				if (depth_ <= 0 || ply_ >= MAX_PLY - 1)
+					return _game.evaluate(pos_);
+
+				const uint64_t key = _game.hash(pos_);
+				int table_move = -1;
+				TranspositionTable::Entry entry;
+				if (_table.probe(key, entry)) {
+					table_move = entry._move;
+					if (entry._depth >= depth_) {
+						const int tscore = score_from_table(entry._score, ply_);
+						if (entry._bound == TranspositionTable::BOUND_EXACT)
+							return tscore;
+						if (entry._bound == TranspositionTable::BOUND_LOWER)
+							alpha_ = std::max(alpha_, tscore);
+						else if (entry._bound == TranspositionTable::BOUND_UPPER)
+							beta_ = std::min(beta_, tscore);
+						if (alpha_ >= beta_)
+							return tscore;
+					}
+				}
+
+				Move moves[Game::MAX_MOVES];
+				const int count = _game.generate(pos_, moves);
+				if (count == 0)
+					return _game.evaluate(pos_);
+				order_moves(moves, count, table_move);
+
+				const int alpha_orig = alpha_;
+				int best = -SCORE_INF;
+				Move best_move = moves[0];
+				for (int ii = 0; ii < count; ++ii) {
+					score = -negamax(worker_, _game.play(pos_, moves[ii]), depth_ - 1, -beta_, -alpha_, ply_ + 1);
+					if (stopped(worker_))
+						return 0;
+					if (score > best) {
+						best = score;
+						best_move = moves[ii];
+					}
+					alpha_ = std::max(alpha_, score);
+					if (alpha_ >= beta_)
+						break;
+				}
+
+				const TranspositionTable::bound_t bound = best <= alpha_orig ? TranspositionTable::BOUND_UPPER
+					: (best >= beta_ ? TranspositionTable::BOUND_LOWER : TranspositionTable::BOUND_EXACT);
+				store(key, best, static_cast<int>(best_move), depth_, bound, ply_);
+				return best;
+			}
+
+			void store(uint64_t key_, int score_, int move_, int depth_, TranspositionTable::bound_t bound_, int ply_) {
+				TranspositionTable::Entry entry;
+				entry._score = static_cast<int16_t>(score_to_table(score_, ply_));
+				entry._move = static_cast<int16_t>(move_);
+				entry._depth = static_cast<uint8_t>(depth_);
+				entry._bound = static_cast<uint8_t>(bound_);
+				_table.store(key_, entry);
+			}
+
+			const Game& _game;
+			const int _threads;
+			TranspositionTable _table;
+			Position _root;
+			int _max_depth;
+			ticks_t _deadline;
+			SDL_atomic_t _stop;
+
+			// background search:
+			SDL_Thread* _driver;
+			SDL_atomic_t _done;
+			Position _pending_root;
+			ticks_t _pending_budget;
+			Result _async_result;
+		};
+
+	}
+}
@@ -0,0 +1,210 @@
+#pragma once
+
+#include <sally/common.hpp>
+#include <sally/util/mapped_file.hpp>
+#include <sally/util/worker_pool.hpp>
+#include <atomic>
+#include <vector>
+#include <cstdio>
+
+namespace sally {
+	namespace ai {
+
+		// solved game stored as one byte per position, memory mapped so probing costs a page
+		// fault at most (or held in memory when it could not be written). values are distances in plies from the side to move's point of view:
+		// even d means the side to move loses in d plies (0: already lost), odd d means it wins
+		// in d plies and DRAW means neither side can force an end (or it takes over MAX_DISTANCE).
+		class Tablebase {
+		public:
+			static const uint8_t DRAW = 255;
+			static const int MAX_DISTANCE = 254;
+			static const int MAX_PARAMS = 4;
+
+			// file layout: Header followed by Header::_positions value bytes
+			struct Header {
+				char _magic[8];
+				uint32_t _version;
+				uint32_t _param_count;
+				int32_t _params[MAX_PARAMS]; // game specific, i.e. the board size
+				uint64_t _positions;
+			};
+
+			// maps a file written by TablebaseGenerator::write, throws general_exception if it is not one
+			explicit Tablebase(const std::string& path_);
+			// a table held in memory (see TablebaseGenerator::table), one value per position
+			Tablebase(const int32_t* params_, int param_count_, std::vector<uint8_t>&& values_);
+
+			uint8_t value(size_t index_) const { return _values[index_]; }
+			size_t positions() const { return static_cast<size_t>(_header._positions); }
+			int param(int index_) const { return index_ < static_cast<int>(_header._param_count) ? _header._params[index_] : 0; }
+
+			static bool wins(uint8_t value_) { return value_ != DRAW && (value_ & 1); }
+			static bool loses(uint8_t value_) { return value_ != DRAW && !(value_ & 1); }
+			// how good moving into a position with value_ (from the opponent's view) is for the mover,
+			// the best move has the highest rank: fastest win, then draw, then slowest loss
+			static int move_rank(uint8_t value_) {
+				return value_ == DRAW ? 0 : ((value_ & 1) ? -1000 + value_ : 1000 - value_);
+			}
+
+			static void write_header(std::FILE* file_, const int32_t* params_, int param_count_, uint64_t positions_);
+
+		private:
+			Tablebase(const Tablebase&) = delete;
+			Tablebase& operator=(const Tablebase&) = delete;
+
+			static Header make_header(const int32_t* params_, int param_count_, uint64_t positions_);
+
+			unique_ptr<mapped_file> _file; // null for tables held in _owned
+			std::vector<uint8_t> _owned;
+			Header _header;
+			const uint8_t* _values;
+		};
+
+		// parallel retrograde analysis. every pass looks at the still undecided positions and marks
+		// those won in d plies (a move reaches a position lost in d-1) or lost in d plies (all moves
+		// reach positions won in at most d-1), until a pass decides nothing. positions are only
+		// ever set to the current pass' distance, so concurrent readers of a neighbouring block see
+		// either the old or the new value and both lead to the same result.
+		//
+		// Game must provide:
+		//   static const int MAX_MOVES;
+		//   size_t position_count() const;
+		//   bool lost(size_t index_) const;                      terminal, the side to move has lost
+		//   int successors(size_t index_, size_t* out_) const;   positions after each legal move (none: draw)
+		template <class Game>
+		class TablebaseGenerator {
+		public:
+			struct Stats {
+				size_t _positions;
+				size_t _decided;  // positions not drawn
+				int _passes;
+				bool _truncated;  // stopped at MAX_DISTANCE with positions still being decided
+				ticks_t _ms;
+
+				Stats() : _positions(0), _decided(0), _passes(0), _truncated(false), _ms(0) {}
+			};
+
+			explicit TablebaseGenerator(const Game& game_)
+				: _game(game_), _count(game_.position_count()), _values(new std::atomic<uint8_t>[_count])
+			{}
+
+			const Stats& generate(worker_pool& pool_) {
+				const ticks_t start = clock_tick();
+				const size_t blocks = (_count + BLOCK - 1) / BLOCK;
+				std::vector<size_t> changed(blocks);
+
+				_stats = Stats();
+				_stats._positions = _count;
+				pool_.run(blocks, [&](size_t block_) {
+					size_t decided = 0;
+					for (size_t ii = block_ * BLOCK; ii < std::min(_count, (block_ + 1) * BLOCK); ++ii) {
+						const bool lost = _game.lost(ii);
+						_values[ii].store(lost ? uint8_t(0) : uint8_t(Tablebase::DRAW), std::memory_order_relaxed);
+						decided += lost;
+					}
+					changed[block_] = decided;
+				});
+				for (size_t cnt : changed)
+					_stats._decided += cnt;
+
+				for (int dist = 1; dist <= Tablebase::MAX_DISTANCE; ++dist) {
+					pool_.run(blocks, [&](size_t block_) { changed[block_] = pass(block_, dist); });
+					size_t total = 0;
+					for (size_t cnt : changed)
+						total += cnt;
+					_stats._passes = dist;
+					_stats._decided += total;
+					if (!total)
+						break;
+					_stats._truncated = dist == Tablebase::MAX_DISTANCE;
+				}
+				_stats._ms = clock_tick() - start;
+				return _stats;
+			}
+
+			uint8_t value(size_t index_) const { return _values[index_].load(std::memory_order_relaxed); }
+			const Stats& stats() const { return _stats; }
+
+			// copies the generated values into a Tablebase, i.e. when writing the file failed
+			unique_ptr<Tablebase> table(const int32_t* params_, int param_count_) const {
+				std::vector<uint8_t> values(_count);
+				for (size_t ii = 0; ii < _count; ++ii)
+					values[ii] = value(ii);
+				return unique_ptr<Tablebase>(new Tablebase(params_, param_count_, std::move(values)));
+			}
+
+			// writes the table in the format read by Tablebase, throws general_exception on failure
+			void write(const std::string& path_, const int32_t* params_, int param_count_) const {
+				std::FILE* file = std::fopen(path_.c_str(), "wb");
+				if (!file)
+					throw general_exception(("cannot create " + path_).c_str());
+				std::vector<uint8_t> buffer(BLOCK);
+				bool ok = true;
+				try {
+					Tablebase::write_header(file, params_, param_count_, _count);
+				}
+				catch (...) {
+					std::fclose(file);
+					throw;
+				}
+				for (size_t base = 0; ok && base < _count; base += BLOCK) {
+					const size_t len = std::min(_count - base, size_t(BLOCK));
+					for (size_t ii = 0; ii < len; ++ii)
+						buffer[ii] = value(base + ii);
+					ok = std::fwrite(buffer.data(), 1, len, file) == len;
+				}
+				ok = std::fclose(file) == 0 && ok;
+				if (!ok)
+					throw general_exception(("failed writing " + path_).c_str());
+			}
+
+		private:
+			static const size_t BLOCK = 64 * 1024; // positions per task
+
+			TablebaseGenerator(const TablebaseGenerator&) = delete;
+			TablebaseGenerator& operator=(const TablebaseGenerator&) = delete;
+
+			// decides the positions of block_ at distance dist_, returns how many
+			size_t pass(size_t block_, int dist_) {
+				const bool win = (dist_ & 1) != 0;
+				size_t succ[Game::MAX_MOVES];
+				size_t decided = 0;
+				for (size_t ii = block_ * BLOCK; ii < std::min(_count, (block_ + 1) * BLOCK); ++ii) {
+					if (_values[ii].load(std::memory_order_relaxed) != Tablebase::DRAW)
+						continue;
+					const int moves = _game.successors(ii, succ);
+					if (!moves)
+						continue;
+					bool hit = !win;
+					int longest = -1;
+					for (int mm = 0; mm < moves; ++mm) {
+						const uint8_t val = _values[succ[mm]].load(std::memory_order_relaxed);
+						if (win) {
+							if (val == dist_ - 1) {
+								hit = true;
+								break;
+							}
+						}
+						else if (val == Tablebase::DRAW || !(val & 1) || val >= dist_) {
+							hit = false; // a move escapes to a draw or a position the opponent does not win in time
+							break;
+						}
+						else
+							longest = std::max<int>(longest, val);
+					}
+					if (hit && (win || longest == dist_ - 1)) {
+						_values[ii].store(static_cast<uint8_t>(dist_), std::memory_order_relaxed);
+						++decided;
+					}
+				}
+				return decided;
+			}
+
+			const Game& _game;
+			const size_t _count;
+			unique_ptr<std::atomic<uint8_t>[]> _values;
+			Stats _stats;
+		};
+
+	}
+}
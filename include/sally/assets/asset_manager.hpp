@@ -0,0 +1,57 @@
+#pragma once
+
+#include <sally/common.hpp>
+#include <sally/assets/font.hpp>
+#include <sally/assets/image.hpp>
+#include <sally/assets/sound.hpp>
+#include <sally/util/threading.hpp>
+#include <unordered_map>
+
+namespace sally {
+
+	// loads assets at most once: requests are keyed by the canonical file path (plus the load
+	// parameters) and share one reference counted object as long as any handle is alive.
+	// the manager only keeps weak references, the asset is released with its last handle.
+	// all methods are thread safe.
+	class AssetManager
+	{
+	public:
+		struct Stats {
+			uint64_t loads; // requests which decoded the file
+			uint64_t hits;  // requests served by an already loaded asset
+			size_t live;    // assets alive as of the last collect
+
+			Stats() : loads(0), hits(0), live(0) {}
+		};
+
+		AssetManager() : _collect_at(16) {}
+
+		// throw img_exception / ttf_exception when the file cannot be loaded
+		shared_ptr<Image> image(const std::string& filepath_);
+		shared_ptr<Font> font(const std::string& filepath_, int ptsize_, long index_ = 0);
+		// throws sdl_exception
+		shared_ptr<Sound> sound(const std::string& filepath_);
+
+		// forgets entries of released assets, called periodically by the requests themselves
+		void collect();
+
+		Stats stats() const;
+
+		// absolute path with . and .. resolved and links followed, filepath_ as is if it does not exist
+		static std::string canonical_path(const std::string& filepath_);
+
+	private:
+		AssetManager(const AssetManager&) = delete;
+		AssetManager& operator=(const AssetManager&) = delete;
+
+		template <class T, class Load> shared_ptr<T> acquire(std::unordered_map<std::string, std::weak_ptr<T> >& map_, const std::string& key_, Load load_);
+
+		std::unordered_map<std::string, std::weak_ptr<Image> > _images;
+		std::unordered_map<std::string, std::weak_ptr<Font> > _fonts;
+		std::unordered_map<std::string, std::weak_ptr<Sound> > _sounds;
+		Stats _stats;
+		uint64_t _collect_at; // collect when this many requests were served
+		mutable mutex _lock;
+	};
+
+}
@@ -1,19 +1,22 @@
 #pragma once
 
 #include <sally/common.hpp>
-
-struct _TTF_Font;
+#include <SDL_ttf.h>
 
 namespace sally {
 
-	class font
+	// fonts are shared by everyone loading the same file at the same size (see AssetManager),
+	// so set_style affects all users of the font
+	class Font
 	{
 	public:
 		enum render_mode_t {
-			RENDER_SOLID,   // fastest but lowest quality (use for fast changing text)
+			RENDER_SOLID,   // fastest but lowest quality (use for fast changing text, see TextLine::UPDATE_STREAMING)
 			RENDER_BLENDED  // antialiased with alpha transperancy (use for high quality unboxed text)
 		};
 
+		TTF_Font* sdl_font() const { return _font; }
+
 		void set_style(int style_);
 		int get_style() const;
 
@@ -24,16 +27,14 @@ namespace sally {
 		int calc_width(const char* utf8_) const;
 		int calc_width(const wchar_t* unicode_) const;
 
-		~font();
-
-	public: // interface for sally library
-		// to load fonts use the asset manager
-		font(const std::string& filepath_, int ptsize_, long index_);
+		virtual ~Font();
 
-		_TTF_Font* sdl_font() const { return _font; }
+	private: // to load fonts use the asset manager
+		Font(const std::string& filepath_, int ptsize_, long index_);
+		friend class AssetManager;
 
 	private:
-		_TTF_Font* _font;
+		TTF_Font* _font;
 	};
 
 }
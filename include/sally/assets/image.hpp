@@ -0,0 +1,34 @@
+#pragma once
+
+#include <sally/common.hpp>
+
+struct SDL_Surface;
+
+namespace sally {
+
+	// decoded image kept in CPU memory as ARGB8888. images are immutable and shared by every renderer
+	// (and window) using the same file, each renderer uploads its own texture from it.
+	class Image
+	{
+	public:
+		const std::string& filepath() const { return _filepath; }
+		int width() const;
+		int height() const;
+		size_t bytes() const; // decoded pixel memory
+
+		SDL_Surface* sdl_surface() const { return _surface; }
+
+		~Image();
+
+	private: // to load images use the asset manager
+		explicit Image(const std::string& filepath_);
+		Image(const Image&) = delete;
+		Image& operator=(const Image&) = delete;
+		friend class AssetManager;
+
+	private:
+		const std::string _filepath;
+		SDL_Surface* _surface;
+	};
+
+}
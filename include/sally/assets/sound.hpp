@@ -0,0 +1,36 @@
+#pragma once
+
+#include <sally/common.hpp>
+#include <vector>
+
+namespace sally {
+
+	// decoded audio kept in memory as interleaved stereo float samples at SAMPLE_RATE, the
+	// layout AudioMixer mixes without conversion. sounds are immutable and shared by every
+	// voice playing them.
+	class Sound
+	{
+	public:
+		static const int SAMPLE_RATE = 48000;
+
+		// generated audio (i.e. synthesized effects), stereo_ holds left/right sample pairs
+		Sound(const std::string& name_, std::vector<float> stereo_);
+
+		const std::string& filepath() const { return _filepath; }
+		size_t frames() const { return _samples.size() / 2; }
+		const float* samples() const { return _samples.data(); }
+		size_t bytes() const { return _samples.size() * sizeof(float); }
+		double seconds() const { return double(frames()) / SAMPLE_RATE; }
+
+	private: // to load sound files use the asset manager
+		explicit Sound(const std::string& filepath_);
+		Sound(const Sound&) = delete;
+		Sound& operator=(const Sound&) = delete;
+		friend class AssetManager;
+
+	private:
+		const std::string _filepath;
+		std::vector<float> _samples;
+	};
+
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <sally/common.hpp>
+#include <sally/assets/sound.hpp>
+#include <sally/util/spsc_queue.hpp>
+#include <sally/util/histogram.hpp>
+#include <sally/util/metrics.hpp>
+#include <atomic>
+#include <vector>
+
+namespace sally {
+
+	// software mixer on top of an SDL audio device, mixing up to MAX_VOICES Sounds into
+	// stereo float output. the game thread (one thread, usually the main thread) talks to the
+	// audio callback only through lock free queues: play, stop and set_gain never block, and
+	// the callback neither locks nor allocates. voices which finished are reported back and
+	// their sounds released by update (called by System::main_loop).
+	class AudioMixer {
+	public:
+		typedef uint32_t voice_t; // 0 is no voice
+		static const int MAX_VOICES = 64;
+
+		struct Config {
+			const char* driver;  // SDL audio driver, i.e. "dummy" or "disk" to run headless (nullptr: default)
+			const char* device;  // nullptr: default device
+			int buffer_frames;   // per callback, lower is less latency but more callbacks
+
+			Config() : driver(nullptr), device(nullptr), buffer_frames(256) {}
+		};
+
+		AudioMixer();
+		~AudioMixer();
+
+		// opens the device at Sound::SAMPLE_RATE (SDL converts if the device differs), throws sdl_exception
+		void open(const Config& config_ = Config());
+		void close();
+		bool is_open() const { return _device != 0; }
+		int buffer_frames() const { return _buffer_frames; } // as obtained from the device
+
+		// game thread only. play returns 0 if all voices are busy or the command queue is full.
+		// pan_ goes from -1 (left) to 1 (right).
+		voice_t play(const shared_ptr<Sound>& sound_, float gain_ = 1, float pan_ = 0, bool loop_ = false);
+		void stop(voice_t voice_);
+		void set_gain(voice_t voice_, float gain_, float pan_ = 0);
+		void stop_all();
+		void set_master_gain(float gain_);
+		bool playing(voice_t voice_) const;
+		int active_voices() const { return _active; }
+		// releases the sounds of finished voices
+		void update();
+
+		// mixes frames_ frames into out_ exactly as the device callback does, for offline rendering
+		// and benchmarks. only while the device is closed (the mixer has a single consumer).
+		void render(float* out_, int frames_);
+
+		uint64_t callbacks() const { return _callbacks.load(std::memory_order_relaxed); }
+		uint64_t frames_mixed() const { return _frames_mixed.load(std::memory_order_relaxed); }
+		uint64_t dropped_commands() const { return _dropped; }
+		// microseconds per callback and from play() to the voice's first mixed buffer
+		const histogram& callback_time() const { return _callback_time; }
+		const histogram& command_latency() const { return _command_latency; }
+
+	private:
+		enum command_type { CMD_PLAY, CMD_STOP, CMD_GAIN, CMD_STOP_ALL, CMD_MASTER };
+
+		struct Command {
+			command_type _type;
+			int _slot;
+			const Sound* _sound; // kept alive by the game side slot until the voice ends
+			float _gain_l, _gain_r;
+			bool _loop;
+			uint64_t _posted;    // performance counter
+		};
+
+		// callback side state
+		struct Voice {
+			const float* _samples;
+			size_t _frames;
+			size_t _pos;
+			float _gain_l, _gain_r;
+			bool _loop;
+			bool _active;
+			uint64_t _posted; // 0 once the latency was recorded
+		};
+
+		// game side state
+		struct Slot {
+			shared_ptr<Sound> _sound; // nullptr when free
+			uint32_t _generation;
+			bool _stopping;
+		};
+
+		AudioMixer(const AudioMixer&) = delete;
+		AudioMixer& operator=(const AudioMixer&) = delete;
+
+		static void callback(void* mixer_, uint8_t* stream_, int len_); // SDL audio thread
+		void mix(float* out_, int frames_);
+		void apply(const Command& cmd_);
+		bool post(const Command& cmd_);
+		int slot_of(voice_t voice_) const;
+		void release(int slot_);
+		void register_metrics();
+
+		uint32_t _device;
+		int _buffer_frames;
+		bool _audio_inited;
+		spsc_queue<Command, 256> _commands;
+		spsc_queue<int, 128> _ended; // slots of finished voices, capacity above MAX_VOICES so it never fills
+		// callback side
+		Voice _voices[MAX_VOICES];
+		std::vector<float> _accum; // preallocated when opening, the callback never grows it
+		float _master;
+		std::atomic<uint64_t> _callbacks;
+		std::atomic<uint64_t> _frames_mixed;
+		histogram _callback_time;
+		histogram _command_latency;
+		// game side
+		Slot _slots[MAX_VOICES];
+		int _active;
+		uint64_t _dropped;
+		// metrics, registered on open
+		gauge* _voices_gauge;
+		counter* _dropped_counter;
+	};
+
+	// mixing kernels used by AudioMixer, exposed for benchmarking and validation.
+	// SSE/AVX are chosen at compile time.
+	namespace audio_kernels {
+		// dst_ += src_ * gain for samples_ interleaved stereo floats (left samples get gain_l_)
+		void mix_stereo(float* dst_, const float* src_, size_t samples_, float gain_l_, float gain_r_);
+		void mix_stereo_scalar(float* dst_, const float* src_, size_t samples_, float gain_l_, float gain_r_);
+		// dst_ = src_ * gain_ clamped to [-1, 1]
+		void master(float* dst_, const float* src_, size_t samples_, float gain_);
+
+		// name of the instruction set compiled into the kernels
+		const char* isa();
+	}
+
+}
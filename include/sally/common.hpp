@@ -20,7 +20,7 @@
 # define SALLY_SFORMAT(buf,f,...) _snprintf_s(buf,sizeof(buf),f,__VA_ARGS__)
 #else
 # define SALLY_SNFORMAT(buf,size,f,...) snprintf(buf,size,f,__VA_ARGS__)
-# define SALLY_SFORMAT(buf,f,...) sprintf(buf,sizeof(buf),f,__VA_ARGS__)
+# define SALLY_SFORMAT(buf,f,...) snprintf(buf,sizeof(buf),f,__VA_ARGS__)
 #endif
 
 #ifdef SALLY_WINDOWS
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <sally/system.hpp>
+#include <sally/util/coroutine_scheduler.hpp>
+
+#ifdef SALLY_COROUTINES
+
+#include <exception>
+#include <utility>
+
+namespace sally {
+
+	namespace detail {
+		void log_task_error(std::exception_ptr error_);
+	}
+
+	// coroutine returning nothing, i.e. a behaviour written as straight code instead of a state
+	// machine polled every step:
+	//
+	//   task blink(TextLine* label_) {
+	//       for (;;) {
+	//           label_->set_color(Color(255, 0, 0));
+	//           co_await delay(500);
+	//           label_->set_color(Color(0, 0, 0));
+	//           co_await delay(500);
+	//       }
+	//   }
+	//
+	// starts running when called. a task may be co_await-ed by another coroutine (exceptions are
+	// rethrown there) or dropped, the coroutine then keeps running on its own and exceptions it
+	// throws are logged. frames come from coroutine_frame_alloc.
+	class task {
+	public:
+		struct promise_type;
+		typedef std::coroutine_handle<promise_type> handle_t;
+
+		struct promise_type {
+			std::coroutine_handle<> _continuation;
+			std::exception_ptr _error;
+			bool _detached = false;
+
+			struct final_awaiter {
+				bool await_ready() const noexcept { return false; }
+				std::coroutine_handle<> await_suspend(handle_t handle_) noexcept {
+					promise_type& promise = handle_.promise();
+					if (promise._continuation)
+						return promise._continuation;
+					if (promise._detached) {
+						if (promise._error)
+							detail::log_task_error(promise._error);
+						handle_.destroy();
+					}
+					return std::noop_coroutine();
+				}
+				void await_resume() const noexcept {}
+			};
+
+			task get_return_object() { return task(handle_t::from_promise(*this)); }
+			std::suspend_never initial_suspend() const noexcept { return {}; }
+			final_awaiter final_suspend() const noexcept { return {}; }
+			void return_void() {}
+			void unhandled_exception() { _error = std::current_exception(); }
+
+			static void* operator new(size_t bytes_) { return coroutine_frame_alloc(bytes_); }
+			static void operator delete(void* frame_, size_t bytes_) { coroutine_frame_free(frame_, bytes_); }
+		};
+
+		task(task&& o_) noexcept : _handle(o_._handle) { o_._handle = nullptr; }
+		~task() {
+			if (!_handle)
+				return;
+			if (_handle.done()) {
+				if (_handle.promise()._error)
+					detail::log_task_error(_handle.promise()._error);
+				_handle.destroy();
+			}
+			else
+				_handle.promise()._detached = true;
+		}
+
+		bool done() const { return !_handle || _handle.done(); }
+
+		bool await_ready() const noexcept { return done(); }
+		void await_suspend(std::coroutine_handle<> continuation_) noexcept { _handle.promise()._continuation = continuation_; }
+		void await_resume() {
+			if (_handle && _handle.promise()._error)
+				std::rethrow_exception(std::exchange(_handle.promise()._error, nullptr));
+		}
+
+	private:
+		explicit task(handle_t handle_) : _handle(handle_) {}
+		task(const task&) = delete;
+		task& operator=(const task&) = delete;
+
+		handle_t _handle;
+	};
+
+	// co_await next_frame(): resumes in the next frame, after the step event
+	struct next_frame {
+		bool await_ready() const noexcept { return false; }
+		void await_suspend(std::coroutine_handle<> handle_) const { System::coroutines().resume_next_frame(handle_); }
+		void await_resume() const noexcept {}
+	};
+
+	// co_await delay(ms): resumes in the first frame at least ms_ milliseconds from now
+	class delay {
+	public:
+		explicit delay(ticks_t ms_) : _ms(ms_) {}
+		bool await_ready() const noexcept { return false; }
+		void await_suspend(std::coroutine_handle<> handle_) const { System::coroutines().resume_at(clock_tick() + _ms, handle_); }
+		void await_resume() const noexcept {}
+	private:
+		ticks_t _ms;
+	};
+
+	// co_await on_main_thread(): continues on the main thread through System::post_main, right
+	// away when already there
+	struct on_main_thread {
+		bool await_ready() const noexcept { return System::is_main_thread(); }
+		void await_suspend(std::coroutine_handle<> handle_) const {
+			System::post_main([handle_] { handle_.resume(); }, main_thread_queue::PRIORITY_HIGH);
+		}
+		void await_resume() const noexcept {}
+	};
+
+	// co_await async_image(path): decodes the image on worker_pool::shared() (through
+	// System::asset_manager(), so loaded images are shared) and continues on the main thread.
+	// errors are rethrown by the co_await.
+	class async_image {
+	public:
+		explicit async_image(const std::string& filepath_) : _filepath(filepath_) {}
+
+		bool await_ready() const noexcept { return false; }
+		void await_suspend(std::coroutine_handle<> handle_);
+		shared_ptr<Image> await_resume() {
+			if (_error)
+				std::rethrow_exception(_error);
+			return std::move(_image);
+		}
+
+	private:
+		void load(); // on a worker_pool thread
+
+		std::string _filepath;
+		shared_ptr<Image> _image;
+		std::exception_ptr _error;
+		std::coroutine_handle<> _handle;
+	};
+
+}
+
+#endif
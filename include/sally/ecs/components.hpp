@@ -0,0 +1,45 @@
+#pragma once
+
+#include <sally/ecs/world.hpp>
+#include <sally/gfx.hpp>
+
+namespace sally {
+	namespace ecs {
+
+		// common components and systems, games are free to define their own instead
+
+		struct Position {
+			float _x, _y;
+		};
+
+		struct Velocity {
+			float _x, _y;
+		};
+
+		// part (_src) of a renderable drawn at the entity Position with the given size and tint
+		struct Sprite {
+			Renderable* _renderable;
+			Rect _src;
+			int _width, _height;
+			Color _tint;
+		};
+
+		// Position += Velocity * dt_, reads Velocity and writes Position
+		void integrate_velocity(World& world_, float dt_);
+
+		// draws every entity with Position and Sprite, one Renderer::render_batch per renderable.
+		// meant to be called from RenderProvider::render, scratch buffers are kept between frames.
+		class SpriteDrawer {
+		public:
+			void draw(World& world_, Renderer& renderer_, int offset_x_ = 0, int offset_y_ = 0);
+
+		private:
+			struct Batch {
+				std::vector<Rect> _src, _dst;
+				std::vector<Color> _tints;
+			};
+			std::unordered_map<Renderable*, Batch> _batches;
+		};
+
+	}
+}
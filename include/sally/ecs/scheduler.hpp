@@ -0,0 +1,51 @@
+#pragma once
+
+#include <sally/ecs/world.hpp>
+#include <string>
+
+namespace sally {
+
+	class worker_pool;
+
+	namespace ecs {
+
+		// runs systems over a World, in parallel where their component accesses allow it.
+		// every system declares the component types it reads and writes, systems are grouped into
+		// stages in registration order: a system joins the stage after the last one holding a
+		// conflicting system (it writes what the other reads or writes, or vice versa), so
+		// conflicting systems always run in registration order and each stage runs in parallel.
+		// deferred world changes are applied after the last stage.
+		class Scheduler {
+		public:
+			typedef std::function<void(World&)> system_fn;
+			static const signature_t ALL_COMPONENTS = ~signature_t(0); // for systems touching everything
+
+			// systems of parallel stages must not throw nor use pool_ themselves,
+			// systems alone in their stage run on the calling thread and may do both
+			void add(const std::string& name_, signature_t reads_, signature_t writes_, system_fn system_);
+			template <class... Reads> static signature_t reads() { return signature_of<Reads...>(); }
+			template <class... Writes> static signature_t writes() { return signature_of<Writes...>(); }
+
+			void run(World& world_, worker_pool* pool_ = nullptr);
+
+			size_t stage_count() const { return _stages.size(); }
+
+		private:
+			struct SystemEntry {
+				std::string _name;
+				signature_t _reads;
+				signature_t _writes;
+				system_fn _fn;
+			};
+
+			static bool conflict(const SystemEntry& a_, const SystemEntry& b_) {
+				return (a_._writes & (b_._reads | b_._writes)) || (b_._writes & a_._reads);
+			}
+
+			std::vector<SystemEntry> _systems;
+			std::vector<std::vector<size_t> > _stages; // indices into _systems
+		};
+
+	}
+
+}
@@ -0,0 +1,222 @@
+#pragma once
+
+#include <sally/common.hpp>
+#include <sally/util/threading.hpp>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <type_traits>
+#include <cstddef>
+
+namespace sally {
+
+	class worker_pool;
+
+	namespace ecs {
+
+		// entity handles hold the slot index in the low 32 bits and the slot generation in the
+		// high 32 bits, so handles of destroyed entities are detected even after slot reuse.
+		typedef uint64_t entity_t;
+		static const entity_t NULL_ENTITY = 0;
+
+		// one bit per component type
+		typedef uint64_t signature_t;
+		static const int MAX_COMPONENTS = 64;
+
+		namespace detail {
+			int register_component(size_t size_, size_t align_);
+			size_t component_size(int id_);
+			size_t component_align(int id_);
+
+			template <class T> struct component_registration {
+				static_assert(std::is_trivially_copyable<T>::value, "ecs components must be trivially copyable");
+				static_assert(alignof(T) <= alignof(std::max_align_t), "ecs components must not be over aligned");
+				static int id() {
+					static const int id = register_component(sizeof(T), alignof(T));
+					return id;
+				}
+			};
+		}
+
+		// components are plain data (trivially copyable) so chunks can move them around with memcpy.
+		// ids are assigned on first use, up to MAX_COMPONENTS types per process. const T has the id of T.
+		template <class T> int component_id() {
+			return detail::component_registration<typename std::remove_const<T>::type>::id();
+		}
+
+		template <class... C> signature_t signature_of() {
+			signature_t sig = 0;
+			const int ids[] = { 0, component_id<C>()... };
+			for (size_t ii = 1; ii < sizeof(ids) / sizeof(ids[0]); ++ii)
+				sig |= signature_t(1) << ids[ii];
+			return sig;
+		}
+
+		// all entities having exactly the same set of components. entities are packed in fixed size
+		// chunks holding one contiguous array per component (structure of arrays), all chunks but
+		// the last one are full.
+		class Archetype {
+		public:
+			static const size_t CHUNK_BYTES = 16 * 1024;
+
+			struct Chunk {
+				unique_ptr<std::max_align_t[]> _data;
+				size_t _count;
+			};
+
+			signature_t signature() const { return _signature; }
+			size_t capacity() const { return _capacity; } // entities per chunk
+			size_t size() const { return _size; }
+			size_t chunk_count() const { return _chunks.size(); }
+			Chunk& chunk(size_t index_) { return _chunks[index_]; }
+
+			entity_t* entities(Chunk& chunk_) { return reinterpret_cast<entity_t*>(chunk_._data.get()); }
+			template <class T> T* column(Chunk& chunk_) {
+				return reinterpret_cast<T*>(reinterpret_cast<uint8_t*>(chunk_._data.get()) + _offsets[component_id<T>()]);
+			}
+
+		private:
+			friend class World;
+
+			explicit Archetype(signature_t signature_);
+			Archetype(const Archetype&) = delete;
+			Archetype& operator=(const Archetype&) = delete;
+
+			void* cell(size_t chunk_, size_t row_, int component_) {
+				return reinterpret_cast<uint8_t*>(_chunks[chunk_]._data.get()) + _offsets[component_] + row_ * detail::component_size(component_);
+			}
+			// appends an (uninitialized) row for entity_, returns its position
+			void push(entity_t entity_, size_t& chunk_, size_t& row_);
+			// removes a row by moving the last row into it, returns the entity that moved (NULL_ENTITY if none)
+			entity_t erase(size_t chunk_, size_t row_);
+
+			signature_t _signature;
+			std::vector<int> _components;
+			size_t _offsets[MAX_COMPONENTS];
+			size_t _capacity;
+			size_t _chunk_words; // chunk size in max_align_t units
+			size_t _size;
+			std::vector<Chunk> _chunks;
+		};
+
+		// entity storage, grouped into archetypes.
+		// structural changes (create, destroy, add, remove) are not thread safe and must not happen
+		// while a query is iterating, use defer() from within systems. component values can be
+		// modified concurrently as long as no two threads write the same component type (see Scheduler).
+		class World {
+		public:
+			World();
+			~World();
+
+			entity_t create();
+			template <class... C> entity_t create(const C&... components_) {
+				entity_t ent = create_with(signature_of<C...>());
+				int dummy[] = { 0, (*get<C>(ent) = components_, 0)... };
+				(void)dummy;
+				return ent;
+			}
+			void destroy(entity_t entity_);
+			bool alive(entity_t entity_) const;
+			size_t size() const { return _alive; }
+
+			// adds the component (or overwrites it if already present)
+			template <class T> T& add(entity_t entity_, const T& value_ = T()) {
+				void* ptr = add_component(entity_, component_id<T>());
+				return *static_cast<T*>(ptr) = value_;
+			}
+			template <class T> void remove(entity_t entity_) { remove_component(entity_, component_id<T>()); }
+			template <class T> bool has(entity_t entity_) const {
+				const Record* rec = record(entity_);
+				return rec && (rec->_archetype->_signature & (signature_t(1) << component_id<T>()));
+			}
+			// nullptr if the entity is dead or does not have the component
+			template <class T> T* get(entity_t entity_) {
+				const Record* rec = record(entity_);
+				const int id = component_id<T>();
+				if (!rec || !(rec->_archetype->_signature & (signature_t(1) << id)))
+					return nullptr;
+				return static_cast<T*>(rec->_archetype->cell(rec->_chunk, rec->_row, id));
+			}
+
+			// archetypes having all of the components in signature_, the result is cached per signature
+			// and only extended when new archetypes appear
+			const std::vector<Archetype*>& query(signature_t signature_);
+
+			// fn_(size_t count, C* ...) once per chunk of the entities having all of C...,
+			// declare read only components const (i.e. each_chunk<const Position, Velocity>)
+			template <class... C, class F> void each_chunk(F&& fn_) {
+				for (Archetype* arch : query(signature_of<C...>()))
+					for (size_t ii = 0; ii < arch->chunk_count(); ++ii) {
+						Archetype::Chunk& chunk = arch->chunk(ii);
+						fn_(chunk._count, arch->column<C>(chunk)...);
+					}
+			}
+
+			// fn_(C& ...) for every entity having all of C...
+			template <class... C, class F> void each(F&& fn_) {
+				each_chunk<C...>([&fn_](size_t count_, C*... columns_) {
+					for (size_t ii = 0; ii < count_; ++ii)
+						fn_(columns_[ii]...);
+				});
+			}
+
+			// like each_chunk but chunks are processed in parallel on pool_ (fn_ must not throw)
+			template <class... C, class F> void each_chunk_parallel(worker_pool& pool_, F&& fn_) {
+				std::vector<Archetype::Chunk*>& chunks = _parallel_chunks;
+				std::vector<Archetype*>& owners = _parallel_owners;
+				chunks.clear();
+				owners.clear();
+				for (Archetype* arch : query(signature_of<C...>()))
+					for (size_t ii = 0; ii < arch->chunk_count(); ++ii) {
+						chunks.push_back(&arch->chunk(ii));
+						owners.push_back(arch);
+					}
+				run_parallel(pool_, chunks.size(), [&](size_t index_) {
+					Archetype::Chunk& chunk = *chunks[index_];
+					fn_(chunk._count, owners[index_]->template column<C>(chunk)...);
+				});
+			}
+
+			// structural changes requested while iterating, applied by flush_deferred (thread safe)
+			void defer(std::function<void(World&)> change_);
+			void flush_deferred();
+
+		private:
+			struct Record {
+				Archetype* _archetype; // nullptr for free slots
+				size_t _chunk;
+				size_t _row;
+				uint32_t _generation;
+			};
+			struct QueryCache {
+				std::vector<Archetype*> _archetypes;
+				size_t _scanned; // number of archetypes already checked
+			};
+
+			World(const World&) = delete;
+			World& operator=(const World&) = delete;
+
+			const Record* record(entity_t entity_) const;
+			Archetype& archetype(signature_t signature_);
+			entity_t create_with(signature_t signature_);
+			void* add_component(entity_t entity_, int component_);
+			void remove_component(entity_t entity_, int component_);
+			void move_entity(entity_t entity_, Archetype& to_);
+			void run_parallel(worker_pool& pool_, size_t count_, const std::function<void(size_t)>& task_);
+
+			std::vector<Record> _records;
+			std::vector<uint32_t> _free;
+			size_t _alive;
+			std::unordered_map<signature_t, unique_ptr<Archetype> > _archetypes;
+			std::vector<Archetype*> _archetype_list; // in creation order
+			std::unordered_map<signature_t, QueryCache> _queries;
+			spinlock _query_lock;
+			std::vector<std::function<void(World&)> > _deferred;
+			spinlock _deferred_lock;
+			std::vector<Archetype::Chunk*> _parallel_chunks;
+			std::vector<Archetype*> _parallel_owners;
+		};
+
+	}
+
+}
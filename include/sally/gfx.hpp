@@ -2,16 +2,20 @@
 
 #include <sally/common.hpp>
 #include <sally/util/threading.hpp>
+#include <sally/util/metrics.hpp>
+#include <sally/assets/font.hpp>
+#include <sally/assets/image.hpp>
 #include <vector>
 #include <unordered_map>
+#include <cmath>
 #include <SDL_atomic.h>
 #include <SDL_pixels.h>
-#include <SDL_ttf.h>
 
 struct SDL_Window;
 struct SDL_Renderer;
 struct SDL_Texture;
 struct SDL_Rect;
+struct SDL_Surface;
 
 namespace sally {
 
@@ -47,42 +51,12 @@ namespace sally {
 		const SDL_Rect& sdl_rect() const { return *reinterpret_cast<const SDL_Rect*>(this); }
 	};
 
-	class Font
-	{
-	public:
-		enum render_mode_t {
-			RENDER_SOLID,   // fastest but lowest quality (use for fast changing text)
-			RENDER_BLENDED  // antialiased with alpha transperancy (use for high quality unboxed text)
-		};
-
-		TTF_Font* sdl_font() const { return _font; }
-
-		void set_style(int style_);
-		int get_style() const;
-
-		int height() const;
-		int lineskip() const;
-
-		// calc_width return -1 on error
-		int calc_width(const char* utf8_) const;
-		int calc_width(const wchar_t* unicode_) const;
-
-		virtual ~Font();
-
-	private: // interface for FontManager
-		Font(const std::string& filepath_, int ptsize_, long index_);
-		friend class FontManager;
-
-	private:
-		TTF_Font* _font;
-	};
-
+	// fonts by name, loaded through the System's AssetManager so the same file and size
+	// is opened once no matter how many names refer to it
 	class FontManager
 	{
 	public:
-		Font* load_font(const std::string& name_, const std::string& filepath_, int ptsize_, long index_ = 0) {
-			Font* f = new Font(filepath_, ptsize_, index_); _map[name_].reset(f); return f;
-		}
+		Font* load_font(const std::string& name_, const std::string& filepath_, int ptsize_, long index_ = 0);
 
 		Font* lookup(const std::string& name_) {
 			auto find_it = _map.find(name_);
@@ -97,17 +71,38 @@ namespace sally {
 		void clear() { _map.clear(); }
 
 	private:
-		std::unordered_map<std::string, unique_ptr<Font> > _map;
+		std::unordered_map<std::string, shared_ptr<Font> > _map;
 	};
 
 	class Renderer;
+	class Window;
+	class SoftRaster;
+	class FrameCapture;
+	class HitIndex;
 
 	class Renderable {
 	public:
 		// texture_for_render and fill_bounding_rect should only be called from main thread
 		virtual SDL_Texture* texture_for_render(Renderer& renderer_) = 0;
 		virtual void fill_bounding_rect(Renderer& renderer_, Rect& rect_) = 0;
+
+		// texture memory accounting (see Renderer::set_texture_budget), main thread only.
+		// texture_bytes returns the size of the currently cached texture (0 if none).
+		// evict_texture releases the cached texture only if it can be regenerated on the
+		// next texture_for_render, returns true if anything was released.
+		virtual size_t texture_bytes() const { return 0; }
+		virtual bool evict_texture() { return false; }
+
+		// the part of the texture holding the content (nullptr: all of it), drawn when no clip rect is given
+		virtual const Rect* content_rect() const { return nullptr; }
+
+		Renderable() : _last_used_frame(0), _evicted(false) {}
 		virtual ~Renderable() = default;
+
+	private: // bookkeeping for Renderer
+		uint64_t _last_used_frame;
+		bool _evicted;
+		friend class Renderer;
 	};
 
 	class Texture : public Renderable {
@@ -117,27 +112,50 @@ namespace sally {
 
 		virtual SDL_Texture* texture_for_render(Renderer& renderer_);
 		virtual void fill_bounding_rect(Renderer& renderer_, Rect& rect_);
+		virtual size_t texture_bytes() const { return _bytes; }
 
 		Texture(SDL_Texture* texture_) : Texture() { reinit(texture_); }
 		virtual ~Texture() { reinit(nullptr); }
 
 	protected:
-		Texture() : _width(0), _height(0), _texture(nullptr) {}
+		Texture() : _width(0), _height(0), _bytes(0), _texture(nullptr) {}
 		void reinit(SDL_Texture* _texture);
 
 		int _width, _height;
+		size_t _bytes;
 		SDL_Texture* _texture;
 	};
 
+	// texture uploaded from a shared decoded Image, it is evictable since it can always be uploaded again
+	class ImageFile : public Texture {
+	public:
+		ImageFile(const shared_ptr<Image>& image_, SDL_Texture* texture_) : Texture(texture_), _image(image_) {}
+
+		const std::string& filepath() const { return _image->filepath(); }
+		const shared_ptr<Image>& image() const { return _image; }
+
+		virtual SDL_Texture* texture_for_render(Renderer& renderer_);
+		virtual bool evict_texture();
+
+	private:
+		const shared_ptr<Image> _image;
+	};
+
 	class TextLine : public Texture
 	{
 	public:
-		TextLine(Font* font_, const Color& color_, const std::string& utf8_, Font::render_mode_t mode_ = Font::RENDER_BLENDED)
-			: _font(font_), _mode(mode_), _text(utf8_), _color(color_), _cached({0})
+		enum update_mode_t {
+			UPDATE_RECREATE, // every change creates a new texture
+			UPDATE_STREAMING // one streaming texture with headroom, changes rewrite only the pixels that differ (for labels changing every frame)
+		};
+
+		TextLine(Font* font_, const Color& color_, const std::string& utf8_, Font::render_mode_t mode_ = Font::RENDER_BLENDED, update_mode_t update_ = UPDATE_RECREATE)
+			: _font(font_), _mode(mode_), _update(update_), _text(utf8_), _color(color_), _cached({0}), _tex_width(0), _tex_height(0), _last_update_pixels(0)
 		{}
 
 		// when seting text, width and height will update only on next render
-		void set_text(const std::string& utf8_) {
+		void set_text(const std::string& utf8_) { set_text(utf8_.c_str()); }
+		void set_text(const char* utf8_) { // does not allocate unless the text grows
 			spinlock::Guard lg(_lock);
 			if (_text != utf8_) { _text = utf8_; SDL_AtomicSet(&_cached, 0); }
 		}
@@ -151,25 +169,103 @@ namespace sally {
 
 		// cache and release texture should only be called from main thread
 		void cache_texture(Renderer& render_);
-		void release_texture() { reinit(0); SDL_AtomicSet(&_cached, 0); }
+		void release_texture();
+
+		// pixels written by the last streaming update (main thread)
+		size_t last_update_pixels() const { return _last_update_pixels; }
 
 		virtual SDL_Texture* texture_for_render(Renderer& renderer_);
 		virtual void fill_bounding_rect(Renderer& renderer_, Rect& rect_);
+		virtual bool evict_texture();
+		virtual const Rect* content_rect() const { return _tex_width ? &_content : nullptr; }
 
 	private:
+		// the software rasterizer draws from CPU copies, it always uses UPDATE_RECREATE
+		void stream_text(Renderer& renderer_, SDL_Surface* argb_);
+
 		Font* const _font;
 		const Font::render_mode_t _mode;
+		const update_mode_t _update;
 		std::string _text;
+		std::string _render_text; // copy of _text being rendered, reused between updates
 		Color _color;
 		SDL_atomic_t _cached;
 		mutable spinlock _lock;
+		// streaming state:
+		int _tex_width, _tex_height;   // 0 when not streaming
+		Rect _content;
+		std::vector<uint32_t> _shadow; // ARGB copy of the texture, changed pixels are found against it
+		size_t _last_update_pixels;
 	};
 
 	class Renderer { // only exists within a Window context
 	public:
-		Texture* load_image(const std::string& name_, const std::string& filepath_) {
-			return insert(name_, new Texture(image_from_file(filepath_)));
-		}
+		struct TextureStats {
+			uint64_t hits;      // draws served by an already resident texture
+			uint64_t reuploads; // draws which had to regenerate an evicted texture
+			uint64_t evictions; // textures released to stay within the budget
+			size_t bytes;       // texture bytes held by named renderables (as of last end_render)
+			size_t budget;      // 0 means unlimited
+
+			TextureStats() : hits(0), reuploads(0), evictions(0), bytes(0), budget(0) {}
+		};
+
+		// dynamic resolution: frames are drawn at render_scale() of the output size into an internal
+		// target which is upscaled when presenting. the scale drops by step after hysteresis frames
+		// over target_ms and rises again after hysteresis frames where the frame time, extrapolated
+		// to the larger scale, still fits within target_ms. target_ms 0 disables it.
+		struct DynamicResolution {
+			float target_ms;
+			float min_scale, max_scale; // max_scale at most 1
+			float step;
+			int hysteresis;             // frames
+
+			DynamicResolution() : target_ms(0), min_scale(0.5f), max_scale(1), step(0.05f), hysteresis(8) {}
+		};
+
+		// maps drawing coordinates to window coordinates: p * _zoom + (_x, _y)
+		struct Transform {
+			float _x, _y, _zoom;
+
+			Transform(float x_ = 0, float y_ = 0, float zoom_ = 1) : _x(x_), _y(y_), _zoom(zoom_) {}
+
+			// inner_ applied first, then this
+			Transform then(const Transform& inner_) const { return Transform(_x + inner_._x * _zoom, _y + inner_._y * _zoom, _zoom * inner_._zoom); }
+			bool identity() const { return _x == 0 && _y == 0 && _zoom == 1; }
+			int apply_x(int x_) const { return static_cast<int>(std::floor(x_ * _zoom + _x + 0.5f)); }
+			int apply_y(int y_) const { return static_cast<int>(std::floor(y_ * _zoom + _y + 0.5f)); }
+			// edges are rounded so adjacent rects stay adjacent
+			Rect apply(const Rect& rect_) const {
+				const int x0 = apply_x(rect_._x), y0 = apply_y(rect_._y);
+				return Rect(x0, y0, apply_x(rect_._x + rect_._width) - x0, apply_y(rect_._y + rect_._height) - y0);
+			}
+		};
+
+		struct DrawStats {
+			uint64_t draws;  // fill_rect, draw_line, render calls and render_batch quads
+			uint64_t culled; // of those, rejected without drawing since they were outside the clip
+
+			DrawStats() : draws(0), culled(0) {}
+		};
+
+		class TransformGuard {
+		public:
+			TransformGuard(Renderer& renderer_, const Transform& transform_) : _renderer(renderer_) { _renderer.push_transform(transform_); }
+			~TransformGuard() { _renderer.pop_transform(); }
+		private:
+			Renderer& _renderer;
+		};
+
+		class ClipGuard {
+		public:
+			ClipGuard(Renderer& renderer_, const Rect& clip_) : _renderer(renderer_) { _renderer.push_clip(clip_); }
+			~ClipGuard() { _renderer.pop_clip(); }
+		private:
+			Renderer& _renderer;
+		};
+
+		// the decoded image is shared with other renderers loading the same file (see AssetManager)
+		Texture* load_image(const std::string& name_, const std::string& filepath_);
 
 		Texture* render_text(const std::string& name_, Font* font_, const Color& color_, const std::string& utf8_, Font::render_mode_t mode_ = Font::RENDER_BLENDED) {
 			return insert(name_, new Texture(render_sdl_text(font_, color_, utf8_, mode_)));
@@ -178,18 +274,22 @@ namespace sally {
 		// renderable_ will be deleted by this object; replaces existing values
 		template<typename R>
 		R* insert(const std::string& name_, R* renderable_) {
-			spinlock::Guard lg(_lock);
+			shared_mutex::Guard lg(_lock);
 			_map[name_].reset(renderable_);
 			return renderable_;
 		}
 
 		void erase(const std::string& name_) {
-			spinlock::Guard lg(_lock);
+			shared_mutex::Guard lg(_lock);
 			_map.erase(name_);
 		}
 
+		// creates the texture of a named renderable ahead of drawing it (main thread only), i.e. from
+		// a System::post_main task so uploads spread over frames. returns false if name_ is unknown.
+		bool preload(const std::string& name_);
+
 		Renderable* lookup(const std::string& name_) {
-			spinlock::Guard lg(_lock);
+			shared_mutex::SharedGuard lg(_lock);
 			auto find_it = _map.find(name_);
 			return find_it != _map.end() ? find_it->second.get() : nullptr;
 		}
@@ -198,42 +298,188 @@ namespace sally {
 			{ render_impl(renderable_, dst_, clip_, false); }
 		void render(const std::string& name_, const Rect& dst_, Rect* clip_ = nullptr)
 			{ render_impl(render_lookup(name_), dst_, clip_, false); }
+		void render(const char* name_, const Rect& dst_, Rect* clip_ = nullptr)
+			{ render_impl(render_lookup(name_), dst_, clip_, false); }
 		void render(Renderable* renderable_, int x_, int y_, Rect* clip_ = nullptr)
 			{ render_impl(renderable_, Rect(x_,y_,0,0), clip_, true); }
 		void render(const std::string& name_, int x_, int y_, Rect* clip_ = nullptr)
 			{ render_impl(render_lookup(name_), Rect(x_,y_,0,0), clip_, true); }
+		void render(const char* name_, int x_, int y_, Rect* clip_ = nullptr)
+			{ render_impl(render_lookup(name_), Rect(x_,y_,0,0), clip_, true); }
+
+		// draws count_ parts of one renderable as a single batch (one draw call when not using the
+		// software rasterizer). src_[i] is drawn to dst_[i] modulated by tints_[i] (tints_ may be nullptr).
+		void render_batch(Renderable* renderable_, const Rect* src_, const Rect* dst_, const Color* tints_, size_t count_);
+		// render_batch for callers which placed the quads themselves (see place()): dst_ is in
+		// window coordinates and visible, culled_ quads the caller rejected count as culled draws
+		void render_batch_placed(Renderable* renderable_, const Rect* src_, const Rect* dst_, const Color* tints_, size_t count_, size_t culled_);
 
 		Color draw_color();
 		void draw_color(const Color& color_);
 		void fill_rect(const Rect& rect_);
 		void draw_line(int x1_, int y1_, int x2_, int y2_);
 
-		void clear();
+		void clear(); // ignores clips
 		void clear(const Color& color_) { Color prev = draw_color(); draw_color(color_); clear(); draw_color(prev); }
 
-		void begin_render() {}
+		// the camera is the bottom of the transform stack and stays set across frames: the world
+		// point (x_, y_) is drawn at the window's top left corner, magnified by zoom_
+		void set_camera(float x_, float y_, float zoom_ = 1);
+		// nested transforms and clips apply to all drawing calls, draws wholly outside the clip (or
+		// the window) are culled before reaching SDL. pushed transforms are relative to the current
+		// one, push_absolute_transform ignores the camera (i.e. for overlays). clips are given in
+		// current coordinates and intersected with the enclosing clip. begin_render resets both stacks.
+		void push_transform(const Transform& transform_) { set_transform(transform().then(transform_)); }
+		void push_absolute_transform(const Transform& transform_) { set_transform(transform_); }
+		void pop_transform();
+		const Transform& transform() const { return _transforms.back(); }
+		void push_clip(const Rect& clip_);
+		void pop_clip();
+		// clips to rect_ and draws relative to its top left corner
+		void push_viewport(const Rect& rect_) { push_clip(rect_); push_transform(Transform(float(rect_._x), float(rect_._y))); }
+		void pop_viewport() { pop_transform(); pop_clip(); }
+		// false if drawing to rect_ (in current coordinates) would be culled, to skip preparing invisible draws
+		bool visible(const Rect& rect_) const { return overlaps(_transformed ? transform().apply(rect_) : rect_, _cull); }
+		// transforms rect_ to window coordinates, false if it would be culled (for render_batch_placed)
+		bool place(Rect& rect_) const {
+			if (_transformed)
+				rect_ = transform().apply(rect_);
+			return overlaps(rect_, _cull);
+		}
+		// window position in current coordinates (i.e. for mouse picking in a scrolled scene)
+		void to_local(int x_, int y_, float& local_x_, float& local_y_) const {
+			local_x_ = (x_ - transform()._x) / transform()._zoom;
+			local_y_ = (y_ - transform()._y) / transform()._zoom;
+		}
+		// draws of the last completed frame
+		const DrawStats& draw_stats() const { return _last_draws; }
+
+		void begin_render();
 		void end_render();
+		// performance counter time the last end_render spent in SDL_RenderPresent
+		uint64_t last_present_ticks() const { return _present_ticks; }
 
 		// usefull to get render width and height (at least currently, x and y will always be 0).
 		Rect output_rect() const;
 
-	public: // interface for text renderables
+		// number of frames begun so far, used for least recently used texture eviction
+		uint64_t frame() const { return _frame; }
+
+		// limits the texture memory held by the named renderables of this renderer (0 for unlimited).
+		// the budget is enforced at end_render by evicting the least recently used evictable
+		// textures (see Renderable::evict_texture), textures used in the current frame are never evicted.
+		void set_texture_budget(size_t bytes_) { _stats.budget = bytes_; }
+		const TextureStats& texture_stats() const { return _stats; }
+
+		// see DynamicResolution, output_rect() and drawing coordinates are not affected by the scale
+		void set_dynamic_resolution(const DynamicResolution& config_);
+		const DynamicResolution& dynamic_resolution() const { return _dynres; }
+		// scale of the frames currently drawn (1 is full resolution)
+		float render_scale() const { return _scale; }
+		// feeds the time spent drawing a frame (excluding waiting for vsync) to the scale controller,
+		// called by Window::render
+		void adapt_resolution(double frame_ms_);
+
+		// true if drawing is done by Sally's own CPU rasterizer (see Window::FLG_SOFTWARE_RASTER)
+		bool software_raster() const { return _soft != nullptr; }
+
+		// every frame is handed to capture_ right before it is presented (nullptr to stop capturing).
+		// the capture object is not owned and must outlive the renderer or be unset first.
+		void set_frame_capture(FrameCapture* capture_) { _capture = capture_; }
+
+		// copies the current frame as RGBA bytes (SDL_PIXELFORMAT_RGBA32) into dst_, returns false on failure.
+		// dst_ must hold output_rect()._height rows of pitch_ bytes.
+		bool read_pixels(void* dst_, int pitch_);
+
+	public: // interface for renderables
 		SDL_Texture* render_sdl_text(Font* font_, const Color& color_, const std::string& utf8_, Font::render_mode_t mode_);
+		// text as an ARGB8888 surface, the caller frees it
+		SDL_Surface* render_text_surface(Font* font_, const Color& color_, const std::string& utf8_, Font::render_mode_t mode_);
+		// native_format() texture rewritten in place with update_texture (not with the software rasterizer)
+		SDL_Texture* create_streaming_texture(int width_, int height_);
+		// writes ARGB pixels into rect_ of a streaming texture, pitch_ in bytes
+		void update_texture(SDL_Texture* texture_, const Rect& rect_, const uint32_t* argb_, int pitch_);
+		SDL_Texture* texture_from_image(const Image& image_);
+		// creates a texture usable by this renderer (surface_ is not freed). 32 bit ARGB/ABGR surfaces
+		// are uploaded straight into native_format(), others go through SDL's generic conversion.
+		// premultiply_ uploads premultiplied colors with a matching blend mode (when the renderer
+		// supports it and not with the software rasterizer, which blends straight alpha).
+		SDL_Texture* texture_from_surface(SDL_Surface* surface_, bool premultiply_ = false);
+		// texture layout uploads are converted to, picked from SDL_GetRendererInfo at initialization
+		uint32_t native_format() const { return _native_format; }
+		// textures created by the renderer must be destroyed with destroy_texture
+		static void destroy_texture(SDL_Texture* texture_);
+
+		// render targets (alpha blended textures drawing can be redirected to), not available
+		// with the software rasterizer. set_render_target(nullptr) restores drawing to the window.
+		// a texture target starts without transform (camera included) and clips, the window's
+		// transform and clip stacks are restored with it.
+		bool supports_render_targets() const;
+		SDL_Texture* create_target_texture(int width_, int height_);
+		SDL_Texture* render_target() const;
+		void set_render_target(SDL_Texture* target_);
 
 	private: // interface for Window
-		Renderer() : _renderer(nullptr) {}
-		void initialize(SDL_Window* window_);
+		Renderer();
+		void initialize(SDL_Window* window_, bool software_raster_);
+		void initialize_offscreen(int width_, int height_, bool software_raster_);
 		virtual ~Renderer();
 		SDL_Renderer* _renderer;
 		friend class Window;
 
 	private:
 		Renderable* render_lookup(const std::string& name_);
+		Renderable* render_lookup(const char* name_); // main thread only, reuses _lookup_key
+		SDL_Texture* texture_for_render(Renderable* renderable_);
 		void render_impl(Renderable* renderable_, const Rect& dst_, Rect* clip_, bool override_dst_wh_);
-		SDL_Texture* image_from_file(const std::string& filepath_);
+		void enforce_texture_budget();
+		bool soft_draw_blend();
+		void init_software_raster();
+		void choose_native_format();
+		SDL_Texture* upload_argb(SDL_Surface* surface_, bool premultiply_);
+		Rect scaled(const Rect& rect_) const; // drawing to internal target coordinates
+		static bool overlaps(const Rect& a_, const Rect& b_) {
+			return a_._width > 0 && a_._height > 0 && a_._x < b_._x + b_._width && b_._x < a_._x + a_._width
+				&& a_._y < b_._y + b_._height && b_._y < a_._y + a_._height;
+		}
+		bool accept(Rect& rect_); // transforms rect_ to window coordinates, false (and counted) if culled
+		void submit_batch(Renderable* renderable_, const Rect* src_, const Rect* dst_, const Color* tints_, size_t count_); // placed quads
+		void set_transform(const Transform& transform_);
+		void reset_view();
+		void apply_clip();
+		void set_scaled_target();
+		bool ensure_scaled_target(const Rect& output_);
 
 		std::unordered_map<std::string, unique_ptr<Renderable> > _map;
-		mutable spinlock _lock;
+		mutable shared_mutex _lock; // lookups from several threads do not serialize
+		uint64_t _frame;
+		unique_ptr<SoftRaster> _soft;
+		SDL_Texture* _soft_target; // streaming texture the software rasterizer output is uploaded to
+		SDL_Surface* _offscreen;   // render target of offscreen renderers
+		uint32_t _native_format;
+		uint64_t _present_ticks;
+		DynamicResolution _dynres;
+		float _scale;              // for the next frames
+		float _frame_scale;        // of the frame being drawn
+		int _over, _under;         // consecutive frames over target / with room to scale up
+		Rect _scaled_rect;         // part of the internal target drawn this frame
+		SDL_Texture* _scaled_target; // internal target without the software rasterizer
+		Transform _camera;
+		std::vector<Transform> _transforms; // never empty, the back is the current transform
+		bool _transformed;                  // the current transform is not the identity
+		std::vector<Rect> _clips;           // in window coordinates, each within the previous
+		std::vector<Transform> _window_transforms; // the window's stacks while a texture is the render target
+		std::vector<Rect> _window_clips;
+		bool _window_view_saved;
+		Rect _target_bounds;                // of the window or the render target
+		Rect _cull;                         // current clip within _target_bounds
+		DrawStats _draws, _last_draws;
+		FrameCapture* _capture;
+		TextureStats _stats;
+		std::vector<Renderable*> _evict_candidates; // kept to avoid reallocating every frame
+		std::string _lookup_key;
+		struct BatchBuffers;
+		unique_ptr<BatchBuffers> _batch;
 	};
 
 	class RenderProvider {
@@ -265,15 +511,18 @@ namespace sally {
 			FLG_DEFAULT = 0,
 			FLG_FULLSCREEN = 1, // obeys width and height
 			FLG_FULLSCREEN_DESKTOP = 2, // use desktop width and height
-			FLG_BORDERLESS = 4
+			FLG_BORDERLESS = 4,
+			FLG_SOFTWARE_RASTER = 8, // draw with Sally's tile parallel CPU rasterizer, SDL is only used to present
+			FLG_OFFSCREEN = 16 // no visible window, renders into a memory surface (i.e. for headless frame capture)
 		};
 
-		// use width & height = -1 for full screen
+		// use width & height = -1 for full screen (ignored for offscreen windows)
 		Window(const char* title_, int width_, int height_, flags_t flags_, RenderProvider* rprovider_);
 		~Window();
 
 		Renderer& renderer() { return _renderer; }
 
+		bool offscreen() const { return _window == nullptr; }
 		int width() const { return _width; }
 		int height() const { return _height; }
 		id_t id() const { return _id; }
@@ -284,6 +533,14 @@ namespace sally {
 		bool render_pending() const;
 		void render();
 
+		// optional spatial index of clickable objects, when enabled mouse events sent
+		// to this window carry the topmost object under the cursor (see HitIndex).
+		HitIndex& enable_hit_index(int cell_size_ = 64);
+		HitIndex* hit_index() { return _hit_index.get(); }
+
+		// renders at a resolution adapting to the measured frame time (see Renderer::DynamicResolution)
+		void set_dynamic_resolution(const Renderer::DynamicResolution& config_) { _renderer.set_dynamic_resolution(config_); }
+
 	private:
 		int _width, _height;
 		id_t _id;
@@ -294,6 +551,12 @@ namespace sally {
 		Renderer _renderer;
 		RenderProvider* const _rprovider; // const to avoid multi-threading issues
 		SDL_atomic_t _render_pending;
+		unique_ptr<HitIndex> _hit_index;
+		histogram* _render_time;  // metrics, registered on first render
+		gauge* _texture_bytes;
+		gauge* _render_scale;
+		counter* _draws;
+		counter* _culled_draws;
 	};
 
 	class WindowManager
@@ -304,6 +567,7 @@ namespace sally {
 
 		void render_all_pending();
 		void invalidate_all();
+		bool render_pending() const; // any window
 
 		Window* window_by_id(Window::id_t id_) {
 			auto find_it = _windows.find(id_);
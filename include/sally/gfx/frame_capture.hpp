@@ -0,0 +1,81 @@
+#pragma once
+
+#include <sally/common.hpp>
+#include <vector>
+#include <deque>
+#include <cstdio>
+
+struct SDL_Thread;
+struct SDL_mutex;
+struct SDL_cond;
+
+namespace sally {
+
+	class Renderer;
+
+	// asynchronous frame capture (see Renderer::set_frame_capture).
+	// the render thread only copies each finished frame into one of a few preallocated
+	// buffers, conversion, encoding and writing are done on background threads.
+	class FrameCapture {
+	public:
+		enum format_t {
+			FORMAT_RGBA, // raw RGBA frames appended to a single file
+			FORMAT_Y4M,  // YUV4MPEG2 stream (4:2:0, full range BT.601), readable by most video tools
+			FORMAT_PNG   // one png per frame, path_ must contain a single %d for the frame number
+		};
+
+		struct Stats {
+			uint64_t _captured;  // frames read back from the renderer
+			uint64_t _written;   // frames fully written
+			uint64_t _dropped;   // frames skipped because all buffers were busy (only if drop_when_busy)
+			double _readback_ms; // total time spent on the render thread reading back frames
+			double _write_ms;    // total time spent by the writer threads
+
+			Stats() : _captured(0), _written(0), _dropped(0), _readback_ms(0), _write_ms(0) {}
+		};
+
+		// buffers_ is the number of frames which can be in flight, at least 2 (double buffering).
+		// if drop_when_busy_ is false capture waits for a free buffer instead of dropping the frame.
+		FrameCapture(const std::string& path_, format_t format_, int fps_ = 60, int buffers_ = 3, bool drop_when_busy_ = false);
+		~FrameCapture(); // blocks until all captured frames are written
+
+		Stats stats() const;
+
+	public: // interface for Renderer
+		void capture(Renderer& renderer_);
+
+	private:
+		struct Frame {
+			std::vector<uint8_t> _rgba;
+			int _width, _height;
+			uint64_t _index;
+		};
+
+		FrameCapture(const FrameCapture&) = delete;
+		FrameCapture& operator=(const FrameCapture&) = delete;
+
+		static int writer_main(void* self_);
+		void writer_loop();
+		void write_frame(Frame& frame_, std::vector<uint8_t>& scratch_);
+		void shutdown();
+
+		const std::string _path;
+		const format_t _format;
+		const int _fps;
+		const bool _drop_when_busy;
+		std::FILE* _stream; // FORMAT_RGBA and FORMAT_Y4M
+		bool _header_written;
+
+		std::vector<unique_ptr<Frame> > _frames;
+		std::vector<Frame*> _free;
+		std::deque<Frame*> _ready;
+		std::vector<SDL_Thread*> _writers;
+		SDL_mutex* _mutex;
+		SDL_cond* _frame_ready;
+		SDL_cond* _frame_free;
+		bool _quit;
+		uint64_t _next_index;
+		Stats _stats;
+	};
+
+}
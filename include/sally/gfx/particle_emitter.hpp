@@ -0,0 +1,88 @@
+#pragma once
+
+#include <sally/common.hpp>
+#include <sally/gfx.hpp>
+#include <vector>
+
+namespace sally {
+
+	// short lived particles sharing one texture, stored as structure of arrays in a pool whose
+	// size is fixed at creation. update() integrates velocity, position, life, colour and size
+	// four particles at a time (SSE2 where available) and recycles dead particles by moving the
+	// last live one into their slot, so steady state frames never allocate. render() submits
+	// every live particle as a single Renderer::render_batch, i.e. one SDL_RenderGeometry call.
+	// like the Renderer, emitters should only be updated and rendered from the main thread
+	// (or while holding the RenderProvider lock).
+	class ParticleEmitter {
+	public:
+		struct Config {
+			size_t capacity;            // live particles at most, emitting into a full pool drops particles
+			float rate;                 // particles per second emitted by update(), 0 for bursts only
+			float life_min, life_max;   // seconds
+			float speed_min, speed_max; // pixels per second
+			float angle, spread;        // direction and half the emission cone, radians (0 is +x, y grows down)
+			float gravity_x, gravity_y; // pixels per second squared
+			float size_start, size_end; // pixels, interpolated over each particle's life
+			Color color_start, color_end;
+			Rect src;                   // region of the texture, empty for all of it
+
+			Config()
+				: capacity(4096), rate(0), life_min(0.5f), life_max(1.0f), speed_min(20), speed_max(60),
+				  angle(-1.5707963f), spread(3.1415926f), gravity_x(0), gravity_y(0), size_start(8), size_end(8),
+				  color_start(255, 255, 255, 255), color_end(255, 255, 255, 0), src(0, 0, 0, 0)
+			{}
+		};
+
+		// the texture is not owned and must outlive the emitter
+		ParticleEmitter(Renderable* texture_, const Config& config_);
+
+		// where new particles are born
+		void set_position(float x_, float y_) { _origin_x = x_; _origin_y = y_; }
+		void set_rate(float rate_) { _config.rate = rate_; }
+		const Config& config() const { return _config; }
+
+		// emits count_ particles at once, returns how many fit into the pool
+		size_t burst(size_t count_);
+		// emits at the configured rate, then advances every particle by dt_ seconds
+		void update(float dt_);
+		// draws all live particles offset by (offset_x_,offset_y_)
+		void render(Renderer& renderer_, int offset_x_ = 0, int offset_y_ = 0);
+		void clear() { _alive = 0; }
+
+		size_t alive() const { return _alive; }
+		size_t capacity() const { return _config.capacity; }
+		uint64_t dropped() const { return _dropped; } // emitted while the pool was full
+
+		// live particles, indices [0,alive()) (recycling moves particles between indices)
+		const float* pos_x() const { return _x.data(); }
+		const float* pos_y() const { return _y.data(); }
+		const float* size() const { return _size.data(); }
+
+	private:
+		ParticleEmitter(const ParticleEmitter&) = delete;
+		ParticleEmitter& operator=(const ParticleEmitter&) = delete;
+
+		float random(float lo_, float hi_);
+		void spawn(size_t index_);
+		void integrate(float dt_);
+		void recycle();
+
+		Renderable* const _texture;
+		Config _config;
+		float _origin_x, _origin_y;
+		float _emit_carry; // fraction of a particle left over from the last update
+		uint32_t _rng;
+		size_t _alive;
+		uint64_t _dropped;
+
+		// the pool, capacity rounded up to a multiple of four so the integration has no tail
+		std::vector<float> _x, _y, _vx, _vy;
+		std::vector<float> _age, _inv_life;
+		std::vector<float> _r, _g, _b, _a, _size;
+
+		// render() scratch, sized once at creation
+		std::vector<Rect> _src, _dst;
+		std::vector<Color> _tints;
+	};
+
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <sally/common.hpp>
+
+namespace sally {
+
+	// conversions between the 32 bit layouts used for texture uploads. pixels are handled as
+	// native endian uint32_t with alpha in the top byte (ARGB8888 or ABGR8888).
+	// SSE2/AVX2 are chosen at compile time, the scalar versions produce identical results.
+	// src_ and dst_ may be the same buffer.
+	namespace pixel_kernels {
+		// ARGB8888 <-> ABGR8888 (i.e. RGBA <-> BGRA byte order)
+		void swap_rb(const uint32_t* src_, uint32_t* dst_, size_t count_);
+		// scales the color channels by alpha (rounded), alpha is kept
+		void premultiply(const uint32_t* src_, uint32_t* dst_, size_t count_);
+		// 8 bit coverage (i.e. a glyph) to color_ with alpha = coverage * color_ alpha / 255
+		void alpha_to_argb(const uint8_t* src_, uint32_t* dst_, size_t count_, uint32_t color_);
+
+		void swap_rb_scalar(const uint32_t* src_, uint32_t* dst_, size_t count_);
+		void premultiply_scalar(const uint32_t* src_, uint32_t* dst_, size_t count_);
+		void alpha_to_argb_scalar(const uint8_t* src_, uint32_t* dst_, size_t count_, uint32_t color_);
+
+		// name of the instruction set compiled into the kernels
+		const char* isa();
+	}
+
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <sally/common.hpp>
+#include <sally/gfx.hpp>
+#include <SDL_atomic.h>
+
+namespace sally {
+
+	// render provider drawing from a snapshot of State instead of locking shared scene data.
+	// producer threads edit back() and publish() it, the renderer picks up the latest published
+	// state when a frame starts and draws from it while producers keep editing the next one.
+	// three State buffers rotate through an atomic index, so neither side ever waits for the
+	// other and a frame never sees a half updated state. State must be copy assignable.
+	//
+	// back() and publish() may be used by one producer at a time (serialize several producers
+	// with a lock of their own, it is never contended by rendering). publish() copies the
+	// published state into the next back buffer so producers keep editing incrementally.
+	template <class State>
+	class SnapshotRenderProvider : public RenderProvider {
+	public:
+		SnapshotRenderProvider() : _back(0), _front(1), _ready({ 2 }), _published({ 0 }) {}
+		explicit SnapshotRenderProvider(const State& initial_) : SnapshotRenderProvider() {
+			_states[0] = _states[1] = _states[2] = initial_;
+		}
+
+		State& back() { return _states[_back]; }
+
+		// makes back() the state the next frame draws, call Window::invalidate to get one drawn
+		void publish() {
+			const int published = _back;
+			_back = SDL_AtomicSet(&_ready, published | FRESH) & ~FRESH;
+			_states[_back] = _states[published];
+			SDL_AtomicIncRef(&_published);
+		}
+
+		// number of publish calls so far
+		int published() const { return SDL_AtomicGet(&_published); }
+
+		// draws state_, which stays unchanged for the whole call
+		virtual void render_snapshot(Window& win_, const State& state_) = 0;
+
+		virtual void render(Window& win_) {
+			if (SDL_AtomicGet(&_ready) & FRESH)
+				_front = SDL_AtomicSet(&_ready, _front) & ~FRESH;
+			render_snapshot(win_, _states[_front]);
+		}
+
+	private:
+		enum { FRESH = 4 }; // set in _ready while its state was not picked up by the renderer
+
+		State _states[3];
+		int _back;          // owned by the producer
+		int _front;         // owned by the renderer
+		SDL_atomic_t _ready;
+		mutable SDL_atomic_t _published;
+	};
+
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <sally/common.hpp>
+#include <sally/gfx.hpp>
+#include <vector>
+#include <algorithm>
+
+struct SDL_Surface;
+
+namespace sally {
+
+	class worker_pool;
+
+	// CPU rasterizer behind the software render backend (see Window::FLG_SOFTWARE_RASTER).
+	// draw calls are only recorded and binned per tile, flush() rasterizes the tiles in
+	// parallel. the framebuffer and blit sources are ARGB8888, blending matches SDL's
+	// SDL_BLENDMODE_BLEND (up to rounding).
+	class SoftRaster {
+	public:
+		static const int TILE_SIZE = 64;
+
+		SoftRaster(int width_, int height_);
+		~SoftRaster();
+
+		int width() const { return _width; }
+		int height() const { return _height; }
+		const uint32_t* pixels() const { return _pixels.data(); }
+		int pitch() const { return _width * 4; }
+
+		// limits rasterization to the top left width_ x height_ pixels (i.e. for rendering at a
+		// reduced resolution), applies to commands submitted afterwards
+		void set_active_size(int width_, int height_) {
+			_active_width = std::max(0, std::min(width_, _width));
+			_active_height = std::max(0, std::min(height_, _height));
+		}
+		int active_width() const { return _active_width; }
+		int active_height() const { return _active_height; }
+
+		// restricts the following draw commands (not clear) to clip_, nullptr for no clipping
+		void set_clip(const Rect* clip_) {
+			_clipped = clip_ != nullptr;
+			if (clip_)
+				_clip = *clip_;
+		}
+
+		void clear(uint32_t argb_);
+		void fill_rect(const Rect& rect_, uint32_t argb_, bool blend_);
+		void draw_line(int x1_, int y1_, int x2_, int y2_, uint32_t argb_, bool blend_);
+		// src_ must be ARGB8888, it is referenced (not copied) until the next flush. the source
+		// pixels are modulated by tint_ (ARGB, like SDL's texture color and alpha mod)
+		void blit(SDL_Surface* src_, const Rect& src_rect_, const Rect& dst_rect_, bool blend_, uint32_t tint_ = 0xffffffff);
+
+		// rasterizes all recorded commands into the framebuffer
+		void flush(worker_pool& pool_);
+
+		size_t pending_commands() const { return _commands.size(); }
+
+		static uint32_t argb(const Color& color_) {
+			return (uint32_t(color_._a) << 24) | (uint32_t(color_._r) << 16) | (uint32_t(color_._g) << 8) | color_._b;
+		}
+
+	private:
+		enum command_type { CMD_CLEAR, CMD_FILL, CMD_LINE, CMD_BLIT };
+
+		struct Command {
+			command_type _type;
+			bool _blend;
+			uint32_t _color;       // CMD_BLIT: tint
+			Rect _dst;             // CMD_FILL/CMD_BLIT destination, CMD_LINE end points as x,y -> width,height
+			Rect _src;             // CMD_BLIT source rect
+			SDL_Surface* _surface; // CMD_BLIT source (reference held until flush)
+			Rect _clip;            // pixels the command may touch (within the active area)
+		};
+
+		SoftRaster(const SoftRaster&) = delete;
+		SoftRaster& operator=(const SoftRaster&) = delete;
+
+		Rect command_clip() const;
+		void bin(uint32_t cmd_, int x0_, int y0_, int x1_, int y1_); // bounding box in pixels (exclusive)
+		void rasterize_tile(size_t tile_);
+		void release_commands();
+
+		int _width, _height;
+		int _tiles_x, _tiles_y;
+		int _active_width, _active_height;
+		bool _clipped;
+		Rect _clip;
+		std::vector<uint32_t> _pixels;
+		std::vector<Command> _commands;
+		std::vector<std::vector<uint32_t> > _bins; // command indices per tile, in submission order
+	};
+
+	// pixel kernels used by SoftRaster, exposed for benchmarking and validation.
+	// SSE2/AVX2 are chosen at compile time, the scalar versions produce identical results.
+	namespace soft_kernels {
+		void fill_row(uint32_t* dst_, int count_, uint32_t argb_);
+		void blend_row(uint32_t* dst_, const uint32_t* src_, int count_);
+		void blend_color_row(uint32_t* dst_, int count_, uint32_t argb_);
+		// dst_[i] = src_[i] with each channel scaled by the one of argb_
+		void modulate_row(uint32_t* dst_, const uint32_t* src_, int count_, uint32_t argb_);
+
+		void blend_row_scalar(uint32_t* dst_, const uint32_t* src_, int count_);
+		void blend_color_row_scalar(uint32_t* dst_, int count_, uint32_t argb_);
+		void modulate_row_scalar(uint32_t* dst_, const uint32_t* src_, int count_, uint32_t argb_);
+
+		// name of the instruction set compiled into the kernels
+		const char* isa();
+	}
+
+}
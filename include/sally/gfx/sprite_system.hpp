@@ -0,0 +1,83 @@
+#pragma once
+
+#include <sally/common.hpp>
+#include <sally/gfx.hpp>
+#include <vector>
+
+namespace sally {
+
+	class worker_pool;
+
+	// large numbers of animated sprites sharing one atlas, stored as structure of arrays.
+	// the atlas is a grid of equally sized frames (left to right, top to bottom), every sprite
+	// plays frame_count consecutive frames starting at first_frame at its own rate.
+	// update() integrates positions and animation phases in plain loops over the arrays (which
+	// the compiler vectorizes), render() culls and submits all sprites, ordered by layer, as a
+	// single Renderer::render_batch. the arrays can also be modified directly, i.e. pos_x()[i] = ...
+	// like the Renderer, sprites should only be modified and rendered from the main thread
+	// (or while holding the RenderProvider lock).
+	class SpriteSystem {
+	public:
+		typedef size_t index_t;
+
+		// the atlas is not owned and must outlive the sprite system
+		SpriteSystem(Renderable* atlas_, int frame_width_, int frame_height_);
+
+		// returns the index of the new sprite
+		index_t add(float x_, float y_, float vx_ = 0, float vy_ = 0,
+			uint16_t first_frame_ = 0, uint16_t frame_count_ = 1, float fps_ = 0,
+			const Color& tint_ = Color(255, 255, 255), uint8_t layer_ = 0);
+		// removes by moving the last sprite into index_ (so the last sprite's index changes to index_)
+		void remove(index_t index_);
+		void clear();
+		void reserve(size_t count_);
+		size_t size() const { return _x.size(); }
+
+		// positions wrap around wrap_ (in window coordinates) instead of flying away, empty rect disables
+		void set_wrap(const Rect& wrap_) { _wrap = wrap_; }
+
+		// advances positions and animations by dt_ seconds, pool_ (optional) splits the work between threads
+		void update(float dt_, worker_pool* pool_ = nullptr);
+
+		// draws all sprites offset by (offset_x_,offset_y_) through the renderer's transform, sprites
+		// outside the clip are culled (and counted in Renderer::draw_stats)
+		void render(Renderer& renderer_, int offset_x_ = 0, int offset_y_ = 0);
+
+		// direct access to the sprite arrays:
+		float* pos_x() { return _x.data(); }
+		float* pos_y() { return _y.data(); }
+		float* vel_x() { return _vx.data(); }
+		float* vel_y() { return _vy.data(); }
+		float* phase() { return _phase.data(); } // frames since first_frame, in [0,frame_count)
+		float* fps() { return _fps.data(); }
+		uint16_t* first_frame() { return _first.data(); }
+		uint16_t* frame_count() { return _count.data(); }
+		Color* tint() { return _tint.data(); }
+		uint8_t* layer() { return _layer.data(); }
+
+		size_t drawn() const { return _drawn; } // sprites submitted by the last render
+
+	private:
+		SpriteSystem(const SpriteSystem&) = delete;
+		SpriteSystem& operator=(const SpriteSystem&) = delete;
+
+		void update_range(size_t begin_, size_t end_, float dt_);
+
+		Renderable* const _atlas;
+		const int _frame_width, _frame_height;
+		Rect _wrap;
+
+		std::vector<float> _x, _y, _vx, _vy, _phase, _fps;
+		std::vector<uint16_t> _first, _count;
+		std::vector<Color> _tint;
+		std::vector<uint8_t> _layer;
+
+		// render() scratch, kept to avoid reallocating every frame
+		std::vector<uint32_t> _order;
+		std::vector<Rect> _placed; // window rect of each sprite in _order
+		std::vector<Rect> _src, _dst;
+		std::vector<Color> _tints;
+		size_t _drawn;
+	};
+
+}
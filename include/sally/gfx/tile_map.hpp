@@ -0,0 +1,88 @@
+#pragma once
+
+#include <sally/common.hpp>
+#include <sally/gfx.hpp>
+#include <vector>
+
+namespace sally {
+
+	// large grid of tiles drawn from a tile set.
+	// tile indices are stored in CHUNK_SIZE x CHUNK_SIZE chunks which are only allocated once a
+	// non empty tile is set, so untouched areas cost a pointer per chunk. every visible chunk is
+	// baked into a cached target texture which is rebuilt only when one of its tiles changes,
+	// and drawing only touches the chunks intersecting the viewport.
+	// like the Renderer, a TileMap should only be modified and rendered from the main thread
+	// (or while holding the RenderProvider lock).
+	class TileMap {
+	public:
+		typedef uint16_t tile_t;
+		static const tile_t EMPTY_TILE = 0; // never drawn
+		static const int CHUNK_SIZE = 16;   // tiles per chunk side
+
+		struct Stats {
+			size_t _allocated_chunks; // chunks holding tile data
+			size_t _baked_chunks;     // chunks with a cached texture
+			uint64_t _bakes;          // chunk textures (re)built
+			uint64_t _chunks_drawn;   // chunk draws (at most one per visible chunk per render)
+			size_t _tile_bytes;       // memory held by tile data
+			size_t _texture_bytes;    // memory held by baked chunk textures
+
+			Stats() : _allocated_chunks(0), _baked_chunks(0), _bakes(0), _chunks_drawn(0), _tile_bytes(0), _texture_bytes(0) {}
+		};
+
+		// tile i>0 is cell i-1 of tileset_, cells are laid out left to right, top to bottom.
+		// the tileset is not owned and must outlive the map.
+		TileMap(int width_, int height_, int tile_width_, int tile_height_, Renderable* tileset_);
+		// solid color tiles, tile i>0 is filled with colors_[i-1]
+		TileMap(int width_, int height_, int tile_width_, int tile_height_, const std::vector<Color>& colors_);
+		~TileMap();
+
+		int width() const { return _width; }   // in tiles
+		int height() const { return _height; } // in tiles
+		int tile_width() const { return _tile_width; }
+		int tile_height() const { return _tile_height; }
+
+		// out of range coordinates read as EMPTY_TILE and are ignored when set
+		tile_t get(int x_, int y_) const;
+		void set(int x_, int y_, tile_t tile_);
+		void fill(const Rect& tiles_, tile_t tile_);
+
+		// draws the part of the map visible through dst_, with map pixel (scroll_x_,scroll_y_) at dst_'s top left
+		void render(Renderer& renderer_, const Rect& dst_, int scroll_x_, int scroll_y_);
+
+		// maximum number of baked chunk textures kept, least recently drawn ones are released first.
+		// 0 (the default) keeps twice the number of chunks visible in the last render.
+		void set_cache_limit(size_t chunks_) { _cache_limit = chunks_; }
+
+		const Stats& stats() const { return _stats; }
+
+	private:
+		struct Chunk {
+			tile_t _tiles[CHUNK_SIZE * CHUNK_SIZE];
+			unique_ptr<Texture> _baked;
+			bool _dirty;
+			uint64_t _last_drawn;
+			int _cx, _cy;
+		};
+
+		TileMap(const TileMap&) = delete;
+		TileMap& operator=(const TileMap&) = delete;
+
+		Chunk* chunk_at(int cx_, int cy_) const { return _chunks[size_t(cy_) * _chunks_x + cx_].get(); }
+		void bake(Renderer& renderer_, Chunk& chunk_);
+		void draw_tiles(Renderer& renderer_, const Chunk& chunk_, int x0_, int y0_, const Rect* only_) ;
+		void draw_tile(Renderer& renderer_, tile_t tile_, const Rect& dst_);
+		void release_baked(Chunk& chunk_);
+		void trim_cache(uint64_t frame_, size_t visible_);
+
+		const int _width, _height, _tile_width, _tile_height;
+		const int _chunks_x, _chunks_y;
+		Renderable* const _tileset;
+		const std::vector<Color> _colors;
+		std::vector<unique_ptr<Chunk> > _chunks;
+		std::vector<Chunk*> _baked;
+		size_t _cache_limit;
+		Stats _stats;
+	};
+
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <sally/common.hpp>
+#include <sally/gfx.hpp>
+#include <vector>
+#include <unordered_map>
+
+namespace sally {
+
+	// uniform grid spatial index of clickable objects, used for mouse hit-testing.
+	// objects are opaque application pointers (sprites, Renderables, game pieces...) with a
+	// window space rect and a z order. each object is registered in the grid cells its rect
+	// overlaps, so a point query only looks at the objects sharing the queried cell.
+	// objects spanning many cells are kept in a separate short list to keep updates cheap.
+	// all methods are thread safe.
+	class HitIndex {
+	public:
+		typedef void* object_t;
+
+		static const int DEFAULT_CELL_SIZE = 64;
+		static const int MAX_OBJECT_CELLS = 64; // objects covering more cells go to the large list
+
+		HitIndex(int cell_size_ = DEFAULT_CELL_SIZE);
+
+		// inserts obj_ or updates its rect and z order if already registered.
+		// moving an object only touches the grid cells it entered or left.
+		void update(object_t obj_, const Rect& rect_, int z_ = 0);
+		void remove(object_t obj_);
+		void clear();
+
+		bool contains(object_t obj_) const;
+		size_t size() const;
+
+		// topmost object (highest z, latest registered on ties) whose rect contains (x_,y_), nullptr if none
+		object_t pick(int x_, int y_) const;
+		// all objects whose rect intersects rect_, in no particular order
+		void query(const Rect& rect_, std::vector<object_t>& out_) const;
+
+	private:
+		struct Entry {
+			object_t _obj; // nullptr for free slots
+			Rect _rect;
+			int _z;
+			uint64_t _seq;
+			int _cx0, _cy0, _cx1, _cy1; // covered cell range (inclusive), _cx1 < _cx0 for large objects
+		};
+		typedef uint32_t slot_t;
+
+		HitIndex(const HitIndex&) = delete;
+		HitIndex& operator=(const HitIndex&) = delete;
+
+		int cell_of(int v_) const;
+		static uint64_t cell_key(int cx_, int cy_) { return (uint64_t(uint32_t(cx_)) << 32) | uint32_t(cy_); }
+		static bool rect_contains(const Rect& rect_, int x_, int y_) {
+			return x_ >= rect_._x && y_ >= rect_._y && x_ < rect_._x + rect_._width && y_ < rect_._y + rect_._height;
+		}
+		static bool above(const Entry& a_, const Entry& b_) {
+			return a_._z > b_._z || (a_._z == b_._z && a_._seq > b_._seq);
+		}
+
+		void link(slot_t slot_);
+		void unlink(slot_t slot_);
+		static void erase_slot(std::vector<slot_t>& slots_, slot_t slot_);
+
+		const int _cell_size;
+		std::vector<Entry> _entries;
+		std::vector<slot_t> _free;
+		std::unordered_map<object_t, slot_t> _slots;
+		std::unordered_map<uint64_t, std::vector<slot_t> > _cells;
+		std::vector<slot_t> _large;
+		uint64_t _seq;
+		mutable spinlock _lock;
+	};
+
+}
@@ -60,11 +60,14 @@ namespace sally {
 		uint32_t _mouseid;   // id of mouse click or TOUCH_MOUSE_ID for touch input device
 		button_type _button; // which button was pressed or released
 		int _clicks;         // 1 for single-click, 2 for double-click, etc.
+		void* _picked;       // topmost object under the cursor if the window has a HitIndex, otherwise nullptr
 
-		mouse_button_event(event_type type_, ticks_t tick_, uint32_t mouseid_, button_type button_, int clicks_)
-			: _type(type_), _tick(tick_), _mouseid(mouseid_), _button(button_), _clicks(clicks_)
+		mouse_button_event(event_type type_, ticks_t tick_, uint32_t mouseid_, button_type button_, int clicks_, void* picked_ = nullptr)
+			: _type(type_), _tick(tick_), _mouseid(mouseid_), _button(button_), _clicks(clicks_), _picked(picked_)
 		{}
 
+		template <class T> T* picked() const { return static_cast<T*>(_picked); }
+
 		bool left_button_pressed() const { return _type == BUTTON_PRESSED && _button == BUTTON_LEFT; }
 		bool middle_button_pressed() const { return _type == BUTTON_PRESSED && _button == BUTTON_MIDDLE; }
 		bool right_button_pressed() const { return _type == BUTTON_PRESSED && _button == BUTTON_RIGHT; }
@@ -99,11 +102,14 @@ namespace sally {
 		ticks_t _tick;    // timestamp of the event in clock ticks (ms)
 		uint32_t _mouseid;   // id of mouse click or TOUCH_MOUSE_ID for touch input device
 		button_mask_type _pressed; // which button(s) are pressed
+		void* _picked;       // topmost object under the cursor if the window has a HitIndex, otherwise nullptr
 
-		mouse_motion_event(ticks_t tick_, uint32_t mouseid_, button_mask_type pressed_)
-			: _tick(tick_), _mouseid(mouseid_), _pressed(pressed_)
+		mouse_motion_event(ticks_t tick_, uint32_t mouseid_, button_mask_type pressed_, void* picked_ = nullptr)
+			: _tick(tick_), _mouseid(mouseid_), _pressed(pressed_), _picked(picked_)
 		{}
 
+		template <class T> T* picked() const { return static_cast<T*>(_picked); }
+
 		bool left_button_pressed() const { return _pressed & BUTTON_LEFT; }
 		bool middle_button_pressed() const { return _pressed & BUTTON_MIDDLE; }
 		bool right_button_pressed() const { return _pressed & BUTTON_RIGHT; }
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <sally/common.hpp>
+#include <sally/util/histogram.hpp>
+
+namespace sally {
+
+	// input lag broken down by stage, in microseconds. key and mouse button events are followed
+	// from their SDL timestamp to the SDL_RenderPresent which first shows their effect: the next
+	// Window::invalidate on the main thread (during the handler or any later frame) claims every
+	// event handled so far, and that window's next present closes them:
+	//   queue    event timestamp -> main_loop picks it up (ms resolution, SDL timestamps are ms)
+	//   handler  the event handler
+	//   step     handler done -> the claiming window starts rendering
+	//   render   drawing that window
+	//   present  its SDL_RenderPresent
+	//   total    event timestamp -> present done
+	// events which are not presented within EXPIRE_MS are only counted as unseen, this includes
+	// events whose only invalidate came from another thread. always on, costs a few clock reads
+	// per event and presented window. System::main_loop and Window feed it on the main thread,
+	// the histograms may be read from any thread.
+	class InputLatency {
+	public:
+		enum stage_t { STAGE_QUEUE, STAGE_HANDLER, STAGE_STEP, STAGE_RENDER, STAGE_PRESENT, STAGE_TOTAL, STAGES };
+		static const int MAX_PENDING = 64; // events waiting for a present, further ones are only counted
+		static const uint32_t EXPIRE_MS = 1000;
+
+		InputLatency();
+
+		const histogram& stage(stage_t stage_) const { return _stages[stage_]; }
+		static const char* stage_name(stage_t stage_);
+		uint64_t unseen() const { return _unseen; } // events no present reflected within EXPIRE_MS
+		void reset();
+		void log_summary() const;
+
+		// called by System::main_loop around the key and mouse handlers
+		void event_begin(ticks_t timestamp_);
+		void event_end();
+		// called by Window::invalidate on the main thread, the window's next present reflects
+		// every event handled so far which no other window claimed yet
+		void invalidated(unsigned int window_id_);
+		// called by Window::render, render_start_ is the performance counter when drawing began
+		// and present_ticks_ the performance counter time spent in SDL_RenderPresent
+		void presented(unsigned int window_id_, uint64_t render_start_, uint64_t present_ticks_);
+		// called by System::main_loop once per frame, counts events left pending too long as unseen
+		void expire();
+
+	private:
+		struct Probe {
+			uint32_t _queue_us;
+			uint32_t _handler_us;
+			uint64_t _handled_at; // performance counter
+			unsigned int _window; // claiming window, 0 while no invalidate followed the event
+		};
+
+		InputLatency(const InputLatency&) = delete;
+		InputLatency& operator=(const InputLatency&) = delete;
+
+		uint64_t to_us(uint64_t ticks_) const { return ticks_ * 1000000 / _frequency; }
+
+		void remove(int index_) { _probes[index_] = _probes[--_probe_count]; }
+
+		histogram _stages[STAGES];
+		Probe _current; // the event being handled
+		bool _in_event;
+		Probe _probes[MAX_PENDING];
+		int _probe_count;
+		int _unclaimed;
+		uint64_t _event_start;
+		uint64_t _frequency;
+		uint64_t _unseen;
+	};
+
+}
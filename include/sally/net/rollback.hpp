@@ -0,0 +1,172 @@
+#pragma once
+
+#include <sally/common.hpp>
+#include <sally/system.hpp>
+#include <sally/input/input_events.hpp>
+#include <sally/net/udp_socket.hpp>
+#include <sally/util/histogram.hpp>
+#include <sally/util/metrics.hpp>
+#include <vector>
+
+namespace sally {
+
+	// a deterministic two player simulation driven by RollbackSession. the whole game state
+	// is saved and restored as a flat byte copy of state_size bytes (keep it small and free
+	// of pointers), and advance must depend only on the state and the two inputs.
+	class RollbackGame {
+	public:
+		typedef uint16_t input_t; // bitmask of buttons or actions
+
+		virtual size_t state_size() const = 0;
+		virtual void save_state(void* dst_) const = 0;
+		virtual void load_state(const void* src_) = 0;
+		// one fixed tick with the inputs of player 0 and player 1
+		virtual void advance(input_t input0_, input_t input1_) = 0;
+
+		// folds a local key event into the input of the next tick. the input is cleared after
+		// every tick, so a press sets a bit once while a held button is set again by the game.
+		virtual input_t on_local_key(const keyboard_event& event_, input_t input_) = 0;
+		// guess for a remote input not received yet, from the last one received. repeating it
+		// suits held buttons, games using presses predict 0.
+		virtual input_t predict(input_t last_) { return last_; }
+		// called once per on_step_event after the state changed (predicted or corrected)
+		virtual void on_state_changed() {}
+
+		virtual ~RollbackGame() = default;
+	};
+
+	// rollback netcode for two processes: local input is applied on the tick it happens, the
+	// remote player's input is predicted until it arrives over UDP. on a misprediction the
+	// game is restored from a ring of snapshots and re-simulated up to the present, so
+	// neither player waits for the network unless the other one falls more than
+	// max_prediction ticks behind.
+	//
+	// attach installs the session as System's step and keyboard handler (the previous
+	// keyboard handler still receives every key, i.e. for escape and menus).
+	class RollbackSession :
+		public step_event_handler,
+		public keyboard_event_handler
+	{
+	public:
+		typedef RollbackGame::input_t input_t;
+		static const int FRAME_RING = 64;              // snapshots and inputs kept, a power of two
+		static const int MAX_PREDICTION = FRAME_RING / 2 - 2;
+		static const int MAX_INPUTS_PER_PACKET = FRAME_RING;
+
+		struct Config {
+			int local_player;    // 0 or 1, the other process uses the other one
+			uint16_t local_port; // 0: any
+			NetAddress remote;
+			int tick_ms;
+			int max_prediction;  // ticks ahead of the last remote input before stalling
+			int drop_percent;    // outgoing packets dropped on purpose, to test over loopback
+
+			Config() : local_player(0), local_port(0), tick_ms(16), max_prediction(8), drop_percent(0) {}
+		};
+
+		// what the last tick cost, as reported after every on_step_event
+		struct FrameStats {
+			int32_t frame;           // ticks simulated so far
+			int rollback_frames;     // re-simulated because of a misprediction
+			double resim_us;         // restoring and re-simulating them
+			int bytes_sent;          // UDP payload
+			int bytes_received;
+			int predicted_frames;    // ticks ahead of the last remote input
+			bool stalled;            // waited for the remote player
+
+			FrameStats() : frame(0), rollback_frames(0), resim_us(0), bytes_sent(0), bytes_received(0), predicted_frames(0), stalled(false) {}
+		};
+
+		// the game's current state becomes frame 0 on both sides. throws general_exception if
+		// the socket cannot be bound or the configuration is invalid.
+		RollbackSession(RollbackGame& game_, const Config& config_);
+		~RollbackSession();
+
+		void attach();
+		void detach();
+
+		// runs the ticks that are due (at most a few to catch up) and polls the socket
+		virtual void on_step_event();
+		virtual int next_step_in_ms();
+		virtual void on_key_event(const keyboard_event& event_, Window* win_);
+
+		// one tick regardless of the clock, for tests and benchmarks driving the session
+		void tick();
+		// receives pending packets without simulating
+		void poll();
+		// input for the next tick from other sources than the keyboard (gamepads, bots, benchmarks)
+		void add_local_input(input_t input_) { _pending |= input_; }
+
+		uint16_t port() const { return _socket.port(); }
+		int32_t frame() const { return _frame; }
+		int32_t confirmed_frame() const { return _remote_confirmed; } // last remote input received
+		bool connected() const { return _remote_confirmed >= 0; }
+		// last complete tick and the totals since start
+		const FrameStats& last_frame() const { return _last; }
+		uint64_t rollbacks() const { return _rollbacks; }
+		uint64_t rollback_frames() const { return _rollback_frames_total; }
+		uint64_t stalls() const { return _stalls; }
+		uint64_t bytes_sent() const { return _bytes_sent; }
+		uint64_t bytes_received() const { return _bytes_received; }
+		// state checksums of confirmed frames which differ between the two sides
+		uint64_t desyncs() const { return _desyncs; }
+		// microseconds per rollback and ticks re-simulated per rollback
+		const histogram& resim_time() const { return _resim_time; }
+		const histogram& rollback_depth() const { return _rollback_depth; }
+
+	private:
+		struct Packet;
+
+		RollbackSession(const RollbackSession&) = delete;
+		RollbackSession& operator=(const RollbackSession&) = delete;
+
+		static int slot(int32_t frame_) { return frame_ & (FRAME_RING - 1); }
+		uint8_t* snapshot(int32_t frame_) { return &_snapshots[slot(frame_) * _state_size]; }
+		uint32_t checksum(int32_t frame_);
+		void receive(const Packet& packet_, int bytes_);
+		void rollback();
+		void simulate(int32_t frame_);
+		void send();
+		void finish_frame();
+
+		RollbackGame& _game;
+		const Config _config;
+		UdpSocket _socket;
+		const size_t _state_size;
+		std::vector<uint8_t> _snapshots; // state before each frame, FRAME_RING of them
+		input_t _local[FRAME_RING];
+		input_t _remote[FRAME_RING];     // received, or predicted for frames after _remote_confirmed
+		input_t _pending;                // local input of the next tick
+		int32_t _frame;                  // next frame to simulate
+		int32_t _remote_confirmed;       // last remote frame received (inputs arrive in order)
+		int32_t _remote_ack;             // last local frame the remote player received
+		int32_t _remote_frame;           // the remote player's frame when it last sent
+		int32_t _remote_advantage;       // how far ahead the remote player sees itself
+		int32_t _rollback_to;            // first mispredicted frame, or -1
+		int32_t _remote_sync_frame;      // frame of the remote checksum still to compare, or -1
+		uint32_t _remote_checksum;
+		int32_t _sync_cooldown;
+		ticks_t _next_tick;
+		uint32_t _drop_state;
+		bool _attached;
+		step_event_handler* _prev_step;
+		keyboard_event_handler* _prev_keyboard;
+
+		FrameStats _last;
+		FrameStats _current;
+		uint64_t _rollbacks;
+		uint64_t _rollback_frames_total;
+		uint64_t _stalls;
+		uint64_t _bytes_sent;
+		uint64_t _bytes_received;
+		uint64_t _desyncs;
+		histogram _resim_time;
+		histogram _rollback_depth;
+		counter* _bytes_sent_counter;
+		counter* _bytes_received_counter;
+		counter* _rollback_frames_counter;
+		counter* _stalls_counter;
+		gauge* _resim_gauge;
+	};
+
+}
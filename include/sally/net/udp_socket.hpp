@@ -0,0 +1,46 @@
+#pragma once
+
+#include <sally/common.hpp>
+
+namespace sally {
+
+	// IPv4 endpoint, host and port in host byte order
+	struct NetAddress {
+		uint32_t _host;
+		uint16_t _port;
+
+		NetAddress() : _host(0), _port(0) {}
+		NetAddress(uint32_t host_, uint16_t port_) : _host(host_), _port(port_) {}
+
+		// dotted address or host name, throws general_exception if it does not resolve
+		static NetAddress resolve(const char* host_, uint16_t port_);
+		static NetAddress loopback(uint16_t port_) { return NetAddress(0x7f000001, port_); }
+
+		bool operator==(const NetAddress& other_) const { return _host == other_._host && _port == other_._port; }
+		bool operator!=(const NetAddress& other_) const { return !(*this == other_); }
+	};
+
+	// non blocking UDP socket bound to a local port (0 lets the system pick one). sends and
+	// receives never wait, receive returns -1 when no datagram is pending.
+	class UdpSocket {
+	public:
+		// throws general_exception if the socket cannot be created or bound
+		explicit UdpSocket(uint16_t port_ = 0);
+		~UdpSocket();
+
+		uint16_t port() const { return _port; }
+
+		// false if the datagram was not sent (i.e. the send buffer is full)
+		bool send_to(const NetAddress& to_, const void* data_, size_t bytes_);
+		// bytes received into buf_ (datagrams beyond capacity_ are truncated) or -1 if none is pending
+		int receive(void* buf_, size_t capacity_, NetAddress* from_ = nullptr);
+
+	private:
+		UdpSocket(const UdpSocket&) = delete;
+		UdpSocket& operator=(const UdpSocket&) = delete;
+
+		intptr_t _fd;
+		uint16_t _port;
+	};
+
+}
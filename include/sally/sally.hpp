@@ -1,7 +1,11 @@
 #pragma once
 
 #include <sally/system.hpp>
+#include <sally/coroutine.hpp>
+#include <sally/audio/mixer.hpp>
+#include <sally/net/rollback.hpp>
 #include <sally/gfx.hpp>
 #include <sally/util/logger.hpp>
 #include <sally/input/input_events.hpp>
+#include <sally/input/hit_index.hpp>
 #include <sally/util/threading.hpp>
@@ -2,6 +2,14 @@
 
 #include <sally/common.hpp>
 #include <sally/gfx.hpp>
+#include <sally/assets/asset_manager.hpp>
+#include <sally/util/frame_arena.hpp>
+#include <sally/util/main_thread_queue.hpp>
+#include <sally/util/coroutine_scheduler.hpp>
+#include <sally/input/input_latency.hpp>
+#include <sally/util/metrics.hpp>
+#include <sally/audio/mixer.hpp>
+#include <SDL_thread.h>
 
 namespace sally {
 
@@ -12,6 +20,9 @@ namespace sally {
 	class step_event_handler {
 	public:
 		virtual void on_step_event() = 0;
+		// ms until on_step_event has to run again if nothing else happens, -1 for only after
+		// events. lets System::main_loop sleep while idle, the default steps every frame.
+		virtual int next_step_in_ms() { return 0; }
 		virtual ~step_event_handler() = default;
 	};
 
@@ -19,7 +30,8 @@ namespace sally {
 	public:
 		class InitGuard {
 		public:
-			InitGuard();
+			// headless_ uses SDL's dummy video driver, only offscreen windows can be used then
+			InitGuard(bool headless_ = false);
 			~InitGuard();
 		};
 
@@ -32,6 +44,24 @@ namespace sally {
 			return push_event(USER_EVENT_DELTA, code_, data1_, data2_);
 		}
 
+		// runs task_ on the main thread before one of the next frames is rendered, the queue is
+		// drained under a per frame time budget (see main_queue). thread safe.
+		static void post_main(main_thread_queue::task_t task_, main_thread_queue::priority_t priority_ = main_thread_queue::PRIORITY_NORMAL) {
+			if (_main_queue.post(std::move(task_), priority_))
+				wakeup();
+		}
+
+		// the thread which initialized the System
+		static bool is_main_thread() { return SDL_ThreadID() == _main_thread; }
+
+		// when idle (nothing to render, no main thread tasks, nothing due) main_loop blocks until
+		// the next event or deadline instead of polling. on by default.
+		static void set_idle_mode(bool enable_) { _idle_mode = enable_; }
+		static bool idle_mode() { return _idle_mode; }
+		// returns of main_loop from blocking, i.e. SDL_WaitEvent* or a frame pacing SDL_Delay
+		static uint64_t wakeups() { return _wakeups; }
+		static double wakeups_per_second() { return _wakeups_per_second; }
+
 		static void request_shutdown();
 		static void request_render();
 
@@ -66,22 +96,55 @@ namespace sally {
 
 		static WindowManager& window_manger() { return _window_mgr; }
 		static FontManager& font_manger() { return _font_mgr; }
+		static AssetManager& asset_manager() { return _asset_mgr; }
+		// scratch memory for the current frame (main thread only), reset by main_loop before the
+		// frame's events are handled. usable from event handlers, on_step_event and RenderProvider::render.
+		static frame_arena& arena() { return _arena; }
+		// key and mouse button event to present latency histograms
+		static InputLatency& input_latency() { return _input_latency; }
+		// telemetry of the main loop, windows and text (export with metrics_exporter)
+		static metrics_registry& metrics() { return _metrics; }
+		// audio output, opened on demand with AudioMixer::open (main thread API)
+		static AudioMixer& audio() { return _audio; }
+		// budget and last frame's executed/deferred report of the post_main tasks
+		static main_thread_queue& main_queue() { return _main_queue; }
+#ifdef SALLY_COROUTINES
+		// coroutines suspended on next_frame() or delay() (see sally/coroutine.hpp)
+		static coroutine_scheduler& coroutines() { return _coroutines; }
+#endif
 		static std::string resouce_path(const char* rel_path_);
 
 	private:
 		System();
 		friend class InitGuard;
 
-		static void init();
+		static void init(bool headless_);
 		static void destroy();
 		static void wakeup() { push_event(WAKEUP_EVENT_DELTA, 0, nullptr, nullptr);	}
 		static bool push_event(unsigned int type_delta_, int code_, void* data1_, void* data2_);
 		static bool handle_event(const SDL_Event& ev_);
+		static int idle_timeout();
+		static void count_wakeup();
 
 		enum { USER_EVENT_DELTA=0, WAKEUP_EVENT_DELTA, FRAME_EVENT_DELTA, USER_EVENTS_TOTAL };
 
 		static WindowManager _window_mgr;
 		static FontManager _font_mgr;
+		static AssetManager _asset_mgr;
+		static frame_arena _arena;
+		static InputLatency _input_latency;
+		static metrics_registry _metrics;
+		static main_thread_queue _main_queue;
+		static AudioMixer _audio;
+#ifdef SALLY_COROUTINES
+		static coroutine_scheduler _coroutines;
+#endif
+		static SDL_threadID _main_thread;
+		static bool _idle_mode;
+		static uint64_t _wakeups;
+		static uint64_t _wakeups_at_last_rate;
+		static ticks_t _last_rate_tick;
+		static double _wakeups_per_second;
 		static step_event_handler* _step_event_handler;
 		static keyboard_event_handler* _keyboard_event_handler;
 		static mouse_button_event_handler* _mouse_button_event_handler;
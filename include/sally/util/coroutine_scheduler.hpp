@@ -0,0 +1,68 @@
+#pragma once
+
+#include <sally/common.hpp>
+
+// coroutine support needs a C++20 compiler, everything below compiles away otherwise
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+# if __has_include(<coroutine>)
+#  define SALLY_COROUTINES
+# endif
+#endif
+
+#ifdef SALLY_COROUTINES
+
+#include <coroutine>
+#include <vector>
+#include <queue>
+#include <functional>
+
+namespace sally {
+
+	// coroutine frames are recycled through per size class free lists carved from slabs which
+	// are kept for the life of the process, frames over the largest class use the heap. thread safe.
+	void* coroutine_frame_alloc(size_t bytes_);
+	void coroutine_frame_free(void* frame_, size_t bytes_);
+
+	// suspended coroutines waiting for a frame or a point in time, resumed by System::main_loop
+	// after the step event. a suspended coroutine costs nothing per frame: next frame waiters
+	// are a list and timers a heap of which only the earliest is looked at.
+	// main thread only, coroutines running elsewhere must co_await on_main_thread() first.
+	class coroutine_scheduler {
+	public:
+		coroutine_scheduler() : _seq(0) {}
+
+		void resume_next_frame(std::coroutine_handle<> handle_) { _next_frame.push_back(handle_); }
+		void resume_at(ticks_t due_, std::coroutine_handle<> handle_) { _timers.push(timer{ due_, _seq++, handle_ }); }
+
+		// resumes the next frame waiters and the timers due by now_, coroutines suspending again
+		// while running wait for the next call. returns the number of coroutines resumed.
+		size_t run(ticks_t now_);
+
+		size_t suspended() const { return _next_frame.size() + _timers.size(); }
+		// ms until a coroutine needs resuming: 0 if some wait for the next frame, -1 if none wait
+		int next_due_in(ticks_t now_) const;
+
+		// abandons every suspended coroutine (at shutdown), their frames are not destroyed
+		void clear();
+
+	private:
+		struct timer {
+			ticks_t _due; // compared wraparound safe, pending timers must lie within 24 days of each other
+			uint64_t _seq; // resumes timers due at the same tick in order
+			std::coroutine_handle<> _handle;
+
+			bool operator>(const timer& o_) const { return _due != o_._due ? static_cast<int32_t>(_due - o_._due) > 0 : _seq > o_._seq; }
+		};
+
+		coroutine_scheduler(const coroutine_scheduler&) = delete;
+		coroutine_scheduler& operator=(const coroutine_scheduler&) = delete;
+
+		std::vector<std::coroutine_handle<> > _next_frame;
+		std::vector<std::coroutine_handle<> > _resuming;
+		std::priority_queue<timer, std::vector<timer>, std::greater<timer> > _timers;
+		uint64_t _seq;
+	};
+
+}
+
+#endif
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <sally/common.hpp>
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <cstdio>
+#include <algorithm>
+
+namespace sally {
+
+	// bump allocator for frame transient data. allocations are never freed individually,
+	// reset() releases everything at once (System::main_loop resets System::arena() at the
+	// start of every frame). memory stays reserved between frames, when a frame needed more
+	// than one block the blocks are merged so the next frames fit in one.
+	// not thread safe, System::arena() is for the main thread only.
+	class frame_arena {
+	public:
+		explicit frame_arena(size_t block_size_ = 64 * 1024);
+
+		// never returns nullptr (throws std::bad_alloc like new), align_ must be a power of two
+		void* allocate(size_t bytes_, size_t align_ = alignof(std::max_align_t)) {
+			uint8_t* ptr = reinterpret_cast<uint8_t*>((reinterpret_cast<uintptr_t>(_top) + align_ - 1) & ~uintptr_t(align_ - 1));
+			if (!_top || bytes_ > size_t(_end - ptr) || ptr > _end)
+				return allocate_slow(bytes_, align_);
+			_top = ptr + bytes_;
+			return ptr;
+		}
+		template <class T> T* allocate_array(size_t count_) { return static_cast<T*>(allocate(count_ * sizeof(T), alignof(T))); }
+
+		// invalidates everything allocated so far
+		void reset();
+
+		size_t used() const { return _used + (_top - _begin); } // bytes handed out since the last reset (incl. padding)
+		size_t capacity() const;
+		size_t peak() const { return _peak; }  // most bytes used in one frame
+		size_t blocks_allocated() const { return _blocks_allocated; } // heap allocations made so far
+
+	private:
+		frame_arena(const frame_arena&) = delete;
+		frame_arena& operator=(const frame_arena&) = delete;
+
+		struct block {
+			unique_ptr<std::max_align_t[]> _data;
+			size_t _size;
+		};
+		void* allocate_slow(size_t bytes_, size_t align_);
+		void add_block(size_t min_bytes_);
+		void use_block(size_t index_);
+
+		size_t _block_size;
+		std::vector<block> _blocks;
+		size_t _current;   // block allocations come from
+		uint8_t* _begin;   // of the current block
+		uint8_t* _top;
+		uint8_t* _end;
+		size_t _used;      // bytes used in the blocks before the current one
+		size_t _peak;
+		size_t _blocks_allocated;
+	};
+
+	// STL allocator drawing from a frame_arena, deallocate is a no-op
+	template <class T>
+	class arena_allocator {
+	public:
+		typedef T value_type;
+
+		arena_allocator(frame_arena& arena_) : _arena(&arena_) {}
+		template <class U> arena_allocator(const arena_allocator<U>& other_) : _arena(other_.arena()) {}
+
+		T* allocate(size_t count_) { return _arena->allocate_array<T>(count_); }
+		void deallocate(T*, size_t) {}
+
+		frame_arena* arena() const { return _arena; }
+
+		template <class U> bool operator==(const arena_allocator<U>& o_) const { return _arena == o_.arena(); }
+		template <class U> bool operator!=(const arena_allocator<U>& o_) const { return _arena != o_.arena(); }
+
+	private:
+		frame_arena* _arena;
+	};
+
+	typedef std::basic_string<char, std::char_traits<char>, arena_allocator<char> > arena_string;
+	template <class T> using arena_vector = std::vector<T, arena_allocator<T> >;
+
+	// builds a string in a frame_arena, i.e. for labels updated every frame:
+	//   label->set_text((string_builder(System::arena()) << "fps: " << fps).c_str());
+	class string_builder {
+	public:
+		explicit string_builder(frame_arena& arena_, size_t reserve_ = 64) : _str(arena_allocator<char>(arena_)) { _str.reserve(reserve_); }
+
+		string_builder& operator<<(const char* s_) { _str.append(s_); return *this; }
+		string_builder& operator<<(const std::string& s_) { _str.append(s_.data(), s_.size()); return *this; }
+		string_builder& operator<<(const arena_string& s_) { _str.append(s_); return *this; }
+		string_builder& operator<<(char c_) { _str.push_back(c_); return *this; }
+		string_builder& operator<<(int v_) { return format("%d", v_); }
+		string_builder& operator<<(unsigned v_) { return format("%u", v_); }
+		string_builder& operator<<(long v_) { return format("%ld", v_); }
+		string_builder& operator<<(unsigned long v_) { return format("%lu", v_); }
+		string_builder& operator<<(long long v_) { return format("%lld", v_); }
+		string_builder& operator<<(unsigned long long v_) { return format("%llu", v_); }
+		string_builder& operator<<(double v_) { return format("%g", v_); }
+
+		const char* c_str() const { return _str.c_str(); }
+		size_t size() const { return _str.size(); }
+		const arena_string& str() const { return _str; }
+		void clear() { _str.clear(); }
+
+	private:
+		template <class V> string_builder& format(const char* fmt_, V v_) {
+			char buf[32];
+			int len = std::snprintf(buf, sizeof(buf), fmt_, v_);
+			if (len > 0)
+				_str.append(buf, std::min<size_t>(size_t(len), sizeof(buf) - 1));
+			return *this;
+		}
+
+		arena_string _str;
+	};
+
+}
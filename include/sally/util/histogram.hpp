@@ -0,0 +1,74 @@
+#pragma once
+
+#include <sally/common.hpp>
+#include <atomic>
+
+#ifdef SALLY_WINDOWS
+# include <intrin.h>
+#endif
+
+namespace sally {
+
+	// fixed memory histogram of non-negative integer values (i.e. microseconds) with about 6%
+	// relative precision: every power of two range is split into 16 linear buckets (HDR style).
+	// record is a few instructions and lock free, it may be called from several threads while
+	// another one reads (readers see each count atomically, not the whole histogram at once).
+	class histogram {
+	public:
+		static const int SUB_BITS = 4;
+		static const int SUB_BUCKETS = 1 << SUB_BITS;
+		static const int MAX_BITS = 40; // values are clamped to below 2^40
+		static const int BUCKETS = (MAX_BITS - SUB_BITS + 1) * SUB_BUCKETS;
+
+		histogram() { reset(); }
+
+		void record(uint64_t value_) {
+			_counts[bucket(value_)].fetch_add(1, std::memory_order_relaxed);
+			_sum.fetch_add(value_, std::memory_order_relaxed);
+			uint64_t max = _max.load(std::memory_order_relaxed);
+			while (value_ > max && !_max.compare_exchange_weak(max, value_, std::memory_order_relaxed))
+				;
+		}
+
+		uint64_t count() const; // sums the buckets, recording stays cheap
+		uint64_t sum() const { return _sum.load(std::memory_order_relaxed); }
+		uint64_t max() const { return _max.load(std::memory_order_relaxed); }
+		double mean() const { const uint64_t cnt = count(); return cnt ? double(sum()) / cnt : 0; }
+		// upper bound of the bucket holding the p_ (0..100) percentile, 0 if empty
+		uint64_t percentile(double p_) const;
+
+		uint64_t bucket_count(int bucket_) const { return _counts[bucket_].load(std::memory_order_relaxed); }
+		static uint64_t bucket_lower(int bucket_);
+		static uint64_t bucket_upper(int bucket_) { return bucket_lower(bucket_ + 1) - 1; }
+		static int bucket(uint64_t value_) {
+			if (value_ < SUB_BUCKETS)
+				return static_cast<int>(value_);
+			if (value_ >> MAX_BITS)
+				return BUCKETS - 1;
+			const int shift = highest_bit(value_) - SUB_BITS; // value_ >> shift is in [SUB_BUCKETS, 2*SUB_BUCKETS)
+			return (shift + 1) * SUB_BUCKETS + static_cast<int>((value_ >> shift) - SUB_BUCKETS);
+		}
+
+		// not atomic with respect to concurrent record calls
+		void reset();
+
+	private:
+		static int highest_bit(uint64_t v_) {
+#ifdef SALLY_WINDOWS
+			unsigned long index;
+			_BitScanReverse64(&index, v_);
+			return static_cast<int>(index);
+#else
+			return 63 - __builtin_clzll(v_);
+#endif
+		}
+
+		histogram(const histogram&) = delete;
+		histogram& operator=(const histogram&) = delete;
+
+		std::atomic<uint64_t> _counts[BUCKETS];
+		std::atomic<uint64_t> _sum;
+		std::atomic<uint64_t> _max;
+	};
+
+}
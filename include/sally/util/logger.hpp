@@ -35,20 +35,35 @@ namespace sally {
 		message msg_with_header(const char* type_);
 	};
 
-	// helper class for building and logging a message
+	// helper class for building and logging a message.
+	// messages are formatted into an inline buffer, only long ones allocate.
 	class generic_logger::message {
 	public:
-		message(generic_logger& logger_) : _logger(logger_) {}
-		message(message&& other_) : _ost(std::move(other_._ost)), _logger(other_._logger)
-			{ other_._ost.setstate(std::ios::badbit); } // prevent other_ dtor from logging empty line
+		message(generic_logger& logger_) : _ost(&_buf), _logger(logger_), _active(true) {}
+		message(message&& other_) : _ost(&_buf), _logger(other_._logger), _active(other_._active)
+			{ _buf.take(other_._buf); other_._active = false; } // prevent other_ dtor from logging empty line
 
 		template<typename T>
 		message& operator<<(const T& x_) { _ost << x_; return *this; }
 
-		~message() { if (_ost) _logger.output(_ost.str()); }
+		~message() { if (_active && _ost) _logger.output(_buf.c_str()); }
 	private:
-		std::ostringstream _ost;
+		class buffer : public std::streambuf {
+		public:
+			buffer() { setp(_inline, _inline + sizeof(_inline) - 1); } // room for the terminator
+			void take(buffer& other_);
+			const char* c_str();
+		protected:
+			virtual int_type overflow(int_type ch_);
+		private:
+			char _inline[256];
+			std::string _spill; // used once the message outgrows _inline
+		};
+
+		buffer _buf;
+		std::ostream _ost;
 		generic_logger& _logger;
+		bool _active;
 	};
 
 	// NullLogger totally ignores all messages
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <sally/common.hpp>
+#include <sally/util/threading.hpp>
+#include <functional>
+#include <deque>
+
+namespace sally {
+
+	// work which has to run on the main thread (i.e. texture uploads), executed a frame at a
+	// time under a time budget so a burst of work spreads over several frames instead of
+	// stalling one. System::main_loop drains System::main_queue() before rendering each frame.
+	// post is thread safe, drain must only be called from the main thread.
+	class main_thread_queue {
+	public:
+		typedef std::function<void()> task_t;
+		enum priority_t { PRIORITY_HIGH, PRIORITY_NORMAL, PRIORITY_LOW, PRIORITIES };
+
+		struct Report {
+			size_t executed; // tasks run by the last drain
+			size_t deferred; // tasks left for later frames
+			double ms;       // time spent running them
+
+			Report() : executed(0), deferred(0), ms(0) {}
+		};
+
+		explicit main_thread_queue(double budget_ms_ = 4.0) : _budget_ms(budget_ms_), _pending(0) {}
+
+		// returns true if the queue was empty before (the main loop may need a wakeup)
+		bool post(task_t task_, priority_t priority_ = PRIORITY_NORMAL);
+
+		// runs queued tasks, higher priorities first and in posting order within a priority, until
+		// the budget is spent. at least one task runs so work always progresses and tasks posted
+		// by the running tasks wait for the next drain. exceptions thrown by tasks are logged.
+		const Report& drain();
+		void clear();
+
+		// 0 means unlimited
+		void set_budget_ms(double budget_ms_) { _budget_ms = budget_ms_; }
+		double budget_ms() const { return _budget_ms; }
+		size_t pending() const { mutex::Guard lg(_lock); return _pending; }
+		const Report& last_report() const { return _report; }
+
+	private:
+		main_thread_queue(const main_thread_queue&) = delete;
+		main_thread_queue& operator=(const main_thread_queue&) = delete;
+
+		bool pop(task_t& task_);
+
+		std::deque<task_t> _tasks[PRIORITIES];
+		double _budget_ms;
+		size_t _pending;
+		mutable mutex _lock;
+		Report _report;
+	};
+
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <sally/common.hpp>
+
+namespace sally {
+
+	// read only memory mapping of a whole file, the pages are loaded by the OS on first access
+	// and shared between processes mapping the same file.
+	class mapped_file {
+	public:
+		// throws general_exception if the file cannot be opened or mapped
+		explicit mapped_file(const std::string& path_);
+		~mapped_file();
+
+		const uint8_t* data() const { return _data; }
+		size_t size() const { return _size; }
+		const std::string& path() const { return _path; }
+
+	private:
+		mapped_file(const mapped_file&) = delete;
+		mapped_file& operator=(const mapped_file&) = delete;
+
+		const std::string _path;
+		const uint8_t* _data;
+		size_t _size;
+#ifdef SALLY_WINDOWS
+		void* _file;
+		void* _mapping;
+#endif
+	};
+
+}
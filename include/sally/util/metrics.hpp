@@ -0,0 +1,80 @@
+#pragma once
+
+#include <sally/common.hpp>
+#include <sally/util/threading.hpp>
+#include <sally/util/histogram.hpp>
+#include <atomic>
+#include <map>
+#include <vector>
+#include <string>
+#include <ostream>
+
+namespace sally {
+
+	// monotonically increasing count, i.e. rasterized text lines
+	class counter {
+	public:
+		counter() : _value(0) {}
+		void add(uint64_t n_ = 1) { _value.fetch_add(n_, std::memory_order_relaxed); }
+		uint64_t value() const { return _value.load(std::memory_order_relaxed); }
+	private:
+		counter(const counter&) = delete;
+		counter& operator=(const counter&) = delete;
+		std::atomic<uint64_t> _value;
+	};
+
+	// current level, i.e. queued events or texture bytes
+	class gauge {
+	public:
+		gauge() : _value(0) {}
+		void set(int64_t value_) { _value.store(value_, std::memory_order_relaxed); }
+		void add(int64_t delta_) { _value.fetch_add(delta_, std::memory_order_relaxed); }
+		int64_t value() const { return _value.load(std::memory_order_relaxed); }
+	private:
+		gauge(const gauge&) = delete;
+		gauge& operator=(const gauge&) = delete;
+		std::atomic<int64_t> _value;
+	};
+
+	// named metrics for telemetry (see metrics_exporter). registering is locked and meant to happen
+	// once, the returned references stay valid for the registry's lifetime and are updated lock free
+	// from hot paths. registering an existing name and labels returns the existing metric, a
+	// different type under the same name throws general_exception.
+	// labels_ are in Prometheus syntax without braces, i.e. "window=\"3\"".
+	class metrics_registry {
+	public:
+		metrics_registry() {}
+
+		counter& add_counter(const std::string& name_, const std::string& help_, const std::string& labels_ = std::string());
+		gauge& add_gauge(const std::string& name_, const std::string& help_, const std::string& labels_ = std::string());
+		// exported as a Prometheus summary (p50, p90, p99 and max since start)
+		histogram& add_histogram(const std::string& name_, const std::string& help_, const std::string& labels_ = std::string());
+
+		// Prometheus text exposition format
+		void write_prometheus(std::ostream& out_) const;
+
+	private:
+		enum type_t { TYPE_COUNTER, TYPE_GAUGE, TYPE_HISTOGRAM };
+		struct Series {
+			std::string _labels;
+			unique_ptr<counter> _counter;
+			unique_ptr<gauge> _gauge;
+			unique_ptr<histogram> _histogram;
+		};
+		struct Family {
+			type_t _type;
+			std::string _help;
+			std::vector<Series> _series;
+		};
+
+		metrics_registry(const metrics_registry&) = delete;
+		metrics_registry& operator=(const metrics_registry&) = delete;
+
+		// _lock must be held
+		Series& series(const std::string& name_, const std::string& help_, const std::string& labels_, type_t type_);
+
+		std::map<std::string, Family> _families; // sorted output
+		mutable mutex _lock;
+	};
+
+}
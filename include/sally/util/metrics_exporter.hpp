@@ -0,0 +1,51 @@
+#pragma once
+
+#include <sally/common.hpp>
+#include <sally/util/metrics.hpp>
+#include <sally/util/threading.hpp>
+#include <string>
+#include <atomic>
+
+struct SDL_Thread;
+
+namespace sally {
+
+	// writes snapshots of a metrics_registry in Prometheus text format every interval_ms_ from a
+	// background thread: TARGET_FILE replaces path_ atomically (i.e. for a node exporter textfile
+	// collector), TARGET_UNIX_SOCKET connects to a listening stream socket at path_ and sends the
+	// snapshot (POSIX only, throws general_exception elsewhere). failed exports are retried on the
+	// next interval and logged once.
+	class metrics_exporter {
+	public:
+		enum target_t { TARGET_FILE, TARGET_UNIX_SOCKET };
+
+		metrics_exporter(metrics_registry& registry_, target_t target_, const std::string& path_, int interval_ms_ = 10000);
+		~metrics_exporter(); // stops the thread (without a last export)
+
+		// exports right away on the calling thread, returns false on failure
+		bool export_now();
+		uint64_t exports() const { return _exports.value(); }
+		uint64_t failures() const { return _failures.value(); }
+
+	private:
+		metrics_exporter(const metrics_exporter&) = delete;
+		metrics_exporter& operator=(const metrics_exporter&) = delete;
+
+		static int thread_main(void* self_);
+		bool write_file(const std::string& text_);
+		bool send_socket(const std::string& text_);
+
+		metrics_registry& _registry;
+		const target_t _target;
+		const std::string _path;
+		const int _interval_ms;
+		counter _exports;
+		counter _failures;
+		mutex _lock;
+		condition_variable _wake;
+		bool _quit;
+		std::atomic<bool> _logged_failure;
+		SDL_Thread* _thread;
+	};
+
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <sally/common.hpp>
+#include <atomic>
+#include <type_traits>
+
+namespace sally {
+
+	// bounded lock free queue for exactly one producer and one consumer thread (i.e. a game
+	// thread feeding a real time audio callback). push and pop never block or allocate,
+	// push fails when the queue is full. N must be a power of two, one slot stays unused.
+	template <class T, size_t N>
+	class spsc_queue {
+		static_assert(N >= 2 && (N & (N - 1)) == 0, "spsc_queue size must be a power of two");
+		static_assert(std::is_trivially_copyable<T>::value, "spsc_queue elements must be trivially copyable");
+
+	public:
+		spsc_queue() : _head(0), _tail(0) {}
+
+		// producer only
+		bool push(const T& item_) {
+			const size_t tail = _tail.load(std::memory_order_relaxed);
+			const size_t next = (tail + 1) & (N - 1);
+			if (next == _head.load(std::memory_order_acquire))
+				return false;
+			_items[tail] = item_;
+			_tail.store(next, std::memory_order_release);
+			return true;
+		}
+
+		// consumer only
+		bool pop(T& item_) {
+			const size_t head = _head.load(std::memory_order_relaxed);
+			if (head == _tail.load(std::memory_order_acquire))
+				return false;
+			item_ = _items[head];
+			_head.store((head + 1) & (N - 1), std::memory_order_release);
+			return true;
+		}
+
+		bool empty() const { return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire); }
+		static size_t capacity() { return N - 1; }
+
+	private:
+		spsc_queue(const spsc_queue&) = delete;
+		spsc_queue& operator=(const spsc_queue&) = delete;
+
+		// head and tail on their own cache lines so producer and consumer do not false share
+		alignas(64) std::atomic<size_t> _head;
+		alignas(64) std::atomic<size_t> _tail;
+		alignas(64) T _items[N];
+	};
+
+}
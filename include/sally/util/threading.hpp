@@ -2,8 +2,7 @@
 
 #include <sally/common.hpp>
 #include <SDL_atomic.h>
-
-struct SDL_mutex;
+#include <atomic>
 
 namespace sally {
 
@@ -24,32 +23,152 @@ namespace sally {
 		bool _locked;
 	};
 
+	// generic_guard taking the shared (reader) side of a lock
+	template<typename Lock>
+	class generic_shared_guard {
+	public:
+		generic_shared_guard(Lock& lock_, bool initially_locked_=true)
+			: _lock(lock_), _locked(initially_locked_)
+		{ if (initially_locked_) _lock.lock_shared(); }
+
+		~generic_shared_guard() { if (_locked) _lock.unlock_shared(); }
+
+		void lock() { if (!_locked) { _lock.lock_shared(); _locked = true; } }
+		void unlock() { if (_locked) { _lock.unlock_shared(); _locked = false; } }
+		bool try_lock() { return _locked || (_locked = _lock.try_lock_shared()); }
+	private:
+		Lock& _lock;
+		bool _locked;
+	};
+
+	// blocking primitives below are built on a 32 bit futex word: Linux futex, WaitOnAddress on
+	// Windows and a small table of SDL mutexes and condition variables elsewhere.
+	namespace futex {
+		// blocks while *word_ == expected_ (may return spuriously), timeout_ms_ < 0 waits forever.
+		// returns false on timeout.
+		bool wait(std::atomic<int>& word_, int expected_, int timeout_ms_ = -1);
+		void wake_one(std::atomic<int>& word_);
+		void wake_all(std::atomic<int>& word_);
+	}
+
+	// spins briefly then sleeps in the kernel, lock and unlock are a single atomic operation when
+	// uncontended. never throws.
 	class mutex {
 	public:
 		typedef generic_guard<mutex> Guard;
 
-		mutex();
-		~mutex();
+		mutex() : _state(UNLOCKED) {}
+
+		void lock() {
+			int expected = UNLOCKED;
+			if (!_state.compare_exchange_strong(expected, LOCKED, std::memory_order_acquire))
+				lock_contended();
+		}
+		void unlock() {
+			if (_state.exchange(UNLOCKED, std::memory_order_release) == CONTENDED)
+				futex::wake_one(_state);
+		}
+		bool try_lock() {
+			int expected = UNLOCKED;
+			return _state.compare_exchange_strong(expected, LOCKED, std::memory_order_acquire);
+		}
+
+	private:
+		friend class condition_variable;
+		enum { UNLOCKED, LOCKED, CONTENDED }; // CONTENDED: someone may be sleeping
+
+		mutex(const mutex&) = delete;
+		mutex& operator=(const mutex&) = delete;
+		void lock_contended();
+
+		std::atomic<int> _state;
+	};
+
+	class condition_variable {
+	public:
+		condition_variable() : _seq(0) {}
+
+		// mutex_ must be locked, it is released while waiting. may wake spuriously.
+		void wait(mutex& mutex_) { wait_for(mutex_, -1); }
+		// returns false on timeout
+		bool wait_for(mutex& mutex_, int timeout_ms_);
+		template <class Predicate> void wait(mutex& mutex_, Predicate pred_) {
+			while (!pred_())
+				wait(mutex_);
+		}
+
+		void notify_one() { _seq.fetch_add(1, std::memory_order_release); futex::wake_one(_seq); }
+		void notify_all() { _seq.fetch_add(1, std::memory_order_release); futex::wake_all(_seq); }
+
+	private:
+		condition_variable(const condition_variable&) = delete;
+		condition_variable& operator=(const condition_variable&) = delete;
+
+		std::atomic<int> _seq;
+	};
+
+	// reader-writer lock, waiting writers block new readers so writers do not starve
+	class shared_mutex {
+	public:
+		typedef generic_guard<shared_mutex> Guard;
+		typedef generic_shared_guard<shared_mutex> SharedGuard;
+
+		shared_mutex() : _state(0) {}
 
 		void lock();
-		void unlock();
-		bool try_lock();
+		void unlock() {
+			if (_state.exchange(0, std::memory_order_release) & WAITING)
+				futex::wake_all(_state);
+		}
+		bool try_lock() {
+			int expected = 0;
+			return _state.compare_exchange_strong(expected, WRITER, std::memory_order_acquire);
+		}
+
+		void lock_shared() {
+			int s = _state.load(std::memory_order_relaxed);
+			if ((s & (WRITER | WAITING)) || !_state.compare_exchange_weak(s, s + 1, std::memory_order_acquire))
+				lock_shared_contended();
+		}
+		void unlock_shared() {
+			const int s = _state.fetch_sub(1, std::memory_order_release) - 1;
+			if (s == WAITING) // last reader left and someone waits
+				futex::wake_all(_state);
+		}
+		bool try_lock_shared() {
+			int s = _state.load(std::memory_order_relaxed);
+			while (!(s & (WRITER | WAITING)))
+				if (_state.compare_exchange_weak(s, s + 1, std::memory_order_acquire))
+					return true;
+			return false;
+		}
 
 	private:
-		SDL_mutex* _mutex;
+		// readers count in the low bits
+		enum { WRITER = 1 << 30, WAITING = 1 << 29 };
+
+		shared_mutex(const shared_mutex&) = delete;
+		shared_mutex& operator=(const shared_mutex&) = delete;
+		void lock_shared_contended();
+
+		std::atomic<int> _state;
 	};
 
+	// for very short critical sections. contended lockers spin with exponential backoff and
+	// then yield their time slice instead of burning it.
 	class spinlock {
 	public:
 		typedef generic_guard<spinlock> Guard;
 
 		spinlock() { memset(&_lock, 0, sizeof(_lock)); }
 
-		void lock() { SDL_AtomicLock(&_lock); }
+		void lock() { if (!SDL_AtomicTryLock(&_lock)) lock_contended(); }
 		void unlock() { SDL_AtomicUnlock(&_lock); }
 		bool try_lock() { return SDL_AtomicTryLock(&_lock) == SDL_TRUE; }
 
 	private:
+		void lock_contended();
+
 		SDL_SpinLock _lock;
 	};
 
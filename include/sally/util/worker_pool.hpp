@@ -0,0 +1,62 @@
+#pragma once
+
+#include <sally/common.hpp>
+#include <SDL_atomic.h>
+#include <functional>
+#include <deque>
+#include <vector>
+
+struct SDL_Thread;
+struct SDL_mutex;
+struct SDL_cond;
+
+namespace sally {
+
+	// fixed set of worker threads executing an indexed range of tasks in parallel.
+	// the calling thread participates in the work and run() only returns once all
+	// tasks are done. tasks must not throw. run() should not be called concurrently.
+	// idle workers also execute background jobs handed to post(), one at a time each.
+	class worker_pool {
+	public:
+		// threads_ is the number of additional threads, -1 means one less than the number of cores
+		explicit worker_pool(int threads_ = -1);
+		~worker_pool();
+
+		// number of threads executing tasks (including the caller of run)
+		int concurrency() const { return static_cast<int>(_threads.size()) + 1; }
+
+		// calls task_(i) for every i in [0,count_)
+		void run(size_t count_, const std::function<void(size_t)>& task_);
+
+		// queues job_ for the next idle worker and returns, a pool without threads runs it right
+		// away. a batch of run() takes precedence over queued jobs, jobs still queued when the
+		// pool is destroyed are dropped. may be called from any thread.
+		void post(std::function<void()> job_);
+
+		// process wide pool, created on first use
+		static worker_pool& shared();
+
+	private:
+		worker_pool(const worker_pool&) = delete;
+		worker_pool& operator=(const worker_pool&) = delete;
+
+		static int thread_main(void* self_);
+		void worker_loop();
+		void drain();
+
+		std::vector<SDL_Thread*> _threads;
+		SDL_mutex* _mutex;
+		SDL_cond* _wake;
+		SDL_cond* _done;
+
+		// current batch, only modified while holding _mutex and no worker is active:
+		const std::function<void(size_t)>* _task;
+		size_t _count;
+		SDL_atomic_t _next;
+		unsigned int _generation;
+		int _active;
+		bool _quit;
+		std::deque<std::function<void()> > _jobs; // posted, guarded by _mutex
+	};
+
+}
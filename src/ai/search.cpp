@@ -0,0 +1,81 @@
+#include <sally/ai/search.hpp>
+
+namespace sally {
+	namespace ai {
+
+		namespace {
+			inline uint64_t splitmix64(uint64_t& state_) {
+				uint64_t z = (state_ += 0x9e3779b97f4a7c15ull);
+				z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+				z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+				return z ^ (z >> 31);
+			}
+
+			inline uint64_t pack(const TranspositionTable::Entry& entry_) {
+				return uint64_t(uint16_t(entry_._score)) | (uint64_t(uint16_t(entry_._move)) << 16)
+					| (uint64_t(entry_._depth) << 32) | (uint64_t(entry_._bound) << 40);
+			}
+
+			inline TranspositionTable::Entry unpack(uint64_t data_) {
+				TranspositionTable::Entry entry;
+				entry._score = static_cast<int16_t>(data_ & 0xffff);
+				entry._move = static_cast<int16_t>((data_ >> 16) & 0xffff);
+				entry._depth = static_cast<uint8_t>((data_ >> 32) & 0xff);
+				entry._bound = static_cast<uint8_t>((data_ >> 40) & 0xff);
+				return entry;
+			}
+		}
+
+		// ZobristKeys:
+
+		ZobristKeys::ZobristKeys(size_t count_, uint64_t seed_)
+			: _keys(count_)
+		{
+			for (uint64_t& key : _keys)
+				key = splitmix64(seed_);
+		}
+
+		// TranspositionTable:
+
+		TranspositionTable::TranspositionTable(size_t megabytes_)
+			: _mask(0)
+		{
+			// largest power of two slot count within the requested size
+			const size_t wanted = std::max<size_t>(megabytes_ * 1024 * 1024 / sizeof(Slot), 1);
+			size_t count = 1;
+			while (count * 2 <= wanted)
+				count *= 2;
+			_slots.reset(new Slot[count]);
+			_mask = count - 1;
+			clear();
+		}
+
+		bool TranspositionTable::probe(uint64_t key_, Entry& entry_) const
+		{
+			const Slot& slot = _slots[key_ & _mask];
+			const uint64_t data = slot._data.load(std::memory_order_relaxed);
+			const uint64_t check = slot._check.load(std::memory_order_relaxed);
+			if (data == 0 || (check ^ data) != key_)
+				return false;
+			entry_ = unpack(data);
+			return entry_._bound != BOUND_NONE;
+		}
+
+		void TranspositionTable::store(uint64_t key_, const Entry& entry_)
+		{
+			Slot& slot = _slots[key_ & _mask];
+			const uint64_t data = pack(entry_);
+			slot._check.store(key_ ^ data, std::memory_order_relaxed);
+			slot._data.store(data, std::memory_order_relaxed);
+		}
+
+		void TranspositionTable::clear()
+		{
+			for (size_t ii = 0; ii <= _mask; ++ii) {
+				_slots[ii]._check.store(0, std::memory_order_relaxed);
+				_slots[ii]._data.store(0, std::memory_order_relaxed);
+			}
+		}
+
+	}
+}
@@ -0,0 +1,54 @@
+#include <sally/ai/tablebase.hpp>
+
+namespace sally {
+	namespace ai {
+
+		namespace {
+			const char TABLEBASE_MAGIC[8] = { 'S', 'A', 'L', 'L', 'Y', 'T', 'B', '\0' };
+			const uint32_t TABLEBASE_VERSION = 1;
+		}
+
+		Tablebase::Tablebase(const std::string& path_)
+			: _file(new mapped_file(path_)), _values(nullptr)
+		{
+			if (_file->size() < sizeof(Header))
+				throw general_exception(("not a tablebase: " + path_).c_str());
+			memcpy(&_header, _file->data(), sizeof(Header));
+			if (memcmp(_header._magic, TABLEBASE_MAGIC, sizeof(TABLEBASE_MAGIC)) != 0 || _header._version != TABLEBASE_VERSION
+				|| _header._param_count > MAX_PARAMS || _file->size() - sizeof(Header) < _header._positions)
+				throw general_exception(("not a tablebase or truncated: " + path_).c_str());
+			_values = _file->data() + sizeof(Header);
+		}
+
+		Tablebase::Tablebase(const int32_t* params_, int param_count_, std::vector<uint8_t>&& values_)
+			: _owned(std::move(values_)), _header(make_header(params_, param_count_, 0)), _values(nullptr)
+		{
+			_header._positions = _owned.size();
+			_values = _owned.data();
+		}
+
+		// static
+		Tablebase::Header Tablebase::make_header(const int32_t* params_, int param_count_, uint64_t positions_)
+		{
+			if (param_count_ < 0 || param_count_ > MAX_PARAMS)
+				throw general_exception("too many tablebase parameters");
+			Header header;
+			memset(&header, 0, sizeof(header));
+			memcpy(header._magic, TABLEBASE_MAGIC, sizeof(TABLEBASE_MAGIC));
+			header._version = TABLEBASE_VERSION;
+			header._param_count = static_cast<uint32_t>(param_count_);
+			for (int ii = 0; ii < param_count_; ++ii)
+				header._params[ii] = params_[ii];
+			header._positions = positions_;
+			return header;
+		}
+
+		void Tablebase::write_header(std::FILE* file_, const int32_t* params_, int param_count_, uint64_t positions_)
+		{
+			const Header header = make_header(params_, param_count_, positions_);
+			if (std::fwrite(&header, sizeof(header), 1, file_) != 1)
+				throw general_exception("failed writing tablebase header");
+		}
+
+	}
+}
@@ -0,0 +1,86 @@
+#include <sally/assets/asset_manager.hpp>
+#include <cstdlib>
+#include <climits>
+
+namespace sally {
+
+	//static
+	std::string AssetManager::canonical_path(const std::string& filepath_)
+	{
+#ifdef SALLY_WINDOWS
+		char buf[_MAX_PATH];
+		if (_fullpath(buf, filepath_.c_str(), sizeof(buf)))
+			return buf;
+#else
+		char buf[PATH_MAX];
+		if (realpath(filepath_.c_str(), buf))
+			return buf;
+#endif
+		return filepath_;
+	}
+
+	template <class T, class Load>
+	shared_ptr<T> AssetManager::acquire(std::unordered_map<std::string, std::weak_ptr<T> >& map_, const std::string& key_, Load load_)
+	{
+		mutex::Guard lg(_lock);
+		if (shared_ptr<T> res = map_[key_].lock()) {
+			++_stats.hits;
+			return res;
+		}
+		// decoding happens under the lock so concurrent requests for the same
+		// asset wait for the first one instead of decoding it again
+		shared_ptr<T> res(load_());
+		map_[key_] = res;
+		++_stats.loads;
+		if (_stats.loads + _stats.hits >= _collect_at) {
+			lg.unlock();
+			collect();
+		}
+		return res;
+	}
+
+	shared_ptr<Image> AssetManager::image(const std::string& filepath_)
+	{
+		const std::string path = canonical_path(filepath_);
+		return acquire(_images, path, [&path]() { return new Image(path); });
+	}
+
+	shared_ptr<Font> AssetManager::font(const std::string& filepath_, int ptsize_, long index_)
+	{
+		const std::string path = canonical_path(filepath_);
+		const std::string key = path + '\n' + std::to_string(ptsize_) + '\n' + std::to_string(index_);
+		return acquire(_fonts, key, [&]() { return new Font(path, ptsize_, index_); });
+	}
+
+	shared_ptr<Sound> AssetManager::sound(const std::string& filepath_)
+	{
+		const std::string path = canonical_path(filepath_);
+		return acquire(_sounds, path, [&path]() { return new Sound(path); });
+	}
+
+	template <class Map> static size_t erase_expired(Map& map_)
+	{
+		for (auto it = map_.begin(); it != map_.end();) {
+			if (it->second.expired())
+				it = map_.erase(it);
+			else
+				++it;
+		}
+		return map_.size();
+	}
+
+	void AssetManager::collect()
+	{
+		mutex::Guard lg(_lock);
+		_stats.live = erase_expired(_images) + erase_expired(_fonts) + erase_expired(_sounds);
+		// amortized: scan again once as many requests as there are entries were served
+		_collect_at = _stats.loads + _stats.hits + _stats.live + 16;
+	}
+
+	AssetManager::Stats AssetManager::stats() const
+	{
+		mutex::Guard lg(_lock);
+		return _stats;
+	}
+
+}
@@ -0,0 +1,60 @@
+#include <sally/assets/image.hpp>
+#include <sally/gfx/pixel_convert.hpp>
+#include <SDL.h>
+#include <SDL_image.h>
+
+namespace sally {
+
+	// decoded images are kept as ARGB8888, the layout renderers upload without conversion
+	// (or with a plain red/blue swap for ABGR8888 renderers)
+	static SDL_Surface* to_argb8888(SDL_Surface* surface_)
+	{
+		const Uint32 format = surface_->format->format;
+		if (format == SDL_PIXELFORMAT_ARGB8888)
+			return surface_;
+		SDL_Surface* res = nullptr;
+		if (format == SDL_PIXELFORMAT_ABGR8888 && !SDL_HasColorKey(surface_) && !SDL_MUSTLOCK(surface_)) {
+			res = SDL_CreateRGBSurfaceWithFormat(0, surface_->w, surface_->h, 32, SDL_PIXELFORMAT_ARGB8888);
+			if (res)
+				for (int yy = 0; yy < surface_->h; ++yy)
+					pixel_kernels::swap_rb(reinterpret_cast<const uint32_t*>(static_cast<const uint8_t*>(surface_->pixels) + size_t(yy) * surface_->pitch),
+						reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(res->pixels) + size_t(yy) * res->pitch), surface_->w);
+		}
+		else
+			res = SDL_ConvertSurfaceFormat(surface_, SDL_PIXELFORMAT_ARGB8888, 0);
+		SDL_FreeSurface(surface_);
+		if (!res)
+			throw sdl_exception("converting decoded image to ARGB8888 failed");
+		return res;
+	}
+
+	Image::Image(const std::string& filepath_)
+		: _filepath(filepath_), _surface(nullptr)
+	{
+		SDL_Surface* surf = IMG_Load(filepath_.c_str());
+		if (!surf)
+			throw img_exception("IMG_Load failed", filepath_.c_str());
+		_surface = to_argb8888(surf);
+	}
+
+	Image::~Image()
+	{
+		SDL_FreeSurface(_surface);
+	}
+
+	int Image::width() const
+	{
+		return _surface->w;
+	}
+
+	int Image::height() const
+	{
+		return _surface->h;
+	}
+
+	size_t Image::bytes() const
+	{
+		return size_t(_surface->pitch) * _surface->h;
+	}
+
+}
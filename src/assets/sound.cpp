@@ -0,0 +1,48 @@
+#include <sally/assets/sound.hpp>
+#include <SDL.h>
+
+namespace sally {
+
+	Sound::Sound(const std::string& name_, std::vector<float> stereo_)
+		: _filepath(name_), _samples(std::move(stereo_))
+	{
+		if (_samples.size() & 1)
+			_samples.pop_back(); // incomplete last frame
+	}
+
+	// WAV files (the format SDL decodes without extra libraries) of any layout and rate are
+	// converted once at load, so mixing never resamples
+	Sound::Sound(const std::string& filepath_)
+		: _filepath(filepath_)
+	{
+		SDL_AudioSpec spec;
+		Uint8* wav = nullptr;
+		Uint32 wav_len = 0;
+		if (!SDL_LoadWAV(filepath_.c_str(), &spec, &wav, &wav_len))
+			throw sdl_exception("SDL_LoadWAV failed", filepath_.c_str());
+
+		SDL_AudioCVT cvt;
+		if (SDL_BuildAudioCVT(&cvt, spec.format, spec.channels, spec.freq, AUDIO_F32SYS, 2, SAMPLE_RATE) < 0) {
+			SDL_FreeWAV(wav);
+			throw sdl_exception("SDL_BuildAudioCVT failed", filepath_.c_str());
+		}
+		cvt.len = static_cast<int>(wav_len);
+		cvt.buf = static_cast<Uint8*>(SDL_malloc(size_t(wav_len) * cvt.len_mult));
+		if (!cvt.buf) {
+			SDL_FreeWAV(wav);
+			throw sdl_exception("out of memory decoding", filepath_.c_str());
+		}
+		std::memcpy(cvt.buf, wav, wav_len);
+		SDL_FreeWAV(wav);
+
+		if (cvt.needed && SDL_ConvertAudio(&cvt) != 0) {
+			SDL_free(cvt.buf);
+			throw sdl_exception("SDL_ConvertAudio failed", filepath_.c_str());
+		}
+		const size_t bytes = cvt.needed ? size_t(cvt.len_cvt) : size_t(wav_len);
+		const float* samples = reinterpret_cast<const float*>(cvt.buf);
+		_samples.assign(samples, samples + bytes / (2 * sizeof(float)) * 2);
+		SDL_free(cvt.buf);
+	}
+
+}
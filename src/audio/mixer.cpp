@@ -0,0 +1,378 @@
+#include <sally/audio/mixer.hpp>
+#include <sally/system.hpp>
+#include <SDL.h>
+#include <algorithm>
+
+#if defined(__AVX__)
+# include <immintrin.h>
+# define SALLY_AUDIO_AVX
+# define SALLY_AUDIO_SSE
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+# include <xmmintrin.h>
+# define SALLY_AUDIO_SSE
+#endif
+
+namespace sally {
+
+	namespace audio_kernels {
+
+		void mix_stereo(float* dst_, const float* src_, size_t samples_, float gain_l_, float gain_r_)
+		{
+			size_t ii = 0;
+#if defined(SALLY_AUDIO_AVX)
+			const __m256 gain = _mm256_setr_ps(gain_l_, gain_r_, gain_l_, gain_r_, gain_l_, gain_r_, gain_l_, gain_r_);
+			for (; ii + 8 <= samples_; ii += 8)
+				_mm256_storeu_ps(dst_ + ii, _mm256_add_ps(_mm256_loadu_ps(dst_ + ii), _mm256_mul_ps(_mm256_loadu_ps(src_ + ii), gain)));
+#elif defined(SALLY_AUDIO_SSE)
+			const __m128 gain = _mm_setr_ps(gain_l_, gain_r_, gain_l_, gain_r_);
+			for (; ii + 4 <= samples_; ii += 4)
+				_mm_storeu_ps(dst_ + ii, _mm_add_ps(_mm_loadu_ps(dst_ + ii), _mm_mul_ps(_mm_loadu_ps(src_ + ii), gain)));
+#endif
+			for (; ii + 2 <= samples_; ii += 2) {
+				dst_[ii] += src_[ii] * gain_l_;
+				dst_[ii + 1] += src_[ii + 1] * gain_r_;
+			}
+		}
+
+		void mix_stereo_scalar(float* dst_, const float* src_, size_t samples_, float gain_l_, float gain_r_)
+		{
+			for (size_t ii = 0; ii + 2 <= samples_; ii += 2) {
+				dst_[ii] += src_[ii] * gain_l_;
+				dst_[ii + 1] += src_[ii + 1] * gain_r_;
+			}
+		}
+
+		void master(float* dst_, const float* src_, size_t samples_, float gain_)
+		{
+			size_t ii = 0;
+#if defined(SALLY_AUDIO_AVX)
+			const __m256 gain = _mm256_set1_ps(gain_), lo = _mm256_set1_ps(-1.0f), hi = _mm256_set1_ps(1.0f);
+			for (; ii + 8 <= samples_; ii += 8)
+				_mm256_storeu_ps(dst_ + ii, _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(src_ + ii), gain), lo), hi));
+#elif defined(SALLY_AUDIO_SSE)
+			const __m128 gain = _mm_set1_ps(gain_), lo = _mm_set1_ps(-1.0f), hi = _mm_set1_ps(1.0f);
+			for (; ii + 4 <= samples_; ii += 4)
+				_mm_storeu_ps(dst_ + ii, _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src_ + ii), gain), lo), hi));
+#endif
+			for (; ii < samples_; ++ii)
+				dst_[ii] = std::min(std::max(src_[ii] * gain_, -1.0f), 1.0f);
+		}
+
+		const char* isa()
+		{
+#if defined(SALLY_AUDIO_AVX)
+			return "avx";
+#elif defined(SALLY_AUDIO_SSE)
+			return "sse";
+#else
+			return "scalar";
+#endif
+		}
+
+	}
+
+	// linear pan law: the center plays both channels at full gain
+	static void pan_gains(float gain_, float pan_, float& left_, float& right_)
+	{
+		pan_ = std::min(std::max(pan_, -1.0f), 1.0f);
+		left_ = gain_ * std::min(1.0f, 1.0f - pan_);
+		right_ = gain_ * std::min(1.0f, 1.0f + pan_);
+	}
+
+	AudioMixer::AudioMixer()
+		: _device(0), _buffer_frames(0), _audio_inited(false), _master(1), _callbacks(0), _frames_mixed(0),
+		  _active(0), _dropped(0), _voices_gauge(nullptr), _dropped_counter(nullptr)
+	{
+		for (int ii = 0; ii < MAX_VOICES; ++ii) {
+			_voices[ii]._active = false;
+			_slots[ii]._generation = 0;
+			_slots[ii]._stopping = false;
+		}
+	}
+
+	AudioMixer::~AudioMixer()
+	{
+		close();
+	}
+
+	void AudioMixer::open(const Config& config_)
+	{
+		if (_device)
+			throw general_exception("AudioMixer is already open");
+
+		if (config_.driver)
+			SDL_SetHint(SDL_HINT_AUDIODRIVER, config_.driver);
+		if (SDL_InitSubSystem(SDL_INIT_AUDIO) != 0)
+			throw sdl_exception("SDL_InitSubSystem(SDL_INIT_AUDIO) failed");
+		_audio_inited = true;
+
+		int samples = 16; // SDL wants a power of two
+		while (samples < config_.buffer_frames && samples < 8192)
+			samples *= 2;
+
+		SDL_AudioSpec want, have;
+		SDL_zero(want);
+		want.freq = Sound::SAMPLE_RATE;
+		want.format = AUDIO_F32SYS;
+		want.channels = 2;
+		want.samples = static_cast<Uint16>(samples);
+		want.callback = &AudioMixer::callback;
+		want.userdata = this;
+		// the mixer keeps its own format, SDL converts for devices which differ
+		_device = SDL_OpenAudioDevice(config_.device, 0, &want, &have, SDL_AUDIO_ALLOW_SAMPLES_CHANGE);
+		if (!_device) {
+			SDL_QuitSubSystem(SDL_INIT_AUDIO);
+			_audio_inited = false;
+			throw sdl_exception("SDL_OpenAudioDevice failed");
+		}
+		_buffer_frames = have.samples;
+		_accum.assign(size_t(_buffer_frames) * 2, 0.0f);
+		register_metrics();
+		SDL_PauseAudioDevice(_device, 0);
+	}
+
+	void AudioMixer::close()
+	{
+		if (_device) {
+			SDL_CloseAudioDevice(_device); // returns once the callback is done
+			_device = 0;
+		}
+		// no consumer left: drop pending commands and end every voice
+		Command cmd;
+		while (_commands.pop(cmd))
+			;
+		int slot;
+		while (_ended.pop(slot))
+			;
+		for (int ii = 0; ii < MAX_VOICES; ++ii) {
+			_voices[ii]._active = false;
+			if (_slots[ii]._sound)
+				release(ii);
+		}
+		if (_audio_inited) {
+			SDL_QuitSubSystem(SDL_INIT_AUDIO);
+			_audio_inited = false;
+		}
+	}
+
+	void AudioMixer::register_metrics()
+	{
+		_voices_gauge = &System::metrics().add_gauge("sally_audio_voices", "voices playing");
+		_dropped_counter = &System::metrics().add_counter("sally_audio_dropped_commands_total", "audio commands dropped since the queue was full");
+	}
+
+	bool AudioMixer::post(const Command& cmd_)
+	{
+		if (_commands.push(cmd_))
+			return true;
+		++_dropped;
+		if (_dropped_counter)
+			_dropped_counter->add();
+		return false;
+	}
+
+	int AudioMixer::slot_of(voice_t voice_) const
+	{
+		const int slot = static_cast<int>(voice_ & 0xff) - 1;
+		if (slot < 0 || slot >= MAX_VOICES)
+			return -1;
+		const Slot& ss = _slots[slot];
+		return ss._sound && !ss._stopping && ss._generation == (voice_ >> 8) ? slot : -1;
+	}
+
+	void AudioMixer::release(int slot_)
+	{
+		_slots[slot_]._sound.reset();
+		_slots[slot_]._stopping = false;
+		--_active;
+	}
+
+	AudioMixer::voice_t AudioMixer::play(const shared_ptr<Sound>& sound_, float gain_, float pan_, bool loop_)
+	{
+		if (!sound_ || !sound_->frames())
+			return 0;
+		int slot = 0;
+		while (slot < MAX_VOICES && _slots[slot]._sound)
+			++slot;
+		if (slot == MAX_VOICES)
+			return 0;
+
+		Command cmd;
+		cmd._type = CMD_PLAY;
+		cmd._slot = slot;
+		cmd._sound = sound_.get();
+		pan_gains(gain_, pan_, cmd._gain_l, cmd._gain_r);
+		cmd._loop = loop_;
+		cmd._posted = SDL_GetPerformanceCounter();
+		if (!post(cmd))
+			return 0;
+
+		Slot& ss = _slots[slot];
+		ss._sound = sound_;
+		ss._generation = (ss._generation + 1) & 0xffffff;
+		ss._stopping = false;
+		++_active;
+		return (voice_t(ss._generation) << 8) | voice_t(slot + 1);
+	}
+
+	void AudioMixer::stop(voice_t voice_)
+	{
+		const int slot = slot_of(voice_);
+		if (slot < 0)
+			return;
+		Command cmd;
+		cmd._type = CMD_STOP;
+		cmd._slot = slot;
+		if (post(cmd))
+			_slots[slot]._stopping = true; // released once the callback reports the voice ended
+	}
+
+	void AudioMixer::set_gain(voice_t voice_, float gain_, float pan_)
+	{
+		const int slot = slot_of(voice_);
+		if (slot < 0)
+			return;
+		Command cmd;
+		cmd._type = CMD_GAIN;
+		cmd._slot = slot;
+		pan_gains(gain_, pan_, cmd._gain_l, cmd._gain_r);
+		post(cmd);
+	}
+
+	void AudioMixer::stop_all()
+	{
+		Command cmd;
+		cmd._type = CMD_STOP_ALL;
+		if (!post(cmd))
+			return;
+		for (int ii = 0; ii < MAX_VOICES; ++ii)
+			if (_slots[ii]._sound)
+				_slots[ii]._stopping = true;
+	}
+
+	void AudioMixer::set_master_gain(float gain_)
+	{
+		Command cmd;
+		cmd._type = CMD_MASTER;
+		cmd._gain_l = gain_;
+		post(cmd);
+	}
+
+	bool AudioMixer::playing(voice_t voice_) const
+	{
+		return slot_of(voice_) >= 0;
+	}
+
+	void AudioMixer::update()
+	{
+		int slot;
+		while (_ended.pop(slot))
+			release(slot);
+		if (_voices_gauge)
+			_voices_gauge->set(_active);
+	}
+
+	void AudioMixer::render(float* out_, int frames_)
+	{
+		if (_device)
+			throw general_exception("AudioMixer::render while the device is open");
+		if (_accum.empty())
+			_accum.assign(size_t(256) * 2, 0.0f);
+		mix(out_, frames_);
+	}
+
+	//static
+	void AudioMixer::callback(void* mixer_, uint8_t* stream_, int len_)
+	{
+		AudioMixer& mixer = *static_cast<AudioMixer*>(mixer_);
+		const Uint64 start = SDL_GetPerformanceCounter();
+		mixer.mix(reinterpret_cast<float*>(stream_), len_ / static_cast<int>(2 * sizeof(float)));
+		mixer._callback_time.record((SDL_GetPerformanceCounter() - start) * 1000000 / SDL_GetPerformanceFrequency());
+		mixer._callbacks.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void AudioMixer::apply(const Command& cmd_)
+	{
+		switch (cmd_._type) {
+		case CMD_PLAY: {
+			Voice& vv = _voices[cmd_._slot];
+			vv._samples = cmd_._sound->samples();
+			vv._frames = cmd_._sound->frames();
+			vv._pos = 0;
+			vv._gain_l = cmd_._gain_l;
+			vv._gain_r = cmd_._gain_r;
+			vv._loop = cmd_._loop;
+			vv._active = true;
+			vv._posted = cmd_._posted;
+			break;
+		}
+		case CMD_STOP:
+			if (_voices[cmd_._slot]._active) {
+				_voices[cmd_._slot]._active = false;
+				_ended.push(cmd_._slot);
+			}
+			break;
+		case CMD_GAIN:
+			_voices[cmd_._slot]._gain_l = cmd_._gain_l;
+			_voices[cmd_._slot]._gain_r = cmd_._gain_r;
+			break;
+		case CMD_STOP_ALL:
+			for (int ii = 0; ii < MAX_VOICES; ++ii)
+				if (_voices[ii]._active) {
+					_voices[ii]._active = false;
+					_ended.push(ii);
+				}
+			break;
+		case CMD_MASTER:
+			_master = cmd_._gain_l;
+			break;
+		}
+	}
+
+	void AudioMixer::mix(float* out_, int frames_)
+	{
+		Command cmd;
+		while (_commands.pop(cmd))
+			apply(cmd);
+
+		const Uint64 now = SDL_GetPerformanceCounter();
+		const Uint64 freq = SDL_GetPerformanceFrequency();
+		for (int ii = 0; ii < MAX_VOICES; ++ii) {
+			Voice& vv = _voices[ii];
+			if (vv._active && vv._posted) {
+				_command_latency.record((now - std::min(now, vv._posted)) * 1000000 / freq);
+				vv._posted = 0;
+			}
+		}
+
+		// the device may ask for more than one accumulator worth of frames
+		const int chunk = static_cast<int>(_accum.size() / 2);
+		float* const acc = _accum.data();
+		for (int done = 0; done < frames_;) {
+			const int count = std::min(frames_ - done, chunk);
+			std::fill(acc, acc + 2 * count, 0.0f);
+			for (int ii = 0; ii < MAX_VOICES; ++ii) {
+				Voice& vv = _voices[ii];
+				int filled = 0;
+				while (vv._active && filled < count) {
+					const size_t take = std::min(vv._frames - vv._pos, size_t(count - filled));
+					audio_kernels::mix_stereo(acc + 2 * filled, vv._samples + 2 * vv._pos, 2 * take, vv._gain_l, vv._gain_r);
+					filled += static_cast<int>(take);
+					vv._pos += take;
+					if (vv._pos == vv._frames) {
+						if (vv._loop)
+							vv._pos = 0;
+						else {
+							vv._active = false;
+							_ended.push(ii); // never full, it holds more than MAX_VOICES slots
+						}
+					}
+				}
+			}
+			audio_kernels::master(out_ + 2 * done, acc, 2 * size_t(count), _master);
+			done += count;
+		}
+		_frames_mixed.fetch_add(uint64_t(frames_), std::memory_order_relaxed);
+	}
+
+}
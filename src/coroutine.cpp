@@ -0,0 +1,47 @@
+#include <sally/coroutine.hpp>
+
+#ifdef SALLY_COROUTINES
+
+#include <sally/util/logger.hpp>
+#include <sally/util/worker_pool.hpp>
+#include <typeinfo>
+
+namespace sally {
+
+	void detail::log_task_error(std::exception_ptr error_)
+	{
+		try {
+			std::rethrow_exception(error_);
+		}
+		catch (sally::exception& e) {
+			loge() << typeid(e).name() << " in coroutine : " << e.what();
+		}
+		catch (std::exception& e) {
+			loge() << typeid(e).name() << " in coroutine : " << e.what();
+		}
+		catch (...) {
+			loge() << "unknown exception in coroutine";
+		}
+	}
+
+	void async_image::await_suspend(std::coroutine_handle<> handle_)
+	{
+		_handle = handle_;
+		worker_pool::shared().post([this] { load(); });
+	}
+
+	void async_image::load()
+	{
+		try {
+			_image = System::asset_manager().image(_filepath);
+		}
+		catch (...) {
+			_error = std::current_exception();
+		}
+		const std::coroutine_handle<> handle = _handle; // this lives in the frame resumed below
+		System::post_main([handle] { handle.resume(); }, main_thread_queue::PRIORITY_HIGH);
+	}
+
+}
+
+#endif
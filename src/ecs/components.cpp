@@ -0,0 +1,48 @@
+#include <sally/ecs/components.hpp>
+
+namespace sally {
+	namespace ecs {
+
+		void integrate_velocity(World& world_, float dt_)
+		{
+			world_.each_chunk<Position, const Velocity>([dt_](size_t count_, Position* pos_, const Velocity* vel_) {
+				for (size_t ii = 0; ii < count_; ++ii) {
+					pos_[ii]._x += vel_[ii]._x * dt_;
+					pos_[ii]._y += vel_[ii]._y * dt_;
+				}
+			});
+		}
+
+		void SpriteDrawer::draw(World& world_, Renderer& renderer_, int offset_x_, int offset_y_)
+		{
+			// forget renderables not drawn last frame, they may be gone
+			for (auto it = _batches.begin(); it != _batches.end();) {
+				if (it->second._src.empty()) {
+					it = _batches.erase(it);
+					continue;
+				}
+				it->second._src.clear();
+				it->second._dst.clear();
+				it->second._tints.clear();
+				++it;
+			}
+
+			const Rect out = renderer_.output_rect();
+			world_.each<const Position, const Sprite>([&](const Position& pos_, const Sprite& spr_) {
+				const Rect dst(int(pos_._x) + offset_x_, int(pos_._y) + offset_y_, spr_._width, spr_._height);
+				if (!spr_._renderable || dst._x >= out._x + out._width || dst._y >= out._y + out._height
+					|| dst._x + dst._width <= out._x || dst._y + dst._height <= out._y)
+					return;
+				Batch& batch = _batches[spr_._renderable];
+				batch._src.push_back(spr_._src);
+				batch._dst.push_back(dst);
+				batch._tints.push_back(spr_._tint);
+			});
+
+			for (auto& batch : _batches)
+				renderer_.render_batch(batch.first, batch.second._src.data(), batch.second._dst.data(),
+					batch.second._tints.data(), batch.second._src.size());
+		}
+
+	}
+}
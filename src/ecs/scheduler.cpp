@@ -0,0 +1,40 @@
+#include <sally/ecs/scheduler.hpp>
+#include <sally/util/worker_pool.hpp>
+
+namespace sally {
+	namespace ecs {
+
+		void Scheduler::add(const std::string& name_, signature_t reads_, signature_t writes_, system_fn system_)
+		{
+			_systems.push_back(SystemEntry{ name_, reads_, writes_, std::move(system_) });
+			const SystemEntry& sys = _systems.back();
+
+			size_t stage = 0;
+			for (size_t ss = _stages.size(); ss > 0; --ss) {
+				bool conflicts = false;
+				for (size_t other : _stages[ss - 1])
+					conflicts = conflicts || conflict(sys, _systems[other]);
+				if (conflicts) {
+					stage = ss;
+					break;
+				}
+			}
+			if (stage == _stages.size())
+				_stages.emplace_back();
+			_stages[stage].push_back(_systems.size() - 1);
+		}
+
+		void Scheduler::run(World& world_, worker_pool* pool_)
+		{
+			for (const std::vector<size_t>& stage : _stages) {
+				if (stage.size() == 1 || !pool_)
+					for (size_t sys : stage)
+						_systems[sys]._fn(world_);
+				else
+					pool_->run(stage.size(), [&](size_t index_) { _systems[stage[index_]]._fn(world_); });
+			}
+			world_.flush_deferred();
+		}
+
+	}
+}
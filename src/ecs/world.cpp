@@ -0,0 +1,260 @@
+#include <sally/ecs/world.hpp>
+#include <sally/util/worker_pool.hpp>
+#include <algorithm>
+
+namespace sally {
+	namespace ecs {
+
+		namespace detail {
+
+			namespace {
+				struct component_info {
+					size_t _size;
+					size_t _align;
+				};
+				component_info components[MAX_COMPONENTS];
+				int component_count = 0;
+				spinlock component_lock;
+			}
+
+			int register_component(size_t size_, size_t align_)
+			{
+				spinlock::Guard lg(component_lock);
+				if (component_count >= MAX_COMPONENTS)
+					throw general_exception("too many ecs component types");
+				components[component_count]._size = size_;
+				components[component_count]._align = align_;
+				return component_count++;
+			}
+
+			size_t component_size(int id_) { return components[id_]._size; }
+			size_t component_align(int id_) { return components[id_]._align; }
+		}
+
+		namespace {
+			inline uint32_t slot_of(entity_t entity_) { return static_cast<uint32_t>(entity_); }
+			inline uint32_t generation_of(entity_t entity_) { return static_cast<uint32_t>(entity_ >> 32); }
+			inline entity_t make_entity(uint32_t slot_, uint32_t generation_) { return (entity_t(generation_) << 32) | slot_; }
+			inline size_t align_up(size_t v_, size_t align_) { return (v_ + align_ - 1) / align_ * align_; }
+		}
+
+		// Archetype:
+
+		Archetype::Archetype(signature_t signature_)
+			: _signature(signature_), _capacity(0), _chunk_words(0), _size(0)
+		{
+			size_t row_bytes = sizeof(entity_t);
+			for (int id = 0; id < MAX_COMPONENTS; ++id) {
+				_offsets[id] = 0;
+				if (_signature & (signature_t(1) << id)) {
+					_components.push_back(id);
+					row_bytes += detail::component_size(id);
+				}
+			}
+
+			// as many rows as fit a chunk (at least one), shrunk until the aligned arrays fit
+			_capacity = std::max<size_t>(CHUNK_BYTES / row_bytes, 1);
+			size_t bytes = 0;
+			for (;;) {
+				bytes = sizeof(entity_t) * _capacity;
+				for (int id : _components) {
+					bytes = align_up(bytes, detail::component_align(id));
+					_offsets[id] = bytes;
+					bytes += detail::component_size(id) * _capacity;
+				}
+				if (bytes <= CHUNK_BYTES || _capacity == 1)
+					break;
+				--_capacity;
+			}
+			_chunk_words = (bytes + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t);
+		}
+
+		void Archetype::push(entity_t entity_, size_t& chunk_, size_t& row_)
+		{
+			if (_chunks.empty() || _chunks.back()._count == _capacity) {
+				Chunk chunk;
+				chunk._data.reset(new std::max_align_t[_chunk_words]);
+				chunk._count = 0;
+				_chunks.push_back(std::move(chunk));
+			}
+			chunk_ = _chunks.size() - 1;
+			Chunk& chunk = _chunks.back();
+			row_ = chunk._count++;
+			entities(chunk)[row_] = entity_;
+			++_size;
+		}
+
+		entity_t Archetype::erase(size_t chunk_, size_t row_)
+		{
+			Chunk& last = _chunks.back();
+			const size_t last_row = last._count - 1;
+			entity_t moved = NULL_ENTITY;
+			if (&last != &_chunks[chunk_] || last_row != row_) {
+				moved = entities(last)[last_row];
+				entities(_chunks[chunk_])[row_] = moved;
+				for (int id : _components)
+					memcpy(cell(chunk_, row_, id), cell(_chunks.size() - 1, last_row, id), detail::component_size(id));
+			}
+			if (--last._count == 0)
+				_chunks.pop_back();
+			--_size;
+			return moved;
+		}
+
+		// World:
+
+		World::World() : _alive(0)
+		{
+		}
+
+		World::~World()
+		{
+		}
+
+		const World::Record* World::record(entity_t entity_) const
+		{
+			const uint32_t slot = slot_of(entity_);
+			if (slot >= _records.size())
+				return nullptr;
+			const Record& rec = _records[slot];
+			return rec._archetype && rec._generation == generation_of(entity_) ? &rec : nullptr;
+		}
+
+		bool World::alive(entity_t entity_) const
+		{
+			return record(entity_) != nullptr;
+		}
+
+		Archetype& World::archetype(signature_t signature_)
+		{
+			unique_ptr<Archetype>& arch = _archetypes[signature_];
+			if (!arch) {
+				arch.reset(new Archetype(signature_));
+				_archetype_list.push_back(arch.get());
+			}
+			return *arch;
+		}
+
+		entity_t World::create()
+		{
+			return create_with(0);
+		}
+
+		entity_t World::create_with(signature_t signature_)
+		{
+			uint32_t slot;
+			if (!_free.empty()) {
+				slot = _free.back();
+				_free.pop_back();
+			}
+			else {
+				slot = static_cast<uint32_t>(_records.size());
+				_records.push_back(Record{ nullptr, 0, 0, 1 });
+			}
+			Record& rec = _records[slot];
+			const entity_t ent = make_entity(slot, rec._generation);
+			rec._archetype = &archetype(signature_);
+			rec._archetype->push(ent, rec._chunk, rec._row);
+			for (int id : rec._archetype->_components)
+				memset(rec._archetype->cell(rec._chunk, rec._row, id), 0, detail::component_size(id));
+			++_alive;
+			return ent;
+		}
+
+		void World::destroy(entity_t entity_)
+		{
+			if (!record(entity_))
+				return;
+			Record& rec = _records[slot_of(entity_)];
+			entity_t moved = rec._archetype->erase(rec._chunk, rec._row);
+			if (moved != NULL_ENTITY) {
+				Record& mrec = _records[slot_of(moved)];
+				mrec._chunk = rec._chunk;
+				mrec._row = rec._row;
+			}
+			rec._archetype = nullptr;
+			if (++rec._generation == 0)
+				rec._generation = 1; // keep NULL_ENTITY invalid
+			_free.push_back(slot_of(entity_));
+			--_alive;
+		}
+
+		void World::move_entity(entity_t entity_, Archetype& to_)
+		{
+			Record& rec = _records[slot_of(entity_)];
+			Archetype& from = *rec._archetype;
+			size_t chunk, row;
+			to_.push(entity_, chunk, row);
+			for (int id : to_._components) {
+				void* dst = to_.cell(chunk, row, id);
+				if (from._signature & (signature_t(1) << id))
+					memcpy(dst, from.cell(rec._chunk, rec._row, id), detail::component_size(id));
+				else
+					memset(dst, 0, detail::component_size(id));
+			}
+			entity_t moved = from.erase(rec._chunk, rec._row);
+			if (moved != NULL_ENTITY) {
+				Record& mrec = _records[slot_of(moved)];
+				mrec._chunk = rec._chunk;
+				mrec._row = rec._row;
+			}
+			rec._archetype = &to_;
+			rec._chunk = chunk;
+			rec._row = row;
+		}
+
+		void* World::add_component(entity_t entity_, int component_)
+		{
+			if (!record(entity_))
+				throw general_exception("adding a component to a dead entity");
+			Record& rec = _records[slot_of(entity_)];
+			const signature_t bit = signature_t(1) << component_;
+			if (!(rec._archetype->_signature & bit))
+				move_entity(entity_, archetype(rec._archetype->_signature | bit));
+			return rec._archetype->cell(rec._chunk, rec._row, component_);
+		}
+
+		void World::remove_component(entity_t entity_, int component_)
+		{
+			const Record* rec = record(entity_);
+			const signature_t bit = signature_t(1) << component_;
+			if (rec && (rec->_archetype->_signature & bit))
+				move_entity(entity_, archetype(rec->_archetype->_signature & ~bit));
+		}
+
+		const std::vector<Archetype*>& World::query(signature_t signature_)
+		{
+			spinlock::Guard lg(_query_lock);
+			QueryCache& cache = _queries[signature_];
+			for (; cache._scanned < _archetype_list.size(); ++cache._scanned) {
+				Archetype* arch = _archetype_list[cache._scanned];
+				if ((arch->_signature & signature_) == signature_)
+					cache._archetypes.push_back(arch);
+			}
+			return cache._archetypes;
+		}
+
+		void World::run_parallel(worker_pool& pool_, size_t count_, const std::function<void(size_t)>& task_)
+		{
+			pool_.run(count_, task_);
+		}
+
+		void World::defer(std::function<void(World&)> change_)
+		{
+			spinlock::Guard lg(_deferred_lock);
+			_deferred.push_back(std::move(change_));
+		}
+
+		void World::flush_deferred()
+		{
+			std::vector<std::function<void(World&)> > changes;
+			{
+				spinlock::Guard lg(_deferred_lock);
+				changes.swap(_deferred);
+			}
+			for (auto& change : changes)
+				change(*this);
+		}
+
+	}
+}
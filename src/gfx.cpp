@@ -1,59 +1,25 @@
 #include <sally/gfx.hpp>
+#include <sally/gfx/soft_raster.hpp>
+#include <sally/gfx/frame_capture.hpp>
+#include <sally/gfx/pixel_convert.hpp>
+#include <sally/input/hit_index.hpp>
 #include <sally/util/logger.hpp>
+#include <sally/util/worker_pool.hpp>
 #include <sally/system.hpp>
 #include <SDL.h>
-#include <SDL_image.h>
 #include <sstream>
 #include <algorithm>
+#include <cmath>
 
 namespace sally {
 
-	// Font:
+	// FontManager:
 
-	Font::Font(const std::string& filepath_, int ptsize_, long index_)
+	Font* FontManager::load_font(const std::string& name_, const std::string& filepath_, int ptsize_, long index_)
 	{
-		_font = TTF_OpenFontIndex(filepath_.c_str(), ptsize_, index_);
-		if (!_font)
-			throw ttf_exception("TTF_OpenFontIndex failed", filepath_.c_str());
-	}
-
-	Font::~Font()
-	{
-		TTF_CloseFont(_font);
-	}
-
-	void Font::set_style(int style_)
-	{
-		TTF_SetFontStyle(_font, style_);
-	}
-
-	int Font::get_style() const
-	{
-		return TTF_GetFontStyle(_font);
-	}
-
-	int Font::height() const
-	{
-		return TTF_FontHeight(_font);
-	}
-
-	int Font::lineskip() const
-	{
-		return TTF_FontLineSkip(_font);
-	}
-
-	int Font::calc_width(const char* utf8_) const
-	{
-		int w = -1;
-		return TTF_SizeUTF8(_font, utf8_, &w, nullptr) == 0 ? w : -1;
-	}
-
-	int Font::calc_width(const wchar_t* unicode_) const
-	{
-		if (sizeof(wchar_t) != sizeof(Uint16))
-			throw general_exception("calc_width on unicode string not supported when sizeof(wchar_t) != sizeof(Uint16)");
-		int w = -1;
-		return TTF_SizeUNICODE(_font, reinterpret_cast<const Uint16*>(unicode_), &w, nullptr) == 0 ? w : -1;
+		shared_ptr<Font> font = System::asset_manager().font(filepath_, ptsize_, index_);
+		_map[name_] = font;
+		return font.get();
 	}
 
 	// Texture:
@@ -61,10 +27,15 @@ namespace sally {
 	void Texture::reinit(SDL_Texture* texture_)
 	{
 		if (_texture)
-			SDL_DestroyTexture(_texture);
+			Renderer::destroy_texture(_texture);
 		_texture = texture_;
-		if (_texture && SDL_QueryTexture(_texture, nullptr, nullptr, &_width, &_height) != 0)
-			throw sdl_exception("new texture SDL_QueryTexture failed");
+		_bytes = 0;
+		if (_texture) {
+			Uint32 format = 0;
+			if (SDL_QueryTexture(_texture, &format, nullptr, &_width, &_height) != 0)
+				throw sdl_exception("new texture SDL_QueryTexture failed");
+			_bytes = size_t(_width) * _height * SDL_BYTESPERPIXEL(format);
+		}
 	}
 
 	SDL_Texture* Texture::texture_for_render(Renderer& renderer_)
@@ -80,18 +51,106 @@ namespace sally {
 		rect_._height = _height;
 	}
 
+	// ImageFile:
+
+	SDL_Texture* ImageFile::texture_for_render(Renderer& renderer_)
+	{
+		if (!_texture)
+			reinit(renderer_.texture_from_image(*_image));
+		return _texture;
+	}
+
+	bool ImageFile::evict_texture()
+	{
+		if (!_texture)
+			return false;
+		reinit(nullptr);
+		return true;
+	}
+
 	// TextLine:
 
 	void TextLine::cache_texture(Renderer& renderer_)
 	{
+		static counter& rasterizations = System::metrics().add_counter("sally_text_rasterizations_total", "text lines rendered to pixels (cache misses)");
+
 		if (SDL_AtomicGet(&_cached))
 			return;
+		rasterizations.add();
 		spinlock::Guard lg(_lock);
-		std::string text = _text;
+		_render_text = _text;
+		const std::string& text = _render_text;
 		Color color = _color;
 		SDL_AtomicSet(&_cached, 1);
 		lg.unlock();
-		reinit(renderer_.render_sdl_text(_font, color, text, _mode));
+		if (_update == UPDATE_STREAMING && !renderer_.software_raster()) {
+			SDL_Surface* surf = renderer_.render_text_surface(_font, color, text, _mode);
+			try {
+				stream_text(renderer_, surf);
+			}
+			catch (...) {
+				SDL_FreeSurface(surf);
+				throw;
+			}
+			SDL_FreeSurface(surf);
+		}
+		else
+			reinit(renderer_.render_sdl_text(_font, color, text, _mode));
+	}
+
+	void TextLine::release_texture()
+	{
+		reinit(0);
+		_shadow.clear();
+		_tex_width = _tex_height = 0;
+		SDL_AtomicSet(&_cached, 0);
+	}
+
+	void TextLine::stream_text(Renderer& renderer_, SDL_Surface* argb_)
+	{
+		const int width = argb_->w, height = argb_->h;
+		if (!_texture || width > _tex_width || height > _tex_height) {
+			// grow with headroom so slightly longer text does not reallocate again
+			const int tex_width = (std::max(width, 16) * 3 / 2 + 31) & ~31;
+			reinit(renderer_.create_streaming_texture(tex_width, height));
+			_tex_width = tex_width;
+			_tex_height = height;
+			_shadow.assign(size_t(_tex_width) * _tex_height, 0);
+			renderer_.update_texture(_texture, Rect(0, 0, _tex_width, _tex_height), _shadow.data(), _tex_width * 4);
+			_content = Rect();
+		}
+
+		// bounding box of the pixels that differ from what the texture holds,
+		// the part of the old text beyond the new one becomes transparent
+		const int span = std::max(width, _content._width), rows = std::max(height, _content._height);
+		int x0 = span, x1 = 0, y0 = rows, y1 = 0;
+		for (int yy = 0; yy < rows; ++yy) {
+			const uint32_t* src = yy < height ? reinterpret_cast<const uint32_t*>(static_cast<const uint8_t*>(argb_->pixels) + size_t(yy) * argb_->pitch) : nullptr;
+			uint32_t* shadow = _shadow.data() + size_t(yy) * _tex_width;
+			int first = span, last = -1;
+			for (int xx = 0; xx < span; ++xx) {
+				const uint32_t px = src && xx < width ? src[xx] : 0;
+				if (px != shadow[xx]) {
+					first = std::min(first, xx);
+					last = xx;
+					shadow[xx] = px;
+				}
+			}
+			if (last >= 0) {
+				x0 = std::min(x0, first);
+				x1 = std::max(x1, last + 1);
+				y0 = std::min(y0, yy);
+				y1 = yy + 1;
+			}
+		}
+		_last_update_pixels = 0;
+		if (x1 > x0) {
+			renderer_.update_texture(_texture, Rect(x0, y0, x1 - x0, y1 - y0), _shadow.data() + size_t(y0) * _tex_width + x0, _tex_width * 4);
+			_last_update_pixels = size_t(x1 - x0) * (y1 - y0);
+		}
+		_content = Rect(0, 0, width, height);
+		_width = width;
+		_height = height;
 	}
 
 	SDL_Texture* TextLine::texture_for_render(Renderer& renderer_)
@@ -106,32 +165,237 @@ namespace sally {
 		return Texture::fill_bounding_rect(renderer_, rect_);
 	}
 
+	bool TextLine::evict_texture()
+	{
+		if (!_texture)
+			return false;
+		release_texture();
+		return true;
+	}
+
 	// Renderer:
 
-	void Renderer::initialize(SDL_Window* window_)
+	Renderer::Renderer()
+		: _renderer(nullptr), _frame(0), _soft_target(nullptr), _offscreen(nullptr), _native_format(SDL_PIXELFORMAT_ARGB8888), _present_ticks(0),
+		  _scale(1), _frame_scale(1), _over(0), _under(0), _scaled_target(nullptr),
+		  _transforms(1), _transformed(false), _window_view_saved(false), _capture(nullptr)
+	{
+	}
+
+	void Renderer::initialize(SDL_Window* window_, bool software_raster_)
 	{
 		_renderer = SDL_CreateRenderer(window_, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
 		if (!_renderer)
 			throw sdl_exception("SDL_CreateRenderer failed");
+
+		choose_native_format();
+		if (software_raster_)
+			init_software_raster();
+		reset_view();
+	}
+
+	void Renderer::initialize_offscreen(int width_, int height_, bool software_raster_)
+	{
+		_offscreen = SDL_CreateRGBSurfaceWithFormat(0, width_, height_, 32, SDL_PIXELFORMAT_ARGB8888);
+		if (!_offscreen)
+			throw sdl_exception("SDL_CreateRGBSurfaceWithFormat failed (offscreen renderer)");
+
+		_renderer = SDL_CreateSoftwareRenderer(_offscreen);
+		if (!_renderer)
+			throw sdl_exception("SDL_CreateSoftwareRenderer failed");
+
+		choose_native_format();
+		if (software_raster_)
+			init_software_raster();
+		reset_view();
+	}
+
+	void Renderer::init_software_raster()
+	{
+		const Rect& osz = output_rect();
+		_soft_target = SDL_CreateTexture(_renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, osz._width, osz._height);
+		if (!_soft_target)
+			throw sdl_exception("SDL_CreateTexture failed (software raster target)");
+		SDL_SetTextureScaleMode(_soft_target, SDL_ScaleModeLinear); // upscaling of dynamic resolution frames
+		_soft.reset(new SoftRaster(osz._width, osz._height));
+		_native_format = SDL_PIXELFORMAT_ARGB8888; // what the rasterizer reads, so texture copies are plain
+	}
+
+	void Renderer::choose_native_format()
+	{
+		// the first format the renderer lists is the one it handles best, use it if we can convert to it
+		SDL_RendererInfo info;
+		_native_format = SDL_PIXELFORMAT_ARGB8888;
+		if (SDL_GetRendererInfo(_renderer, &info) != 0)
+			return;
+		for (Uint32 ii = 0; ii < info.num_texture_formats; ++ii)
+			if (info.texture_formats[ii] == SDL_PIXELFORMAT_ARGB8888 || info.texture_formats[ii] == SDL_PIXELFORMAT_ABGR8888) {
+				_native_format = info.texture_formats[ii];
+				return;
+			}
 	}
 	
 	Renderer::~Renderer()
 	{
+		// renderables first: SDL_DestroyRenderer frees their textures without the ARGB8888 copies
+		// attached for the software rasterizer, and destroying them afterwards would free them twice
+		{
+			shared_mutex::Guard lg(_lock);
+			_map.clear();
+		}
+		_evict_candidates.clear();
+		_batch.reset();
+		_capture = nullptr; // not owned
+		_soft.reset();
+		if (_soft_target) {
+			SDL_DestroyTexture(_soft_target);
+			_soft_target = nullptr;
+		}
+		if (_scaled_target) {
+			SDL_DestroyTexture(_scaled_target);
+			_scaled_target = nullptr;
+		}
 		if (_renderer) {
 			SDL_DestroyRenderer(_renderer);
 			_renderer = nullptr;
 		}
+		if (_offscreen) {
+			SDL_FreeSurface(_offscreen);
+			_offscreen = nullptr;
+		}
+	}
+
+	Texture* Renderer::load_image(const std::string& name_, const std::string& filepath_)
+	{
+		shared_ptr<Image> image = System::asset_manager().image(filepath_);
+		return insert(name_, new ImageFile(image, texture_from_image(*image)));
+	}
+
+	SDL_Texture* Renderer::texture_from_image(const Image& image_)
+	{
+		SDL_Texture* texture = texture_from_surface(image_.sdl_surface());
+		if (!texture)
+			throw sdl_exception("SDL_CreateTextureFromSurface failed", image_.filepath().c_str());
+		return texture;
+	}
+
+	SDL_Texture* Renderer::texture_from_surface(SDL_Surface* surface_, bool premultiply_)
+	{
+		const Uint32 format = surface_->format->format;
+		SDL_Texture* texture = nullptr;
+		if ((format == SDL_PIXELFORMAT_ARGB8888 || format == SDL_PIXELFORMAT_ABGR8888) && !SDL_HasColorKey(surface_) && !SDL_MUSTLOCK(surface_))
+			texture = upload_argb(surface_, premultiply_ && !_soft);
+		else
+			texture = SDL_CreateTextureFromSurface(_renderer, surface_);
+		if (texture && _soft) {
+			// the software rasterizer reads pixels from an ARGB8888 copy attached to the texture:
+			SDL_Surface* pixels = SDL_ConvertSurfaceFormat(surface_, SDL_PIXELFORMAT_ARGB8888, 0);
+			if (!pixels) {
+				SDL_DestroyTexture(texture);
+				throw sdl_exception("SDL_ConvertSurfaceFormat failed (software raster texture)");
+			}
+			SDL_SetTextureUserData(texture, pixels);
+		}
+		return texture;
 	}
 
-	SDL_Texture* Renderer::image_from_file(const std::string& filepath_)
+	SDL_Texture* Renderer::upload_argb(SDL_Surface* surface_, bool premultiply_)
 	{
-		SDL_Texture* texture = IMG_LoadTexture(_renderer, filepath_.c_str());
+		static const SDL_BlendMode premultiplied = SDL_ComposeCustomBlendMode(
+			SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD,
+			SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD);
+
+		const int width = surface_->w, height = surface_->h;
+		SDL_Texture* texture = SDL_CreateTexture(_renderer, _native_format, SDL_TEXTUREACCESS_STATIC, width, height);
 		if (!texture)
-			throw img_exception("IMG_LoadTexture failed", filepath_.c_str());
+			return nullptr;
+		if (!premultiply_ || SDL_SetTextureBlendMode(texture, premultiplied) != 0) {
+			premultiply_ = false;
+			SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+		}
+
+		int res = 0;
+		const bool swap = surface_->format->format != _native_format;
+		if (!swap && !premultiply_)
+			res = SDL_UpdateTexture(texture, nullptr, surface_->pixels, surface_->pitch);
+		else {
+			std::vector<uint32_t> converted(size_t(width) * height);
+			for (int yy = 0; yy < height; ++yy) {
+				const uint32_t* src = reinterpret_cast<const uint32_t*>(static_cast<const uint8_t*>(surface_->pixels) + size_t(yy) * surface_->pitch);
+				uint32_t* dst = converted.data() + size_t(yy) * width;
+				if (swap)
+					pixel_kernels::swap_rb(src, dst, width);
+				if (premultiply_)
+					pixel_kernels::premultiply(swap ? dst : src, dst, width);
+			}
+			res = SDL_UpdateTexture(texture, nullptr, converted.data(), width * 4);
+		}
+		if (res != 0) {
+			SDL_DestroyTexture(texture);
+			return nullptr;
+		}
 		return texture;
 	}
 
-	SDL_Texture* Renderer::render_sdl_text(Font* font_, const Color& color_, const std::string& utf8_, Font::render_mode_t mode_)
+	SDL_Texture* Renderer::create_streaming_texture(int width_, int height_)
+	{
+		SDL_Texture* texture = SDL_CreateTexture(_renderer, _native_format, SDL_TEXTUREACCESS_STREAMING, width_, height_);
+		if (!texture)
+			throw sdl_exception("SDL_CreateTexture failed (streaming texture)");
+		SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+		return texture;
+	}
+
+	void Renderer::update_texture(SDL_Texture* texture_, const Rect& rect_, const uint32_t* argb_, int pitch_)
+	{
+		void* pixels = nullptr;
+		int pitch = 0;
+		if (SDL_LockTexture(texture_, &rect_.sdl_rect(), &pixels, &pitch) != 0)
+			throw sdl_exception("SDL_LockTexture failed");
+		const bool swap = _native_format != SDL_PIXELFORMAT_ARGB8888;
+		for (int yy = 0; yy < rect_._height; ++yy) {
+			const uint32_t* src = reinterpret_cast<const uint32_t*>(reinterpret_cast<const uint8_t*>(argb_) + size_t(yy) * pitch_);
+			uint32_t* dst = reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(pixels) + size_t(yy) * pitch);
+			if (swap)
+				pixel_kernels::swap_rb(src, dst, rect_._width);
+			else
+				memcpy(dst, src, size_t(rect_._width) * 4);
+		}
+		SDL_UnlockTexture(texture_);
+	}
+
+	//static
+	void Renderer::destroy_texture(SDL_Texture* texture_)
+	{
+		if (!texture_)
+			return;
+		if (SDL_Surface* pixels = static_cast<SDL_Surface*>(SDL_GetTextureUserData(texture_)))
+			SDL_FreeSurface(pixels);
+		SDL_DestroyTexture(texture_);
+	}
+
+	// antialiased text as ARGB8888: the shaded glyph pixels are 8 bit coverage values, expanding
+	// them with the text color is cheaper than TTF_RenderText_Blended's per pixel blending
+	static SDL_Surface* render_blended_text(Font* font_, const Color& color_, const std::string& utf8_)
+	{
+		static const SDL_Color background = { 0, 0, 0, 0 };
+		SDL_Surface* glyphs = TTF_RenderText_Shaded(font_->sdl_font(), utf8_.c_str(), color_.sdl_color(), background);
+		if (!glyphs)
+			throw ttf_exception("TTF_RenderText_Shaded failed", utf8_.c_str());
+		SDL_Surface* surf = SDL_CreateRGBSurfaceWithFormat(0, glyphs->w, glyphs->h, 32, SDL_PIXELFORMAT_ARGB8888);
+		if (!surf) {
+			SDL_FreeSurface(glyphs);
+			throw sdl_exception("SDL_CreateRGBSurfaceWithFormat failed (rendering text)");
+		}
+		const uint32_t color = (uint32_t(color_._a) << 24) | (uint32_t(color_._r) << 16) | (uint32_t(color_._g) << 8) | color_._b;
+		for (int yy = 0; yy < glyphs->h; ++yy)
+			pixel_kernels::alpha_to_argb(static_cast<const uint8_t*>(glyphs->pixels) + size_t(yy) * glyphs->pitch,
+				reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(surf->pixels) + size_t(yy) * surf->pitch), glyphs->w, color);
+		SDL_FreeSurface(glyphs);
+		return surf;
+	}
+
+	SDL_Surface* Renderer::render_text_surface(Font* font_, const Color& color_, const std::string& utf8_, Font::render_mode_t mode_)
 	{
 		//logi() << "DEBUG: rendering text: " << utf8_;
 
@@ -142,17 +406,36 @@ namespace sally {
 			surf = TTF_RenderText_Solid(font_->sdl_font(), utf8_.c_str(), color_.sdl_color());
 			if (!surf)
 				throw ttf_exception("TTF_RenderText_Solid failed", utf8_.c_str());
+			{
+				// palettized with a color key, becomes transparent ARGB
+				SDL_Surface* argb = SDL_ConvertSurfaceFormat(surf, SDL_PIXELFORMAT_ARGB8888, 0);
+				SDL_FreeSurface(surf);
+				if (!argb)
+					throw sdl_exception("SDL_ConvertSurfaceFormat failed (rendering text)");
+				surf = argb;
+			}
 			break;
 		case Font::RENDER_BLENDED:
-			surf = TTF_RenderText_Blended(font_->sdl_font(), utf8_.c_str(), color_.sdl_color());
-			if (!surf)
-				throw ttf_exception("TTF_RenderText_Blended failed", utf8_.c_str());
+			surf = render_blended_text(font_, color_, utf8_);
 			break;
 		}
 		if (!surf)
 			throw general_exception("invalid text render mode?!");
+		return surf;
+	}
 
-		SDL_Texture *texture = SDL_CreateTextureFromSurface(_renderer, surf);
+	SDL_Texture* Renderer::render_sdl_text(Font* font_, const Color& color_, const std::string& utf8_, Font::render_mode_t mode_)
+	{
+		SDL_Surface* surf = render_text_surface(font_, color_, utf8_, mode_);
+
+		SDL_Texture* texture = nullptr;
+		try {
+			texture = texture_from_surface(surf);
+		}
+		catch (...) {
+			SDL_FreeSurface(surf);
+			throw;
+		}
 		SDL_FreeSurface(surf);
 		if (!texture)
 			throw sdl_exception("SDL_CreateTextureFromSurface failed (rendering text)");
@@ -160,6 +443,60 @@ namespace sally {
 		return texture;
 	}
 
+	bool Renderer::supports_render_targets() const
+	{
+		return !_soft && SDL_RenderTargetSupported(_renderer) == SDL_TRUE;
+	}
+
+	SDL_Texture* Renderer::create_target_texture(int width_, int height_)
+	{
+		if (!supports_render_targets())
+			throw general_exception("render targets are not supported by this renderer");
+		SDL_Texture* texture = SDL_CreateTexture(_renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, width_, height_);
+		if (!texture)
+			throw sdl_exception("SDL_CreateTexture failed (render target)");
+		SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+		return texture;
+	}
+
+	SDL_Texture* Renderer::render_target() const
+	{
+		SDL_Texture* target = SDL_GetRenderTarget(_renderer);
+		return target != _scaled_target ? target : nullptr;
+	}
+
+	void Renderer::set_render_target(SDL_Texture* target_)
+	{
+		if (!target_ && _frame_scale < 1) // the window is the internal target during scaled frames
+			set_scaled_target();
+		else if (SDL_SetRenderTarget(_renderer, target_) != 0)
+			throw sdl_exception("SDL_SetRenderTarget failed");
+
+		// textures are drawn in their own pixels: the window's camera, transforms and clips are
+		// put aside while drawing to a target and come back with the window
+		if (target_ && !_window_view_saved) {
+			_window_transforms.swap(_transforms);
+			_window_clips.swap(_clips);
+			_window_view_saved = true;
+		}
+		else if (!target_ && _window_view_saved) {
+			_transforms.swap(_window_transforms);
+			_clips.swap(_window_clips);
+			_window_view_saved = false;
+		}
+		if (target_) {
+			_transforms.assign(1, Transform());
+			_clips.clear();
+		}
+		_transformed = !transform().identity();
+
+		// culling follows the target, SDL resets the clip rect when switching
+		_target_bounds = output_rect();
+		if (target_)
+			SDL_QueryTexture(target_, nullptr, nullptr, &_target_bounds._width, &_target_bounds._height);
+		apply_clip();
+	}
+
 	Renderable* Renderer::render_lookup(const std::string& name_)
 	{
 		if (Renderable* res = lookup(name_))
@@ -171,7 +508,13 @@ namespace sally {
 		}
 	}
 
-	void Renderer::render_impl(Renderable* renderable_, const Rect& dst_, Rect* clip_, bool override_dst_wh_)
+	Renderable* Renderer::render_lookup(const char* name_)
+	{
+		_lookup_key = name_;
+		return render_lookup(_lookup_key);
+	}
+
+	SDL_Texture* Renderer::texture_for_render(Renderable* renderable_)
 	{
 		SDL_Texture* texture = renderable_ ? renderable_->texture_for_render(*this) : nullptr;
 		if (!texture) {
@@ -180,24 +523,158 @@ namespace sally {
 			throw general_exception(err.str().c_str());
 		}
 
-		const SDL_Rect* dst_rect = 0;
-		Rect odst;
+		renderable_->_last_used_frame = _frame;
+		if (renderable_->_evicted) {
+			renderable_->_evicted = false;
+			++_stats.reuploads;
+		}
+		else
+			++_stats.hits;
+		return texture;
+	}
+
+	bool Renderer::preload(const std::string& name_)
+	{
+		Renderable* renderable = lookup(name_);
+		if (!renderable)
+			return false;
+		texture_for_render(renderable);
+		return true;
+	}
+
+	void Renderer::render_impl(Renderable* renderable_, const Rect& dst_, Rect* clip_, bool override_dst_wh_)
+	{
+		// when the size is known up front, culled draws do not even create the texture
+		SDL_Texture* texture = nullptr;
+		if (!renderable_ || (override_dst_wh_ && !clip_))
+			texture = texture_for_render(renderable_);
+
+		Rect dst = dst_;
 		if (override_dst_wh_)
 		{
 			if (clip_) {
-				odst._width = clip_->_width;
-				odst._height = clip_->_height;
+				dst._width = clip_->_width;
+				dst._height = clip_->_height;
+			}
+			else {
+				renderable_->fill_bounding_rect(*this, dst);
+				dst._x = dst_._x;
+				dst._y = dst_._y;
 			}
-			else
-				renderable_->fill_bounding_rect(*this, odst);
-			odst._x = dst_._x;
-			odst._y = dst_._y;
-			dst_rect = &odst.sdl_rect();
+		}
+		if (!accept(dst))
+			return;
+		if (!texture)
+			texture = texture_for_render(renderable_);
+		const Rect* src = clip_ ? clip_ : renderable_->content_rect();
+		const Rect* dst_rect = &dst;
+
+		if (_soft) {
+			SDL_Surface* pixels = static_cast<SDL_Surface*>(SDL_GetTextureUserData(texture));
+			if (!pixels)
+				throw general_exception("texture has no pixels for the software rasterizer (textures must be created by the Renderer)");
+			SDL_BlendMode mode = SDL_BLENDMODE_NONE;
+			SDL_GetTextureBlendMode(texture, &mode);
+			_soft->blit(pixels, src ? *src : Rect(0, 0, pixels->w, pixels->h), scaled(*dst_rect), mode == SDL_BLENDMODE_BLEND);
 		}
 		else
-			dst_rect = &dst_.sdl_rect();
+			SDL_RenderCopy(_renderer, texture, src ? &src->sdl_rect() : nullptr, &dst_rect->sdl_rect());
+	}
+
+	// vertex and index storage reused between batches
+	struct Renderer::BatchBuffers {
+		std::vector<SDL_Vertex> _vertices;
+		std::vector<int> _indices; // fixed two triangles per quad pattern, only ever grown
+		std::vector<Rect> _src, _dst; // visible quads in window coordinates
+		std::vector<Color> _tints;
+	};
+
+	void Renderer::render_batch(Renderable* renderable_, const Rect* src_, const Rect* dst_, const Color* tints_, size_t count_)
+	{
+		if (count_ == 0)
+			return;
+		if (!_batch)
+			_batch.reset(new BatchBuffers());
+
+		// transform and cull the whole batch in one pass, only the visible quads are kept
+		std::vector<Rect>& vis_src = _batch->_src;
+		std::vector<Rect>& vis_dst = _batch->_dst;
+		vis_src.clear();
+		vis_dst.clear();
+		_batch->_tints.clear();
+		_draws.draws += count_;
+		const Transform& tr = transform();
+		for (size_t ii = 0; ii < count_; ++ii) {
+			const Rect dst = _transformed ? tr.apply(dst_[ii]) : dst_[ii];
+			if (!overlaps(dst, _cull))
+				continue;
+			vis_src.push_back(src_[ii]);
+			vis_dst.push_back(dst);
+			if (tints_)
+				_batch->_tints.push_back(tints_[ii]);
+		}
+		_draws.culled += count_ - vis_dst.size();
+		submit_batch(renderable_, vis_src.data(), vis_dst.data(), tints_ ? _batch->_tints.data() : nullptr, vis_dst.size());
+	}
+
+	void Renderer::render_batch_placed(Renderable* renderable_, const Rect* src_, const Rect* dst_, const Color* tints_, size_t count_, size_t culled_)
+	{
+		_draws.draws += count_ + culled_;
+		_draws.culled += culled_;
+		if (!count_)
+			return;
+		if (!_batch)
+			_batch.reset(new BatchBuffers());
+		submit_batch(renderable_, src_, dst_, tints_, count_);
+	}
+
+	void Renderer::submit_batch(Renderable* renderable_, const Rect* src_, const Rect* dst_, const Color* tints_, size_t count_)
+	{
+		if (!count_)
+			return;
+		SDL_Texture* texture = texture_for_render(renderable_);
+
+		if (_soft) {
+			SDL_Surface* pixels = static_cast<SDL_Surface*>(SDL_GetTextureUserData(texture));
+			if (!pixels)
+				throw general_exception("texture has no pixels for the software rasterizer (textures must be created by the Renderer)");
+			SDL_BlendMode mode = SDL_BLENDMODE_NONE;
+			SDL_GetTextureBlendMode(texture, &mode);
+			for (size_t ii = 0; ii < count_; ++ii)
+				_soft->blit(pixels, src_[ii], scaled(dst_[ii]), mode == SDL_BLENDMODE_BLEND, tints_ ? SoftRaster::argb(tints_[ii]) : 0xffffffff);
+			return;
+		}
+
+		int tex_w = 0, tex_h = 0;
+		if (SDL_QueryTexture(texture, nullptr, nullptr, &tex_w, &tex_h) != 0 || tex_w <= 0 || tex_h <= 0)
+			throw sdl_exception("SDL_QueryTexture failed");
+		const float inv_w = 1.0f / tex_w, inv_h = 1.0f / tex_h;
+
+		std::vector<SDL_Vertex>& verts = _batch->_vertices;
+		std::vector<int>& indices = _batch->_indices;
+		verts.resize(count_ * 4);
+		for (size_t quad = indices.size() / 6; quad < count_; ++quad) {
+			const int v = static_cast<int>(quad * 4);
+			const int tris[6] = { v, v + 1, v + 2, v + 2, v + 1, v + 3 };
+			indices.insert(indices.end(), tris, tris + 6);
+		}
+
+		const SDL_Color white = { 255, 255, 255, 255 };
+		SDL_Vertex* vx = verts.data();
+		for (size_t ii = 0; ii < count_; ++ii, vx += 4) {
+			const Rect& s = src_[ii];
+			const Rect& d = dst_[ii];
+			const SDL_Color col = tints_ ? tints_[ii].sdl_color() : white;
+			const float x0 = float(d._x), y0 = float(d._y), x1 = float(d._x + d._width), y1 = float(d._y + d._height);
+			const float u0 = s._x * inv_w, v0 = s._y * inv_h, u1 = (s._x + s._width) * inv_w, v1 = (s._y + s._height) * inv_h;
+			vx[0] = { { x0, y0 }, col, { u0, v0 } };
+			vx[1] = { { x1, y0 }, col, { u1, v0 } };
+			vx[2] = { { x0, y1 }, col, { u0, v1 } };
+			vx[3] = { { x1, y1 }, col, { u1, v1 } };
+		}
 
-		SDL_RenderCopy(_renderer, texture, clip_ ? &clip_->sdl_rect() : nullptr, dst_rect);
+		if (SDL_RenderGeometry(_renderer, texture, verts.data(), static_cast<int>(count_ * 4), indices.data(), static_cast<int>(count_ * 6)) != 0)
+			throw sdl_exception("SDL_RenderGeometry failed");
 	}
 
 	Color Renderer::draw_color()
@@ -214,22 +691,316 @@ namespace sally {
 
 	void Renderer::fill_rect(const Rect& rect_)
 	{
-		SDL_RenderFillRect(_renderer, &rect_.sdl_rect());
+		Rect rect = rect_;
+		if (!accept(rect))
+			return;
+		if (_soft)
+			_soft->fill_rect(scaled(rect), SoftRaster::argb(draw_color()), soft_draw_blend());
+		else
+			SDL_RenderFillRect(_renderer, &rect.sdl_rect());
 	}
 
 	void Renderer::draw_line(int x1_, int y1_, int x2_, int y2_)
 	{
-		SDL_RenderDrawLine(_renderer, x1_, y1_, x2_, y2_);
+		if (_transformed) {
+			const Transform& tr = transform();
+			x1_ = tr.apply_x(x1_);
+			y1_ = tr.apply_y(y1_);
+			x2_ = tr.apply_x(x2_);
+			y2_ = tr.apply_y(y2_);
+		}
+		++_draws.draws;
+		const Rect bounds(std::min(x1_, x2_), std::min(y1_, y2_), std::abs(x2_ - x1_) + 1, std::abs(y2_ - y1_) + 1);
+		if (!overlaps(bounds, _cull)) {
+			++_draws.culled;
+			return;
+		}
+		if (_soft && _frame_scale < 1) {
+			const Rect line = scaled(Rect(x1_, y1_, x2_ - x1_, y2_ - y1_));
+			_soft->draw_line(line._x, line._y, line._x + line._width, line._y + line._height, SoftRaster::argb(draw_color()), soft_draw_blend());
+		}
+		else if (_soft)
+			_soft->draw_line(x1_, y1_, x2_, y2_, SoftRaster::argb(draw_color()), soft_draw_blend());
+		else
+			SDL_RenderDrawLine(_renderer, x1_, y1_, x2_, y2_);
 	}
 
 	void Renderer::clear()
 	{
-		SDL_RenderClear(_renderer);
+		if (_soft)
+			_soft->clear(SoftRaster::argb(draw_color()));
+		else
+			SDL_RenderClear(_renderer);
+	}
+
+	bool Renderer::soft_draw_blend()
+	{
+		SDL_BlendMode mode = SDL_BLENDMODE_NONE;
+		SDL_GetRenderDrawBlendMode(_renderer, &mode);
+		return mode == SDL_BLENDMODE_BLEND;
+	}
+
+	Rect Renderer::scaled(const Rect& rect_) const
+	{
+		if (_frame_scale >= 1)
+			return rect_;
+		// edges are rounded so adjacent rects stay adjacent
+		const int x0 = static_cast<int>(std::floor(rect_._x * _frame_scale + 0.5f));
+		const int y0 = static_cast<int>(std::floor(rect_._y * _frame_scale + 0.5f));
+		const int x1 = static_cast<int>(std::floor((rect_._x + rect_._width) * _frame_scale + 0.5f));
+		const int y1 = static_cast<int>(std::floor((rect_._y + rect_._height) * _frame_scale + 0.5f));
+		return Rect(x0, y0, x1 - x0, y1 - y0);
+	}
+
+	bool Renderer::accept(Rect& rect_)
+	{
+		++_draws.draws;
+		if (_transformed)
+			rect_ = transform().apply(rect_);
+		if (overlaps(rect_, _cull))
+			return true;
+		++_draws.culled;
+		return false;
+	}
+
+	void Renderer::set_camera(float x_, float y_, float zoom_)
+	{
+		_camera = Transform(-x_ * zoom_, -y_ * zoom_, zoom_);
+		if (_window_view_saved) {
+			_window_transforms.front() = _camera;
+			return;
+		}
+		_transforms.front() = _camera;
+		if (_transforms.size() == 1)
+			_transformed = !_camera.identity();
+	}
+
+	void Renderer::set_transform(const Transform& transform_)
+	{
+		_transforms.push_back(transform_);
+		_transformed = !transform_.identity();
+	}
+
+	void Renderer::pop_transform()
+	{
+		if (_transforms.size() <= 1)
+			throw general_exception("Renderer::pop_transform without push_transform");
+		_transforms.pop_back();
+		_transformed = !transform().identity();
+	}
+
+	void Renderer::push_clip(const Rect& clip_)
+	{
+		Rect clip = _transformed ? transform().apply(clip_) : clip_;
+		if (!_clips.empty()) {
+			const Rect& outer = _clips.back();
+			const int x0 = std::max(clip._x, outer._x), y0 = std::max(clip._y, outer._y);
+			const int x1 = std::min(clip._x + clip._width, outer._x + outer._width);
+			const int y1 = std::min(clip._y + clip._height, outer._y + outer._height);
+			clip = Rect(x0, y0, std::max(x1 - x0, 0), std::max(y1 - y0, 0));
+		}
+		_clips.push_back(clip);
+		apply_clip();
+	}
+
+	void Renderer::pop_clip()
+	{
+		if (_clips.empty())
+			throw general_exception("Renderer::pop_clip without push_clip");
+		_clips.pop_back();
+		apply_clip();
+	}
+
+	void Renderer::apply_clip()
+	{
+		_cull = _target_bounds;
+		if (_clips.empty()) {
+			if (_soft)
+				_soft->set_clip(nullptr);
+			else
+				SDL_RenderSetClipRect(_renderer, nullptr);
+			return;
+		}
+		const Rect& clip = _clips.back();
+		const int x0 = std::max(clip._x, _cull._x), y0 = std::max(clip._y, _cull._y);
+		const int x1 = std::min(clip._x + clip._width, _cull._x + _cull._width);
+		const int y1 = std::min(clip._y + clip._height, _cull._y + _cull._height);
+		_cull = Rect(x0, y0, std::max(x1 - x0, 0), std::max(y1 - y0, 0));
+		if (_soft) {
+			const Rect soft_clip = scaled(_cull);
+			_soft->set_clip(&soft_clip);
+		}
+		else
+			SDL_RenderSetClipRect(_renderer, &_cull.sdl_rect());
+	}
+
+	void Renderer::reset_view()
+	{
+		_transforms.resize(1);
+		_transforms.front() = _camera;
+		_transformed = !_camera.identity();
+		_clips.clear();
+		_window_view_saved = false;
+		_target_bounds = _soft ? Rect(0, 0, _soft->width(), _soft->height()) : output_rect();
+		apply_clip();
+	}
+
+	void Renderer::set_dynamic_resolution(const DynamicResolution& config_)
+	{
+		_dynres = config_;
+		_dynres.max_scale = std::max(0.1f, std::min(_dynres.max_scale, 1.0f));
+		_dynres.min_scale = std::max(0.1f, std::min(_dynres.min_scale, _dynres.max_scale));
+		_dynres.hysteresis = std::max(_dynres.hysteresis, 1);
+		_scale = _dynres.target_ms > 0 ? std::max(_dynres.min_scale, std::min(_scale, _dynres.max_scale)) : 1.0f;
+		_over = _under = 0;
+	}
+
+	void Renderer::adapt_resolution(double frame_ms_)
+	{
+		if (_dynres.target_ms <= 0)
+			return;
+		if (frame_ms_ > _dynres.target_ms) {
+			_under = 0;
+			if (++_over >= _dynres.hysteresis) {
+				_over = 0;
+				_scale = std::max(_dynres.min_scale, _frame_scale - _dynres.step);
+			}
+			return;
+		}
+		_over = 0;
+		// drawing cost grows with the pixel count, scale up only if the larger frame would still fit
+		const float up = std::min(_dynres.max_scale, _frame_scale + _dynres.step);
+		const double area = double(up) * up / (double(_frame_scale) * _frame_scale);
+		if (up > _frame_scale && frame_ms_ * area <= _dynres.target_ms) {
+			if (++_under >= _dynres.hysteresis) {
+				_under = 0;
+				_scale = up;
+			}
+		}
+		else
+			_under = 0;
+	}
+
+	bool Renderer::ensure_scaled_target(const Rect& output_)
+	{
+		if (_scaled_target) {
+			int tex_w = 0, tex_h = 0;
+			SDL_QueryTexture(_scaled_target, nullptr, nullptr, &tex_w, &tex_h);
+			if (tex_w == output_._width && tex_h == output_._height)
+				return true;
+			SDL_DestroyTexture(_scaled_target);
+			_scaled_target = nullptr;
+		}
+		if (SDL_RenderTargetSupported(_renderer) == SDL_TRUE)
+			_scaled_target = SDL_CreateTexture(_renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, output_._width, output_._height);
+		if (!_scaled_target) {
+			logw() << "dynamic resolution disabled, the renderer has no render targets";
+			_dynres.target_ms = 0;
+			return false;
+		}
+		SDL_SetTextureScaleMode(_scaled_target, SDL_ScaleModeLinear);
+		return true;
+	}
+
+	void Renderer::set_scaled_target()
+	{
+		if (SDL_SetRenderTarget(_renderer, _scaled_target) != 0)
+			throw sdl_exception("SDL_SetRenderTarget failed");
+		SDL_RenderSetScale(_renderer, _frame_scale, _frame_scale);
+	}
+
+	void Renderer::begin_render()
+	{
+		++_frame;
+		_frame_scale = _scale;
+		if (_soft) {
+			_scaled_rect = scaled(Rect(0, 0, _soft->width(), _soft->height()));
+			_soft->set_active_size(_scaled_rect._width, _scaled_rect._height);
+		}
+		else if (_frame_scale < 1) {
+			const Rect osz = output_rect();
+			if (ensure_scaled_target(osz)) {
+				_scaled_rect = scaled(osz);
+				set_scaled_target();
+			}
+			else
+				_frame_scale = _scale = 1;
+		}
+		reset_view();
 	}
 
 	void Renderer::end_render()
 	{
+		if (_soft) {
+			_soft->flush(worker_pool::shared());
+			// offscreen frames at full resolution are read straight from the rasterizer
+			if (!_offscreen || _frame_scale < 1) {
+				const SDL_Rect* src = _frame_scale < 1 ? &_scaled_rect.sdl_rect() : nullptr;
+				SDL_UpdateTexture(_soft_target, src, _soft->pixels(), _soft->pitch());
+				SDL_RenderCopy(_renderer, _soft_target, src, nullptr);
+			}
+		}
+		else if (_frame_scale < 1) {
+			SDL_SetRenderTarget(_renderer, nullptr);
+			SDL_RenderSetClipRect(_renderer, nullptr); // the window's clip may be left over from earlier frames
+			SDL_RenderCopy(_renderer, _scaled_target, &_scaled_rect.sdl_rect(), nullptr);
+		}
+		_last_draws = _draws;
+		_draws = DrawStats();
+		if (_capture) // before presenting, the back buffer content is undefined afterwards
+			_capture->capture(*this);
+		const Uint64 present_start = SDL_GetPerformanceCounter();
 		SDL_RenderPresent(_renderer);
+		_present_ticks = SDL_GetPerformanceCounter() - present_start;
+		enforce_texture_budget();
+	}
+
+	void Renderer::enforce_texture_budget()
+	{
+		shared_mutex::Guard lg(_lock);
+
+		size_t total = 0;
+		_evict_candidates.clear();
+		for (auto it = _map.begin(); it != _map.end(); ++it) {
+			Renderable* r = it->second.get();
+			size_t bytes = r->texture_bytes();
+			total += bytes;
+			if (bytes && r->_last_used_frame < _frame)
+				_evict_candidates.push_back(r);
+		}
+
+		if (_stats.budget && total > _stats.budget) {
+			std::sort(_evict_candidates.begin(), _evict_candidates.end(),
+				[](const Renderable* a_, const Renderable* b_) { return a_->_last_used_frame < b_->_last_used_frame; });
+			for (auto it = _evict_candidates.begin(); it != _evict_candidates.end() && total > _stats.budget; ++it) {
+				size_t bytes = (*it)->texture_bytes();
+				if ((*it)->evict_texture()) {
+					(*it)->_evicted = true;
+					total -= bytes;
+					++_stats.evictions;
+				}
+			}
+		}
+		_stats.bytes = total;
+	}
+
+	bool Renderer::read_pixels(void* dst_, int pitch_)
+	{
+		if (_soft && _frame_scale >= 1) {
+			if (SDL_PIXELFORMAT_RGBA32 != SDL_PIXELFORMAT_ABGR8888) // big endian
+				return SDL_ConvertPixels(_soft->width(), _soft->height(), SDL_PIXELFORMAT_ARGB8888, _soft->pixels(), _soft->pitch(),
+					SDL_PIXELFORMAT_RGBA32, dst_, pitch_) == 0;
+			for (int yy = 0; yy < _soft->height(); ++yy)
+				pixel_kernels::swap_rb(_soft->pixels() + size_t(yy) * _soft->width(),
+					reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(dst_) + size_t(yy) * pitch_), _soft->width());
+			return true;
+		}
+		if (_offscreen) {
+			return SDL_RenderFlush(_renderer) == 0 &&
+				SDL_ConvertPixels(_offscreen->w, _offscreen->h, _offscreen->format->format, _offscreen->pixels, _offscreen->pitch,
+					SDL_PIXELFORMAT_RGBA32, dst_, pitch_) == 0;
+		}
+		return SDL_RenderReadPixels(_renderer, nullptr, SDL_PIXELFORMAT_RGBA32, dst_, pitch_) == 0;
 	}
 
 	Rect Renderer::output_rect() const
@@ -252,16 +1023,32 @@ namespace sally {
 		return res;
 	}
 
+	// offscreen windows get ids from a range SDL never hands out to real windows
+	static SDL_atomic_t offscreen_window_count = { 0 };
+	static const Window::id_t FIRST_OFFSCREEN_WINDOW_ID = 0x80000000u;
+
 	Window::Window(const char* title_, int width_, int height_, flags_t flags_, RenderProvider* rprovider_)
-		: _width(width_), _height(height_), _id(0), _window(nullptr), _rprovider(rprovider_), _render_pending({ 1 })
+		: _width(width_), _height(height_), _id(0), _window(nullptr), _rprovider(rprovider_), _render_pending({ 1 }), _render_time(nullptr), _texture_bytes(nullptr), _render_scale(nullptr), _draws(nullptr), _culled_draws(nullptr)
 	{
+		const bool software_raster = (flags_ & FLG_SOFTWARE_RASTER) != 0;
+		if (flags_ & FLG_OFFSCREEN) {
+			if (width_ <= 0 || height_ <= 0)
+				throw general_exception("offscreen windows require explicit width and height");
+			_renderer.initialize_offscreen(width_, height_, software_raster);
+			_id = FIRST_OFFSCREEN_WINDOW_ID + static_cast<id_t>(SDL_AtomicAdd(&offscreen_window_count, 1));
+			if (_rprovider)
+				_rprovider->initialize(*this);
+			System::window_manger().register_win(this);
+			return;
+		}
+
 		_window = SDL_CreateWindow(title_, SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, width_, height_, sdl_flags(flags_));
 		if (!_window)
 			throw sdl_exception("SDL_CreateWindow failed");
 
 		try {
 			_id = SDL_GetWindowID(_window);
-			_renderer.initialize(_window);
+			_renderer.initialize(_window, software_raster);
 
 			const Rect& osz = _renderer.output_rect();
 			_width = osz._width;
@@ -279,8 +1066,10 @@ namespace sally {
 
 	void Window::invalidate()
 	{
-		SDL_AtomicSet(&_render_pending, 1);
-		System::request_render();
+		if (SDL_AtomicSet(&_render_pending, 1) == 0) // one wakeup per frame is enough
+			System::request_render();
+		if (System::is_main_thread())
+			System::input_latency().invalidated(_id);
 	}
 
 	void Window::validate()
@@ -297,14 +1086,43 @@ namespace sally {
 	{
 		// logi() << "rending window " << _id << "...";
 
+		if (!_render_time) {
+			const std::string labels = "window=\"" + std::to_string(_id) + "\"";
+			_render_time = &System::metrics().add_histogram("sally_window_render_time_us", "time to draw and present a window", labels);
+			_texture_bytes = &System::metrics().add_gauge("sally_texture_bytes", "texture memory held by a window's named renderables", labels);
+			_render_scale = &System::metrics().add_gauge("sally_render_scale_percent", "dynamic resolution scale of a window", labels);
+			_draws = &System::metrics().add_counter("sally_draws_total", "draw calls submitted to a window's renderer", labels);
+			_culled_draws = &System::metrics().add_counter("sally_draws_culled_total", "draw calls rejected since they were outside the clip", labels);
+		}
+		const Uint64 start = SDL_GetPerformanceCounter();
+
 		_renderer.begin_render();
+		// validate before drawing: an invalidate arriving while the provider renders (i.e. a lock
+		// free SnapshotRenderProvider::publish) must leave the window pending for the next frame
+		validate();
 		if (_rprovider) {
 			RenderProvider::Guard rg(*_rprovider);
 			_rprovider->render(*this);
-			validate(); // while holding provider lock!
 		}
-		else validate();
 		_renderer.end_render();
+		System::input_latency().presented(_id, start, _renderer.last_present_ticks());
+
+		const Uint64 elapsed = SDL_GetPerformanceCounter() - start;
+		_render_time->record(elapsed * 1000000 / SDL_GetPerformanceFrequency());
+		_texture_bytes->set(static_cast<int64_t>(_renderer.texture_stats().bytes));
+		// waiting for vsync is not drawing cost, a lower resolution would not shorten it
+		const Uint64 draw = elapsed - std::min<Uint64>(elapsed, _renderer.last_present_ticks());
+		_renderer.adapt_resolution(draw * 1000.0 / SDL_GetPerformanceFrequency());
+		_render_scale->set(static_cast<int64_t>(_renderer.render_scale() * 100 + 0.5f));
+		_draws->add(_renderer.draw_stats().draws);
+		_culled_draws->add(_renderer.draw_stats().culled);
+	}
+
+	HitIndex& Window::enable_hit_index(int cell_size_)
+	{
+		if (!_hit_index)
+			_hit_index.reset(new HitIndex(cell_size_));
+		return *_hit_index;
 	}
 
 	Window::~Window()
@@ -335,6 +1153,14 @@ namespace sally {
 				it->second->render();
 	}
 
+	bool WindowManager::render_pending() const
+	{
+		for (auto it = _windows.begin(); it != _windows.end(); ++it)
+			if (it->second->render_pending())
+				return true;
+		return false;
+	}
+
 	void WindowManager::invalidate_all()
 	{
 		for (auto it = _windows.begin(); it != _windows.end(); ++it)
@@ -0,0 +1,229 @@
+#include <sally/gfx/frame_capture.hpp>
+#include <sally/gfx.hpp>
+#include <sally/util/logger.hpp>
+#include <SDL.h>
+#include <SDL_image.h>
+#include <algorithm>
+
+namespace sally {
+
+	namespace {
+
+		inline uint8_t clamp_u8(int v_) { return static_cast<uint8_t>(v_ < 0 ? 0 : (v_ > 255 ? 255 : v_)); }
+
+		// RGBA -> planar YUV 4:2:0 (full range BT.601, chroma averaged over 2x2 blocks)
+		void rgba_to_i420(const uint8_t* rgba_, int width_, int height_, uint8_t* out_)
+		{
+			const int cw = (width_ + 1) / 2, ch = (height_ + 1) / 2;
+			uint8_t* y_plane = out_;
+			uint8_t* u_plane = out_ + size_t(width_) * height_;
+			uint8_t* v_plane = u_plane + size_t(cw) * ch;
+			const size_t pitch = size_t(width_) * 4;
+
+			for (int y = 0; y < height_; ++y) {
+				const uint8_t* p = rgba_ + y * pitch;
+				uint8_t* dst = y_plane + size_t(y) * width_;
+				for (int x = 0; x < width_; ++x, p += 4)
+					dst[x] = static_cast<uint8_t>((77 * p[0] + 150 * p[1] + 29 * p[2] + 128) >> 8);
+			}
+
+			for (int cy = 0; cy < ch; ++cy) {
+				const uint8_t* r0 = rgba_ + size_t(2 * cy) * pitch;
+				const uint8_t* r1 = 2 * cy + 1 < height_ ? r0 + pitch : r0;
+				for (int cx = 0; cx < cw; ++cx) {
+					int x0 = 8 * cx, x1 = 2 * cx + 1 < width_ ? x0 + 4 : x0;
+					int r = r0[x0] + r0[x1] + r1[x0] + r1[x1];
+					int g = r0[x0 + 1] + r0[x1 + 1] + r1[x0 + 1] + r1[x1 + 1];
+					int b = r0[x0 + 2] + r0[x1 + 2] + r1[x0 + 2] + r1[x1 + 2];
+					// sums are 4x the average, fold the division into the shift:
+					u_plane[size_t(cy) * cw + cx] = clamp_u8(((-43 * r - 85 * g + 128 * b + 512) >> 10) + 128);
+					v_plane[size_t(cy) * cw + cx] = clamp_u8(((128 * r - 107 * g - 21 * b + 512) >> 10) + 128);
+				}
+			}
+		}
+
+		double elapsed_ms(Uint64 start_) {
+			return (SDL_GetPerformanceCounter() - start_) * 1000.0 / SDL_GetPerformanceFrequency();
+		}
+
+	}
+
+	FrameCapture::FrameCapture(const std::string& path_, format_t format_, int fps_, int buffers_, bool drop_when_busy_)
+		: _path(path_), _format(format_), _fps(fps_ > 0 ? fps_ : 60), _drop_when_busy(drop_when_busy_),
+		  _stream(nullptr), _header_written(false), _mutex(nullptr), _frame_ready(nullptr), _frame_free(nullptr),
+		  _quit(false), _next_index(0)
+	{
+		if (_format != FORMAT_PNG) {
+			_stream = std::fopen(_path.c_str(), "wb");
+			if (!_stream)
+				throw general_exception(("FrameCapture failed opening " + _path).c_str());
+		}
+
+		_mutex = SDL_CreateMutex();
+		_frame_ready = SDL_CreateCond();
+		_frame_free = SDL_CreateCond();
+		if (!_mutex || !_frame_ready || !_frame_free) {
+			shutdown();
+			throw sdl_exception("FrameCapture synchronization objects creation failed");
+		}
+
+		// png encoding is the bottleneck and frames are independent files, so it gets several writers.
+		// streams must be written in order and are cheap to encode, so they get a single writer.
+		int writers = _format == FORMAT_PNG ? std::max(1, SDL_GetCPUCount() / 2) : 1;
+		int buffers = std::max(std::max(buffers_, 2), writers + 1);
+		for (int ii = 0; ii < buffers; ++ii) {
+			_frames.emplace_back(new Frame());
+			_free.push_back(_frames.back().get());
+		}
+
+		for (int ii = 0; ii < writers; ++ii)
+			if (SDL_Thread* thread = SDL_CreateThread(&FrameCapture::writer_main, "sally_capture", this))
+				_writers.push_back(thread);
+		if (_writers.empty()) {
+			shutdown();
+			throw sdl_exception("FrameCapture SDL_CreateThread failed");
+		}
+	}
+
+	FrameCapture::~FrameCapture()
+	{
+		shutdown();
+	}
+
+	void FrameCapture::shutdown()
+	{
+		if (_mutex) {
+			SDL_LockMutex(_mutex);
+			_quit = true;
+			SDL_CondBroadcast(_frame_ready);
+			SDL_UnlockMutex(_mutex);
+		}
+		for (auto it = _writers.begin(); it != _writers.end(); ++it)
+			SDL_WaitThread(*it, nullptr); // writers drain the queue before quitting
+		_writers.clear();
+
+		SDL_DestroyCond(_frame_free);
+		SDL_DestroyCond(_frame_ready);
+		SDL_DestroyMutex(_mutex);
+		_frame_free = _frame_ready = nullptr;
+		_mutex = nullptr;
+
+		if (_stream) {
+			std::fclose(_stream);
+			_stream = nullptr;
+		}
+	}
+
+	auto FrameCapture::stats() const -> Stats
+	{
+		SDL_LockMutex(_mutex);
+		Stats res = _stats;
+		SDL_UnlockMutex(_mutex);
+		return res;
+	}
+
+	void FrameCapture::capture(Renderer& renderer_)
+	{
+		Uint64 start = SDL_GetPerformanceCounter();
+
+		SDL_LockMutex(_mutex);
+		if (_free.empty() && _drop_when_busy) {
+			++_stats._dropped;
+			SDL_UnlockMutex(_mutex);
+			return;
+		}
+		while (_free.empty())
+			SDL_CondWait(_frame_free, _mutex);
+		Frame* frame = _free.back();
+		_free.pop_back();
+		SDL_UnlockMutex(_mutex);
+
+		const Rect& osz = renderer_.output_rect();
+		frame->_width = osz._width;
+		frame->_height = osz._height;
+		frame->_rgba.resize(size_t(osz._width) * osz._height * 4); // no reallocation unless the size changed
+		bool ok = renderer_.read_pixels(frame->_rgba.data(), osz._width * 4);
+
+		SDL_LockMutex(_mutex);
+		if (ok) {
+			frame->_index = _next_index++;
+			_ready.push_back(frame);
+			++_stats._captured;
+			SDL_CondSignal(_frame_ready);
+		}
+		else
+			_free.push_back(frame);
+		_stats._readback_ms += elapsed_ms(start);
+		SDL_UnlockMutex(_mutex);
+
+		if (!ok)
+			logw() << "FrameCapture: reading back frame failed: " << SDL_GetError();
+	}
+
+	//static
+	int FrameCapture::writer_main(void* self_)
+	{
+		static_cast<FrameCapture*>(self_)->writer_loop();
+		return 0;
+	}
+
+	void FrameCapture::writer_loop()
+	{
+		std::vector<uint8_t> scratch; // per writer conversion buffer
+		SDL_LockMutex(_mutex);
+		for (;;) {
+			while (_ready.empty() && !_quit)
+				SDL_CondWait(_frame_ready, _mutex);
+			if (_ready.empty())
+				break; // quitting and nothing left to write
+			Frame* frame = _ready.front();
+			_ready.pop_front();
+			SDL_UnlockMutex(_mutex);
+
+			Uint64 start = SDL_GetPerformanceCounter();
+			write_frame(*frame, scratch);
+			double ms = elapsed_ms(start);
+
+			SDL_LockMutex(_mutex);
+			_free.push_back(frame);
+			++_stats._written;
+			_stats._write_ms += ms;
+			SDL_CondSignal(_frame_free);
+		}
+		SDL_UnlockMutex(_mutex);
+	}
+
+	void FrameCapture::write_frame(Frame& frame_, std::vector<uint8_t>& scratch_)
+	{
+		switch (_format) {
+		case FORMAT_RGBA:
+			std::fwrite(frame_._rgba.data(), 1, frame_._rgba.size(), _stream);
+			break;
+
+		case FORMAT_Y4M: {
+			if (!_header_written) { // single writer, no need to lock
+				std::fprintf(_stream, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", frame_._width, frame_._height, _fps);
+				_header_written = true;
+			}
+			size_t chroma = size_t((frame_._width + 1) / 2) * ((frame_._height + 1) / 2);
+			scratch_.resize(size_t(frame_._width) * frame_._height + 2 * chroma);
+			rgba_to_i420(frame_._rgba.data(), frame_._width, frame_._height, scratch_.data());
+			std::fputs("FRAME\n", _stream);
+			std::fwrite(scratch_.data(), 1, scratch_.size(), _stream);
+			break;
+		}
+
+		case FORMAT_PNG: {
+			char filename[1024];
+			SALLY_SNFORMAT(filename, sizeof(filename), _path.c_str(), static_cast<int>(frame_._index));
+			SDL_Surface* surf = SDL_CreateRGBSurfaceWithFormatFrom(frame_._rgba.data(), frame_._width, frame_._height,
+				32, frame_._width * 4, SDL_PIXELFORMAT_RGBA32);
+			if (!surf || IMG_SavePNG(surf, filename) != 0)
+				logw() << "FrameCapture: failed writing " << filename << ": " << IMG_GetError();
+			SDL_FreeSurface(surf);
+			break;
+		}
+		}
+	}
+
+}
@@ -0,0 +1,173 @@
+#include <sally/gfx/particle_emitter.hpp>
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# include <emmintrin.h>
+# define SALLY_PARTICLES_SSE2
+#endif
+
+namespace sally {
+
+	ParticleEmitter::ParticleEmitter(Renderable* texture_, const Config& config_)
+		: _texture(texture_), _config(config_), _origin_x(0), _origin_y(0), _emit_carry(0), _rng(0x2545f491), _alive(0), _dropped(0)
+	{
+		if (!_texture)
+			throw general_exception("ParticleEmitter requires a texture");
+		if (_config.capacity == 0)
+			throw general_exception("ParticleEmitter capacity must be positive");
+		if (_config.life_min <= 0 || _config.life_max < _config.life_min)
+			throw general_exception("ParticleEmitter life range is invalid");
+
+		const size_t padded = (_config.capacity + 3) & ~size_t(3);
+		for (std::vector<float>* arr : { &_x, &_y, &_vx, &_vy, &_age, &_inv_life, &_r, &_g, &_b, &_a, &_size })
+			arr->assign(padded, 0.0f);
+		_src.resize(_config.capacity);
+		_dst.resize(_config.capacity);
+		_tints.resize(_config.capacity);
+	}
+
+	// xorshift, emission only needs to look random
+	float ParticleEmitter::random(float lo_, float hi_)
+	{
+		_rng ^= _rng << 13;
+		_rng ^= _rng >> 17;
+		_rng ^= _rng << 5;
+		return lo_ + (hi_ - lo_) * float(_rng >> 8) * (1.0f / 16777216.0f);
+	}
+
+	void ParticleEmitter::spawn(size_t index_)
+	{
+		const float angle = _config.angle + random(-_config.spread, _config.spread);
+		const float speed = random(_config.speed_min, _config.speed_max);
+		_x[index_] = _origin_x;
+		_y[index_] = _origin_y;
+		_vx[index_] = speed * std::cos(angle);
+		_vy[index_] = speed * std::sin(angle);
+		_age[index_] = 0;
+		_inv_life[index_] = 1.0f / random(_config.life_min, _config.life_max);
+		_r[index_] = _config.color_start._r;
+		_g[index_] = _config.color_start._g;
+		_b[index_] = _config.color_start._b;
+		_a[index_] = _config.color_start._a;
+		_size[index_] = _config.size_start;
+	}
+
+	size_t ParticleEmitter::burst(size_t count_)
+	{
+		const size_t fits = std::min(count_, _config.capacity - _alive);
+		for (size_t ii = 0; ii < fits; ++ii)
+			spawn(_alive++);
+		_dropped += count_ - fits;
+		return fits;
+	}
+
+	void ParticleEmitter::update(float dt_)
+	{
+		if (dt_ <= 0)
+			return;
+		if (_config.rate > 0) {
+			const float due = _emit_carry + _config.rate * dt_;
+			const size_t count = static_cast<size_t>(due);
+			_emit_carry = due - float(count);
+			burst(count);
+		}
+		integrate(dt_);
+		recycle();
+	}
+
+	// the pool is padded to a multiple of four, lanes past _alive compute garbage nobody reads
+	void ParticleEmitter::integrate(float dt_)
+	{
+		const float gx = _config.gravity_x * dt_, gy = _config.gravity_y * dt_;
+		const Color& c0 = _config.color_start;
+		const Color& c1 = _config.color_end;
+		const float r0 = c0._r, g0 = c0._g, b0 = c0._b, a0 = c0._a, s0 = _config.size_start;
+		const float dr = float(c1._r) - r0, dg = float(c1._g) - g0, db = float(c1._b) - b0, da = float(c1._a) - a0;
+		const float ds = _config.size_end - s0;
+		const size_t count = (_alive + 3) & ~size_t(3);
+
+		float* __restrict x = _x.data();
+		float* __restrict y = _y.data();
+		float* __restrict vx = _vx.data();
+		float* __restrict vy = _vy.data();
+		float* __restrict age = _age.data();
+		const float* __restrict inv_life = _inv_life.data();
+		float* __restrict r = _r.data();
+		float* __restrict g = _g.data();
+		float* __restrict b = _b.data();
+		float* __restrict a = _a.data();
+		float* __restrict size = _size.data();
+
+#ifdef SALLY_PARTICLES_SSE2
+		const __m128 vdt = _mm_set1_ps(dt_), vgx = _mm_set1_ps(gx), vgy = _mm_set1_ps(gy), one = _mm_set1_ps(1.0f);
+		const __m128 vr0 = _mm_set1_ps(r0), vg0 = _mm_set1_ps(g0), vb0 = _mm_set1_ps(b0), va0 = _mm_set1_ps(a0), vs0 = _mm_set1_ps(s0);
+		const __m128 vdr = _mm_set1_ps(dr), vdg = _mm_set1_ps(dg), vdb = _mm_set1_ps(db), vda = _mm_set1_ps(da), vds = _mm_set1_ps(ds);
+		for (size_t ii = 0; ii < count; ii += 4) {
+			const __m128 nvx = _mm_add_ps(_mm_loadu_ps(vx + ii), vgx);
+			const __m128 nvy = _mm_add_ps(_mm_loadu_ps(vy + ii), vgy);
+			_mm_storeu_ps(vx + ii, nvx);
+			_mm_storeu_ps(vy + ii, nvy);
+			_mm_storeu_ps(x + ii, _mm_add_ps(_mm_loadu_ps(x + ii), _mm_mul_ps(nvx, vdt)));
+			_mm_storeu_ps(y + ii, _mm_add_ps(_mm_loadu_ps(y + ii), _mm_mul_ps(nvy, vdt)));
+			const __m128 nage = _mm_add_ps(_mm_loadu_ps(age + ii), vdt);
+			_mm_storeu_ps(age + ii, nage);
+			const __m128 t = _mm_min_ps(_mm_mul_ps(nage, _mm_loadu_ps(inv_life + ii)), one);
+			_mm_storeu_ps(r + ii, _mm_add_ps(vr0, _mm_mul_ps(vdr, t)));
+			_mm_storeu_ps(g + ii, _mm_add_ps(vg0, _mm_mul_ps(vdg, t)));
+			_mm_storeu_ps(b + ii, _mm_add_ps(vb0, _mm_mul_ps(vdb, t)));
+			_mm_storeu_ps(a + ii, _mm_add_ps(va0, _mm_mul_ps(vda, t)));
+			_mm_storeu_ps(size + ii, _mm_add_ps(vs0, _mm_mul_ps(vds, t)));
+		}
+#else
+		for (size_t ii = 0; ii < count; ++ii) {
+			vx[ii] += gx;
+			vy[ii] += gy;
+			x[ii] += vx[ii] * dt_;
+			y[ii] += vy[ii] * dt_;
+			age[ii] += dt_;
+			const float t = std::min(age[ii] * inv_life[ii], 1.0f);
+			r[ii] = r0 + dr * t;
+			g[ii] = g0 + dg * t;
+			b[ii] = b0 + db * t;
+			a[ii] = a0 + da * t;
+			size[ii] = s0 + ds * t;
+		}
+#endif
+	}
+
+	// dead particles are replaced by the last live one, the pool stays dense without allocating
+	void ParticleEmitter::recycle()
+	{
+		for (size_t ii = 0; ii < _alive; ) {
+			if (_age[ii] * _inv_life[ii] < 1.0f) {
+				++ii;
+				continue;
+			}
+			const size_t last = --_alive;
+			if (ii == last)
+				break;
+			for (std::vector<float>* arr : { &_x, &_y, &_vx, &_vy, &_age, &_inv_life, &_r, &_g, &_b, &_a, &_size })
+				(*arr)[ii] = (*arr)[last];
+		}
+	}
+
+	void ParticleEmitter::render(Renderer& renderer_, int offset_x_, int offset_y_)
+	{
+		if (!_alive)
+			return;
+		Rect src = _config.src;
+		if (src._width <= 0 || src._height <= 0)
+			_texture->fill_bounding_rect(renderer_, src);
+
+		for (size_t ii = 0; ii < _alive; ++ii) {
+			const int size = static_cast<int>(_size[ii] + 0.5f);
+			_src[ii] = src;
+			_dst[ii] = Rect(static_cast<int>(_x[ii]) - size / 2 + offset_x_, static_cast<int>(_y[ii]) - size / 2 + offset_y_, size, size);
+			_tints[ii] = Color(static_cast<unsigned char>(_r[ii]), static_cast<unsigned char>(_g[ii]),
+				static_cast<unsigned char>(_b[ii]), static_cast<unsigned char>(_a[ii]));
+		}
+		renderer_.render_batch(_texture, _src.data(), _dst.data(), _tints.data(), _alive);
+	}
+
+}
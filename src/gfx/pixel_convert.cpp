@@ -0,0 +1,177 @@
+#include <sally/gfx/pixel_convert.hpp>
+
+#if defined(__AVX2__)
+# include <immintrin.h>
+# define SALLY_PIXEL_AVX2
+# define SALLY_PIXEL_SSE2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# include <emmintrin.h>
+# define SALLY_PIXEL_SSE2
+#endif
+
+namespace sally {
+
+	namespace pixel_kernels {
+
+		// rounded x/255 for x in [0,65535], same as the software rasterizer
+		static inline uint32_t div255(uint32_t x_) { x_ += 128; return (x_ + (x_ >> 8)) >> 8; }
+
+		static inline uint32_t swap_rb_pixel(uint32_t p_)
+		{
+			const uint32_t rb = p_ & 0x00ff00ff;
+			return (p_ & 0xff00ff00) | (rb << 16) | (rb >> 16);
+		}
+
+		static inline uint32_t premultiply_pixel(uint32_t p_)
+		{
+			const uint32_t a = p_ >> 24;
+			return (p_ & 0xff000000) | (div255(((p_ >> 16) & 0xff) * a) << 16)
+				| (div255(((p_ >> 8) & 0xff) * a) << 8) | div255((p_ & 0xff) * a);
+		}
+
+		void swap_rb_scalar(const uint32_t* src_, uint32_t* dst_, size_t count_)
+		{
+			for (size_t ii = 0; ii < count_; ++ii)
+				dst_[ii] = swap_rb_pixel(src_[ii]);
+		}
+
+		void premultiply_scalar(const uint32_t* src_, uint32_t* dst_, size_t count_)
+		{
+			for (size_t ii = 0; ii < count_; ++ii)
+				dst_[ii] = premultiply_pixel(src_[ii]);
+		}
+
+		void alpha_to_argb_scalar(const uint8_t* src_, uint32_t* dst_, size_t count_, uint32_t color_)
+		{
+			const uint32_t rgb = color_ & 0xffffff, a = color_ >> 24;
+			for (size_t ii = 0; ii < count_; ++ii)
+				dst_[ii] = rgb | (div255(src_[ii] * a) << 24);
+		}
+
+#ifdef SALLY_PIXEL_SSE2
+		static inline __m128i div255_epu16(__m128i x_)
+		{
+			x_ = _mm_add_epi16(x_, _mm_set1_epi16(128));
+			return _mm_srli_epi16(_mm_add_epi16(x_, _mm_srli_epi16(x_, 8)), 8);
+		}
+
+		static inline __m128i swap_rb_epi32(__m128i p_)
+		{
+			const __m128i rb = _mm_and_si128(p_, _mm_set1_epi32(0x00ff00ff));
+			return _mm_or_si128(_mm_and_si128(p_, _mm_set1_epi32(int(0xff00ff00))),
+				_mm_or_si128(_mm_slli_epi32(rb, 16), _mm_srli_epi32(rb, 16)));
+		}
+
+		// two pixels unpacked to 16 bit lanes (alpha in lanes 3 and 7)
+		static inline __m128i premultiply_epu16(__m128i p_)
+		{
+			const __m128i alpha_lanes = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+			__m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(p_, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+			__m128i c = div255_epu16(_mm_mullo_epi16(p_, a));
+			return _mm_or_si128(_mm_andnot_si128(alpha_lanes, c), _mm_and_si128(alpha_lanes, p_));
+		}
+#endif
+
+#ifdef SALLY_PIXEL_AVX2
+		static inline __m256i div255_epu16(__m256i x_)
+		{
+			x_ = _mm256_add_epi16(x_, _mm256_set1_epi16(128));
+			return _mm256_srli_epi16(_mm256_add_epi16(x_, _mm256_srli_epi16(x_, 8)), 8);
+		}
+
+		static inline __m256i premultiply_epu16(__m256i p_)
+		{
+			const __m256i alpha_lanes = _mm256_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0);
+			__m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(p_, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+			__m256i c = div255_epu16(_mm256_mullo_epi16(p_, a));
+			return _mm256_or_si256(_mm256_andnot_si256(alpha_lanes, c), _mm256_and_si256(alpha_lanes, p_));
+		}
+#endif
+
+		void swap_rb(const uint32_t* src_, uint32_t* dst_, size_t count_)
+		{
+			size_t ii = 0;
+#if defined(SALLY_PIXEL_AVX2)
+			// in-lane byte shuffle: bytes 0 and 2 of every pixel trade places
+			const __m256i order = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+				2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+			for (; ii + 8 <= count_; ii += 8) {
+				__m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src_ + ii));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst_ + ii), _mm256_shuffle_epi8(p, order));
+			}
+#elif defined(SALLY_PIXEL_SSE2)
+			for (; ii + 4 <= count_; ii += 4) {
+				__m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_ + ii));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst_ + ii), swap_rb_epi32(p));
+			}
+#endif
+			for (; ii < count_; ++ii)
+				dst_[ii] = swap_rb_pixel(src_[ii]);
+		}
+
+		void premultiply(const uint32_t* src_, uint32_t* dst_, size_t count_)
+		{
+			size_t ii = 0;
+#if defined(SALLY_PIXEL_AVX2)
+			const __m256i zero256 = _mm256_setzero_si256();
+			for (; ii + 8 <= count_; ii += 8) {
+				__m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src_ + ii));
+				__m256i lo = premultiply_epu16(_mm256_unpacklo_epi8(p, zero256));
+				__m256i hi = premultiply_epu16(_mm256_unpackhi_epi8(p, zero256));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst_ + ii), _mm256_packus_epi16(lo, hi));
+			}
+#endif
+#if defined(SALLY_PIXEL_SSE2)
+			const __m128i zero = _mm_setzero_si128();
+			for (; ii + 4 <= count_; ii += 4) {
+				__m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_ + ii));
+				__m128i lo = premultiply_epu16(_mm_unpacklo_epi8(p, zero));
+				__m128i hi = premultiply_epu16(_mm_unpackhi_epi8(p, zero));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst_ + ii), _mm_packus_epi16(lo, hi));
+			}
+#endif
+			for (; ii < count_; ++ii)
+				dst_[ii] = premultiply_pixel(src_[ii]);
+		}
+
+		void alpha_to_argb(const uint8_t* src_, uint32_t* dst_, size_t count_, uint32_t color_)
+		{
+			size_t ii = 0;
+#if defined(SALLY_PIXEL_SSE2)
+			// glyph rows are short, 16 coverage bytes per iteration is plenty (also with AVX2)
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i alpha = _mm_set1_epi16(static_cast<short>(color_ >> 24));
+			const __m128i rgb = _mm_set1_epi32(static_cast<int>(color_ & 0xffffff));
+			for (; ii + 16 <= count_; ii += 16) {
+				__m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_ + ii));
+				__m128i lo = div255_epu16(_mm_mullo_epi16(_mm_unpacklo_epi8(c, zero), alpha));
+				__m128i hi = div255_epu16(_mm_mullo_epi16(_mm_unpackhi_epi8(c, zero), alpha));
+				__m128i a = _mm_packus_epi16(lo, hi);
+				// move every alpha byte to the top byte of its pixel:
+				__m128i a16lo = _mm_unpacklo_epi8(zero, a), a16hi = _mm_unpackhi_epi8(zero, a);
+				__m128i* dst = reinterpret_cast<__m128i*>(dst_ + ii);
+				_mm_storeu_si128(dst, _mm_or_si128(rgb, _mm_unpacklo_epi16(zero, a16lo)));
+				_mm_storeu_si128(dst + 1, _mm_or_si128(rgb, _mm_unpackhi_epi16(zero, a16lo)));
+				_mm_storeu_si128(dst + 2, _mm_or_si128(rgb, _mm_unpacklo_epi16(zero, a16hi)));
+				_mm_storeu_si128(dst + 3, _mm_or_si128(rgb, _mm_unpackhi_epi16(zero, a16hi)));
+			}
+#endif
+			const uint32_t rgb_scalar = color_ & 0xffffff, a_scalar = color_ >> 24;
+			for (; ii < count_; ++ii)
+				dst_[ii] = rgb_scalar | (div255(src_[ii] * a_scalar) << 24);
+		}
+
+		const char* isa()
+		{
+#if defined(SALLY_PIXEL_AVX2)
+			return "avx2";
+#elif defined(SALLY_PIXEL_SSE2)
+			return "sse2";
+#else
+			return "scalar";
+#endif
+		}
+
+	}
+
+}
@@ -0,0 +1,431 @@
+#include <sally/gfx/soft_raster.hpp>
+#include <sally/util/worker_pool.hpp>
+#include <SDL.h>
+#include <algorithm>
+#include <cstdlib>
+
+#if defined(__AVX2__)
+# include <immintrin.h>
+# define SALLY_SOFT_AVX2
+# define SALLY_SOFT_SSE2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# include <emmintrin.h>
+# define SALLY_SOFT_SSE2
+#endif
+
+namespace sally {
+
+	namespace soft_kernels {
+
+		// rounded x/255 for x in [0,65535], exact and cheap to vectorize
+		static inline uint32_t div255(uint32_t x_) { x_ += 128; return (x_ + (x_ >> 8)) >> 8; }
+
+		// dst = src*a + dst*(1-a) for color channels, dst_a = src_a + dst_a*(1-a)
+		static inline uint32_t blend_pixel(uint32_t d_, uint32_t s_)
+		{
+			uint32_t a = s_ >> 24, ia = 255 - a;
+			uint32_t b = div255((s_ & 0xff) * a + (d_ & 0xff) * ia);
+			uint32_t g = div255(((s_ >> 8) & 0xff) * a + ((d_ >> 8) & 0xff) * ia);
+			uint32_t r = div255(((s_ >> 16) & 0xff) * a + ((d_ >> 16) & 0xff) * ia);
+			uint32_t oa = div255(255 * a + (d_ >> 24) * ia);
+			return (oa << 24) | (r << 16) | (g << 8) | b;
+		}
+
+		// every channel of s_ scaled by the matching channel of t_ (SDL's color and alpha mod)
+		static inline uint32_t modulate_pixel(uint32_t s_, uint32_t t_)
+		{
+			return (div255((s_ >> 24) * (t_ >> 24)) << 24) | (div255(((s_ >> 16) & 0xff) * ((t_ >> 16) & 0xff)) << 16)
+				| (div255(((s_ >> 8) & 0xff) * ((t_ >> 8) & 0xff)) << 8) | div255((s_ & 0xff) * (t_ & 0xff));
+		}
+
+#ifdef SALLY_SOFT_SSE2
+		static inline __m128i div255_epu16(__m128i x_)
+		{
+			x_ = _mm_add_epi16(x_, _mm_set1_epi16(128));
+			return _mm_srli_epi16(_mm_add_epi16(x_, _mm_srli_epi16(x_, 8)), 8);
+		}
+
+		// blends two ARGB pixels unpacked to 16 bit lanes (alpha in lanes 3 and 7)
+		static inline __m128i blend_epu16(__m128i s_, __m128i d_)
+		{
+			const __m128i c255 = _mm_set1_epi16(255);
+			const __m128i alpha_lanes = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+			__m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s_, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+			__m128i ia = _mm_sub_epi16(c255, a);
+			__m128i sa = _mm_or_si128(_mm_andnot_si128(alpha_lanes, a), _mm_and_si128(alpha_lanes, c255));
+			return div255_epu16(_mm_add_epi16(_mm_mullo_epi16(s_, sa), _mm_mullo_epi16(d_, ia)));
+		}
+#endif
+
+#ifdef SALLY_SOFT_AVX2
+		static inline __m256i div255_epu16(__m256i x_)
+		{
+			x_ = _mm256_add_epi16(x_, _mm256_set1_epi16(128));
+			return _mm256_srli_epi16(_mm256_add_epi16(x_, _mm256_srli_epi16(x_, 8)), 8);
+		}
+
+		static inline __m256i blend_epu16(__m256i s_, __m256i d_)
+		{
+			const __m256i c255 = _mm256_set1_epi16(255);
+			const __m256i alpha_lanes = _mm256_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0);
+			__m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s_, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+			__m256i ia = _mm256_sub_epi16(c255, a);
+			__m256i sa = _mm256_or_si256(_mm256_andnot_si256(alpha_lanes, a), _mm256_and_si256(alpha_lanes, c255));
+			return div255_epu16(_mm256_add_epi16(_mm256_mullo_epi16(s_, sa), _mm256_mullo_epi16(d_, ia)));
+		}
+#endif
+
+		void fill_row(uint32_t* dst_, int count_, uint32_t argb_)
+		{
+			int ii = 0;
+#ifdef SALLY_SOFT_SSE2
+			const __m128i c = _mm_set1_epi32(static_cast<int>(argb_));
+			for (; ii + 4 <= count_; ii += 4)
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst_ + ii), c);
+#endif
+			for (; ii < count_; ++ii)
+				dst_[ii] = argb_;
+		}
+
+		void blend_row(uint32_t* dst_, const uint32_t* src_, int count_)
+		{
+			int ii = 0;
+#if defined(SALLY_SOFT_AVX2)
+			const __m256i zero = _mm256_setzero_si256();
+			for (; ii + 8 <= count_; ii += 8) {
+				__m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src_ + ii));
+				__m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst_ + ii));
+				__m256i lo = blend_epu16(_mm256_unpacklo_epi8(s, zero), _mm256_unpacklo_epi8(d, zero));
+				__m256i hi = blend_epu16(_mm256_unpackhi_epi8(s, zero), _mm256_unpackhi_epi8(d, zero));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst_ + ii), _mm256_packus_epi16(lo, hi));
+			}
+#elif defined(SALLY_SOFT_SSE2)
+			const __m128i zero = _mm_setzero_si128();
+			for (; ii + 4 <= count_; ii += 4) {
+				__m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_ + ii));
+				__m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst_ + ii));
+				__m128i lo = blend_epu16(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(d, zero));
+				__m128i hi = blend_epu16(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(d, zero));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst_ + ii), _mm_packus_epi16(lo, hi));
+			}
+#endif
+			for (; ii < count_; ++ii)
+				dst_[ii] = blend_pixel(dst_[ii], src_[ii]);
+		}
+
+		void blend_color_row(uint32_t* dst_, int count_, uint32_t argb_)
+		{
+			int ii = 0;
+#ifdef SALLY_SOFT_SSE2
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i s = _mm_unpacklo_epi8(_mm_set1_epi32(static_cast<int>(argb_)), zero);
+			for (; ii + 4 <= count_; ii += 4) {
+				__m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst_ + ii));
+				__m128i lo = blend_epu16(s, _mm_unpacklo_epi8(d, zero));
+				__m128i hi = blend_epu16(s, _mm_unpackhi_epi8(d, zero));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst_ + ii), _mm_packus_epi16(lo, hi));
+			}
+#endif
+			for (; ii < count_; ++ii)
+				dst_[ii] = blend_pixel(dst_[ii], argb_);
+		}
+
+		void modulate_row(uint32_t* dst_, const uint32_t* src_, int count_, uint32_t argb_)
+		{
+			int ii = 0;
+#if defined(SALLY_SOFT_AVX2)
+			const __m256i zero = _mm256_setzero_si256();
+			const __m256i t = _mm256_unpacklo_epi8(_mm256_set1_epi32(static_cast<int>(argb_)), zero);
+			for (; ii + 8 <= count_; ii += 8) {
+				__m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src_ + ii));
+				__m256i lo = div255_epu16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(s, zero), t));
+				__m256i hi = div255_epu16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(s, zero), t));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst_ + ii), _mm256_packus_epi16(lo, hi));
+			}
+#elif defined(SALLY_SOFT_SSE2)
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i t = _mm_unpacklo_epi8(_mm_set1_epi32(static_cast<int>(argb_)), zero);
+			for (; ii + 4 <= count_; ii += 4) {
+				__m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_ + ii));
+				__m128i lo = div255_epu16(_mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), t));
+				__m128i hi = div255_epu16(_mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), t));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst_ + ii), _mm_packus_epi16(lo, hi));
+			}
+#endif
+			for (; ii < count_; ++ii)
+				dst_[ii] = modulate_pixel(src_[ii], argb_);
+		}
+
+		void blend_row_scalar(uint32_t* dst_, const uint32_t* src_, int count_)
+		{
+			for (int ii = 0; ii < count_; ++ii)
+				dst_[ii] = blend_pixel(dst_[ii], src_[ii]);
+		}
+
+		void blend_color_row_scalar(uint32_t* dst_, int count_, uint32_t argb_)
+		{
+			for (int ii = 0; ii < count_; ++ii)
+				dst_[ii] = blend_pixel(dst_[ii], argb_);
+		}
+
+		void modulate_row_scalar(uint32_t* dst_, const uint32_t* src_, int count_, uint32_t argb_)
+		{
+			for (int ii = 0; ii < count_; ++ii)
+				dst_[ii] = modulate_pixel(src_[ii], argb_);
+		}
+
+		const char* isa()
+		{
+#if defined(SALLY_SOFT_AVX2)
+			return "avx2";
+#elif defined(SALLY_SOFT_SSE2)
+			return "sse2";
+#else
+			return "scalar";
+#endif
+		}
+
+	}
+
+	// SoftRaster:
+
+	SoftRaster::SoftRaster(int width_, int height_)
+		: _width(std::max(width_, 0)), _height(std::max(height_, 0)),
+		  _tiles_x((_width + TILE_SIZE - 1) / TILE_SIZE), _tiles_y((_height + TILE_SIZE - 1) / TILE_SIZE),
+		  _active_width(_width), _active_height(_height), _clipped(false),
+		  _pixels(size_t(_width) * _height, 0xff000000), _bins(size_t(_tiles_x) * _tiles_y)
+	{
+	}
+
+	SoftRaster::~SoftRaster()
+	{
+		release_commands();
+	}
+
+	void SoftRaster::clear(uint32_t argb_)
+	{
+		// everything submitted so far is overdrawn, no point rasterizing it:
+		for (auto it = _bins.begin(); it != _bins.end(); ++it)
+			it->clear();
+
+		Command cmd;
+		cmd._type = CMD_CLEAR;
+		cmd._blend = false;
+		cmd._color = argb_;
+		cmd._surface = nullptr;
+		cmd._clip = Rect(0, 0, _active_width, _active_height);
+		_commands.push_back(cmd);
+		bin(static_cast<uint32_t>(_commands.size() - 1), 0, 0, _width, _height);
+	}
+
+	void SoftRaster::fill_rect(const Rect& rect_, uint32_t argb_, bool blend_)
+	{
+		if (blend_ && (argb_ >> 24) == 0)
+			return;
+
+		Command cmd;
+		cmd._type = CMD_FILL;
+		cmd._blend = blend_ && (argb_ >> 24) != 255;
+		cmd._color = argb_;
+		cmd._dst = rect_;
+		cmd._surface = nullptr;
+		cmd._clip = command_clip();
+		_commands.push_back(cmd);
+		bin(static_cast<uint32_t>(_commands.size() - 1), rect_._x, rect_._y, rect_._x + rect_._width, rect_._y + rect_._height);
+	}
+
+	void SoftRaster::draw_line(int x1_, int y1_, int x2_, int y2_, uint32_t argb_, bool blend_)
+	{
+		Command cmd;
+		cmd._type = CMD_LINE;
+		cmd._blend = blend_ && (argb_ >> 24) != 255;
+		cmd._color = argb_;
+		cmd._dst = Rect(x1_, y1_, x2_, y2_);
+		cmd._surface = nullptr;
+		cmd._clip = command_clip();
+		_commands.push_back(cmd);
+		bin(static_cast<uint32_t>(_commands.size() - 1),
+			std::min(x1_, x2_), std::min(y1_, y2_), std::max(x1_, x2_) + 1, std::max(y1_, y2_) + 1);
+	}
+
+	void SoftRaster::blit(SDL_Surface* src_, const Rect& src_rect_, const Rect& dst_rect_, bool blend_, uint32_t tint_)
+	{
+		if (!src_ || src_->format->format != SDL_PIXELFORMAT_ARGB8888)
+			throw general_exception("SoftRaster::blit requires an ARGB8888 surface");
+		if (src_rect_._width <= 0 || src_rect_._height <= 0 || dst_rect_._width <= 0 || dst_rect_._height <= 0)
+			return;
+		if (blend_ && (tint_ >> 24) == 0)
+			return;
+
+		// clip the source to the surface, adjusting the destination proportionally (as SDL_RenderCopy does):
+		Rect src = src_rect_, dst = dst_rect_;
+		int x0 = std::max(src._x, 0), y0 = std::max(src._y, 0);
+		int x1 = std::min(src._x + src._width, src_->w), y1 = std::min(src._y + src._height, src_->h);
+		if (x0 >= x1 || y0 >= y1)
+			return;
+		if (x0 != src._x || y0 != src._y || x1 - x0 != src._width || y1 - y0 != src._height) {
+			dst._x = dst_rect_._x + (x0 - src._x) * dst_rect_._width / src_rect_._width;
+			dst._y = dst_rect_._y + (y0 - src._y) * dst_rect_._height / src_rect_._height;
+			dst._width = (x1 - x0) * dst_rect_._width / src_rect_._width;
+			dst._height = (y1 - y0) * dst_rect_._height / src_rect_._height;
+			src = Rect(x0, y0, x1 - x0, y1 - y0);
+			if (dst._width <= 0 || dst._height <= 0)
+				return;
+		}
+
+		Command cmd;
+		cmd._type = CMD_BLIT;
+		cmd._blend = blend_;
+		cmd._color = tint_;
+		cmd._dst = dst;
+		cmd._src = src;
+		cmd._surface = src_;
+		cmd._clip = command_clip();
+		++src_->refcount; // released in flush (SDL_FreeSurface)
+		_commands.push_back(cmd);
+		bin(static_cast<uint32_t>(_commands.size() - 1), dst._x, dst._y, dst._x + dst._width, dst._y + dst._height);
+	}
+
+	Rect SoftRaster::command_clip() const
+	{
+		if (!_clipped)
+			return Rect(0, 0, _active_width, _active_height);
+		const int x0 = std::max(_clip._x, 0), y0 = std::max(_clip._y, 0);
+		const int x1 = std::min(_clip._x + _clip._width, _active_width), y1 = std::min(_clip._y + _clip._height, _active_height);
+		return Rect(x0, y0, std::max(x1 - x0, 0), std::max(y1 - y0, 0));
+	}
+
+	void SoftRaster::bin(uint32_t cmd_, int x0_, int y0_, int x1_, int y1_)
+	{
+		const Rect& clip = _commands[cmd_]._clip;
+		x0_ = std::max(x0_, clip._x);
+		y0_ = std::max(y0_, clip._y);
+		x1_ = std::min(x1_, clip._x + clip._width);
+		y1_ = std::min(y1_, clip._y + clip._height);
+		if (x0_ >= x1_ || y0_ >= y1_)
+			return; // entirely off screen (or clipped)
+
+		int tx1 = (x1_ - 1) / TILE_SIZE, ty1 = (y1_ - 1) / TILE_SIZE;
+		for (int ty = y0_ / TILE_SIZE; ty <= ty1; ++ty)
+			for (int tx = x0_ / TILE_SIZE; tx <= tx1; ++tx)
+				_bins[size_t(ty) * _tiles_x + tx].push_back(cmd_);
+	}
+
+	void SoftRaster::flush(worker_pool& pool_)
+	{
+		if (!_commands.empty())
+			pool_.run(_bins.size(), [this](size_t tile_) { rasterize_tile(tile_); });
+		release_commands();
+	}
+
+	void SoftRaster::release_commands()
+	{
+		for (auto it = _commands.begin(); it != _commands.end(); ++it)
+			if (it->_surface)
+				SDL_FreeSurface(it->_surface);
+		_commands.clear();
+		for (auto it = _bins.begin(); it != _bins.end(); ++it)
+			it->clear();
+	}
+
+	void SoftRaster::rasterize_tile(size_t tile_)
+	{
+		const std::vector<uint32_t>& bin = _bins[tile_];
+		if (bin.empty())
+			return;
+
+		const int tile_x = static_cast<int>(tile_ % _tiles_x) * TILE_SIZE;
+		const int tile_y = static_cast<int>(tile_ / _tiles_x) * TILE_SIZE;
+		uint32_t* const fb = _pixels.data();
+		uint32_t row[TILE_SIZE];
+		uint32_t tinted[TILE_SIZE];
+
+		for (auto it = bin.begin(); it != bin.end(); ++it) {
+			const Command& cmd = _commands[*it];
+			// the part of the tile the command may draw to
+			const int tx0 = std::max(tile_x, cmd._clip._x), tx1 = std::min(tile_x + TILE_SIZE, cmd._clip._x + cmd._clip._width);
+			const int ty0 = std::max(tile_y, cmd._clip._y), ty1 = std::min(tile_y + TILE_SIZE, cmd._clip._y + cmd._clip._height);
+			switch (cmd._type) {
+			case CMD_CLEAR:
+				for (int y = ty0; y < ty1; ++y)
+					soft_kernels::fill_row(fb + size_t(y) * _width + tx0, tx1 - tx0, cmd._color);
+				break;
+
+			case CMD_FILL: {
+				int x0 = std::max(cmd._dst._x, tx0), x1 = std::min(cmd._dst._x + cmd._dst._width, tx1);
+				int y0 = std::max(cmd._dst._y, ty0), y1 = std::min(cmd._dst._y + cmd._dst._height, ty1);
+				for (int y = y0; y < y1; ++y) {
+					uint32_t* dst = fb + size_t(y) * _width + x0;
+					if (cmd._blend)
+						soft_kernels::blend_color_row(dst, x1 - x0, cmd._color);
+					else
+						soft_kernels::fill_row(dst, x1 - x0, cmd._color);
+				}
+				break;
+			}
+
+			case CMD_LINE: {
+				// bresenham over the whole line, only plotting the points inside this tile
+				int x = cmd._dst._x, y = cmd._dst._y;
+				const int x2 = cmd._dst._width, y2 = cmd._dst._height;
+				const int dx = std::abs(x2 - x), sx = x < x2 ? 1 : -1;
+				const int dy = -std::abs(y2 - y), sy = y < y2 ? 1 : -1;
+				int err = dx + dy;
+				for (;;) {
+					if (x >= tx0 && x < tx1 && y >= ty0 && y < ty1) {
+						uint32_t& px = fb[size_t(y) * _width + x];
+						px = cmd._blend ? soft_kernels::blend_pixel(px, cmd._color) : cmd._color;
+					}
+					if (x == x2 && y == y2)
+						break;
+					int e2 = 2 * err;
+					if (e2 >= dy) { err += dy; x += sx; }
+					if (e2 <= dx) { err += dx; y += sy; }
+				}
+				break;
+			}
+
+			case CMD_BLIT: {
+				const Rect& d = cmd._dst;
+				const Rect& s = cmd._src;
+				int x0 = std::max(d._x, tx0), x1 = std::min(d._x + d._width, tx1);
+				int y0 = std::max(d._y, ty0), y1 = std::min(d._y + d._height, ty1);
+				if (x0 >= x1 || y0 >= y1)
+					break;
+				const uint8_t* src_pixels = static_cast<const uint8_t*>(cmd._surface->pixels);
+				const int src_pitch = cmd._surface->pitch;
+				const bool scaled_x = s._width != d._width;
+				if (scaled_x) // nearest neighbour, sampling at pixel centers
+					for (int x = x0; x < x1; ++x)
+						row[x - x0] = static_cast<uint32_t>(s._x + (int64_t(2 * (x - d._x) + 1) * s._width) / (2 * d._width));
+
+				for (int y = y0; y < y1; ++y) {
+					int sy = s._y + static_cast<int>((int64_t(2 * (y - d._y) + 1) * s._height) / (2 * d._height));
+					const uint32_t* src_row = reinterpret_cast<const uint32_t*>(src_pixels + size_t(sy) * src_pitch);
+					uint32_t* dst = fb + size_t(y) * _width + x0;
+					const uint32_t* src;
+					uint32_t gathered[TILE_SIZE];
+					if (scaled_x) {
+						for (int x = x0; x < x1; ++x)
+							gathered[x - x0] = src_row[row[x - x0]];
+						src = gathered;
+					}
+					else
+						src = src_row + s._x + (x0 - d._x);
+					if (cmd._color != 0xffffffff) {
+						soft_kernels::modulate_row(tinted, src, x1 - x0, cmd._color);
+						src = tinted;
+					}
+
+					if (cmd._blend)
+						soft_kernels::blend_row(dst, src, x1 - x0);
+					else
+						std::copy(src, src + (x1 - x0), dst);
+				}
+				break;
+			}
+			}
+		}
+	}
+
+}
@@ -0,0 +1,171 @@
+#include <sally/gfx/sprite_system.hpp>
+#include <sally/util/worker_pool.hpp>
+#include <algorithm>
+
+namespace sally {
+
+	namespace {
+		// sprites per update task, large enough to amortize the dispatch
+		const size_t UPDATE_TASK_SPRITES = 16 * 1024;
+		const int LAYERS = 256;
+
+		// wraps v_ into [0,range_), truncation instead of floor keeps the loops vectorizable with plain SSE2
+		inline float wrap(float v_, float range_) {
+			v_ -= range_ * float(int(v_ / range_));
+			return v_ + (v_ < 0 ? range_ : 0.0f);
+		}
+
+		template <class T> void swap_pop(std::vector<T>& vec_, size_t index_) {
+			vec_[index_] = vec_.back();
+			vec_.pop_back();
+		}
+	}
+
+	SpriteSystem::SpriteSystem(Renderable* atlas_, int frame_width_, int frame_height_)
+		: _atlas(atlas_), _frame_width(frame_width_), _frame_height(frame_height_), _drawn(0)
+	{
+		if (!_atlas)
+			throw general_exception("SpriteSystem requires an atlas");
+		if (_frame_width <= 0 || _frame_height <= 0)
+			throw general_exception("SpriteSystem frame size must be positive");
+	}
+
+	auto SpriteSystem::add(float x_, float y_, float vx_, float vy_, uint16_t first_frame_, uint16_t frame_count_, float fps_,
+		const Color& tint_, uint8_t layer_) -> index_t
+	{
+		_x.push_back(x_);
+		_y.push_back(y_);
+		_vx.push_back(vx_);
+		_vy.push_back(vy_);
+		_phase.push_back(0);
+		_fps.push_back(fps_);
+		_first.push_back(first_frame_);
+		_count.push_back(std::max<uint16_t>(frame_count_, 1));
+		_tint.push_back(tint_);
+		_layer.push_back(layer_);
+		return _x.size() - 1;
+	}
+
+	void SpriteSystem::remove(index_t index_)
+	{
+		if (index_ >= size())
+			return;
+		swap_pop(_x, index_); swap_pop(_y, index_);
+		swap_pop(_vx, index_); swap_pop(_vy, index_);
+		swap_pop(_phase, index_); swap_pop(_fps, index_);
+		swap_pop(_first, index_); swap_pop(_count, index_);
+		swap_pop(_tint, index_); swap_pop(_layer, index_);
+	}
+
+	void SpriteSystem::clear()
+	{
+		_x.clear(); _y.clear();
+		_vx.clear(); _vy.clear();
+		_phase.clear(); _fps.clear();
+		_first.clear(); _count.clear();
+		_tint.clear(); _layer.clear();
+	}
+
+	void SpriteSystem::reserve(size_t count_)
+	{
+		_x.reserve(count_); _y.reserve(count_);
+		_vx.reserve(count_); _vy.reserve(count_);
+		_phase.reserve(count_); _fps.reserve(count_);
+		_first.reserve(count_); _count.reserve(count_);
+		_tint.reserve(count_); _layer.reserve(count_);
+	}
+
+	void SpriteSystem::update_range(size_t begin_, size_t end_, float dt_)
+	{
+		float* __restrict x = _x.data();
+		float* __restrict y = _y.data();
+		const float* __restrict vx = _vx.data();
+		const float* __restrict vy = _vy.data();
+		float* __restrict phase = _phase.data();
+		const float* __restrict fps = _fps.data();
+		const uint16_t* __restrict count = _count.data();
+
+		// separate simple loops so each one vectorizes
+		for (size_t ii = begin_; ii < end_; ++ii)
+			x[ii] += vx[ii] * dt_;
+		for (size_t ii = begin_; ii < end_; ++ii)
+			y[ii] += vy[ii] * dt_;
+		for (size_t ii = begin_; ii < end_; ++ii)
+			phase[ii] = wrap(phase[ii] + fps[ii] * dt_, float(count[ii]));
+
+		if (_wrap._width > 0 && _wrap._height > 0) {
+			const float x0 = float(_wrap._x), w = float(_wrap._width);
+			const float y0 = float(_wrap._y), h = float(_wrap._height);
+			for (size_t ii = begin_; ii < end_; ++ii)
+				x[ii] = x0 + wrap(x[ii] - x0, w);
+			for (size_t ii = begin_; ii < end_; ++ii)
+				y[ii] = y0 + wrap(y[ii] - y0, h);
+		}
+	}
+
+	void SpriteSystem::update(float dt_, worker_pool* pool_)
+	{
+		const size_t count = size();
+		const size_t tasks = (count + UPDATE_TASK_SPRITES - 1) / UPDATE_TASK_SPRITES;
+		if (!pool_ || tasks < 2 || pool_->concurrency() < 2) {
+			update_range(0, count, dt_);
+			return;
+		}
+		pool_->run(tasks, [this, count, dt_](size_t task_) {
+			const size_t begin = task_ * UPDATE_TASK_SPRITES;
+			update_range(begin, std::min(begin + UPDATE_TASK_SPRITES, count), dt_);
+		});
+	}
+
+	void SpriteSystem::render(Renderer& renderer_, int offset_x_, int offset_y_)
+	{
+		_drawn = 0;
+		const size_t count = size();
+		if (!count)
+			return;
+
+		Rect atlas;
+		_atlas->fill_bounding_rect(renderer_, atlas);
+		const int columns = std::max(atlas._width / _frame_width, 1);
+
+		// transform (camera included) and cull once, count sprites per layer:
+		size_t per_layer[LAYERS] = { 0 };
+		_order.clear();
+		_placed.clear();
+		for (size_t ii = 0; ii < count; ++ii) {
+			Rect dst(int(_x[ii]) + offset_x_, int(_y[ii]) + offset_y_, _frame_width, _frame_height);
+			if (!renderer_.place(dst))
+				continue;
+			_order.push_back(static_cast<uint32_t>(ii));
+			_placed.push_back(dst);
+			++per_layer[_layer[ii]];
+		}
+		if (_order.empty()) {
+			renderer_.render_batch_placed(_atlas, nullptr, nullptr, nullptr, 0, count);
+			return;
+		}
+
+		// counting sort by layer, stable so sprites of a layer keep their index order:
+		size_t start = 0;
+		for (int ll = 0; ll < LAYERS; ++ll) {
+			const size_t cnt = per_layer[ll];
+			per_layer[ll] = start;
+			start += cnt;
+		}
+		_src.resize(_order.size());
+		_dst.resize(_order.size());
+		_tints.resize(_order.size());
+		for (size_t kk = 0; kk < _order.size(); ++kk) {
+			const uint32_t ii = _order[kk];
+			const size_t slot = per_layer[_layer[ii]]++;
+			const int frame = _first[ii] + std::min(int(_phase[ii]), _count[ii] - 1);
+			_src[slot] = Rect((frame % columns) * _frame_width, (frame / columns) * _frame_height, _frame_width, _frame_height);
+			_dst[slot] = _placed[kk];
+			_tints[slot] = _tint[ii];
+		}
+
+		renderer_.render_batch_placed(_atlas, _src.data(), _dst.data(), _tints.data(), _order.size(), count - _order.size());
+		_drawn = _order.size();
+	}
+
+}
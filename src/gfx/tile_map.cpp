@@ -0,0 +1,205 @@
+#include <sally/gfx/tile_map.hpp>
+#include <SDL.h>
+#include <algorithm>
+
+namespace sally {
+
+	namespace {
+		// floor division, scroll positions may be negative
+		inline int floor_div(int a_, int b_) { return a_ >= 0 ? a_ / b_ : -((-a_ + b_ - 1) / b_); }
+	}
+
+	TileMap::TileMap(int width_, int height_, int tile_width_, int tile_height_, Renderable* tileset_)
+		: _width(std::max(width_, 0)), _height(std::max(height_, 0)),
+		  _tile_width(tile_width_), _tile_height(tile_height_),
+		  _chunks_x((_width + CHUNK_SIZE - 1) / CHUNK_SIZE), _chunks_y((_height + CHUNK_SIZE - 1) / CHUNK_SIZE),
+		  _tileset(tileset_), _chunks(size_t(_chunks_x) * _chunks_y), _cache_limit(0)
+	{
+		if (_tile_width <= 0 || _tile_height <= 0)
+			throw general_exception("TileMap tile size must be positive");
+	}
+
+	TileMap::TileMap(int width_, int height_, int tile_width_, int tile_height_, const std::vector<Color>& colors_)
+		: _width(std::max(width_, 0)), _height(std::max(height_, 0)),
+		  _tile_width(tile_width_), _tile_height(tile_height_),
+		  _chunks_x((_width + CHUNK_SIZE - 1) / CHUNK_SIZE), _chunks_y((_height + CHUNK_SIZE - 1) / CHUNK_SIZE),
+		  _tileset(nullptr), _colors(colors_), _chunks(size_t(_chunks_x) * _chunks_y), _cache_limit(0)
+	{
+		if (_tile_width <= 0 || _tile_height <= 0)
+			throw general_exception("TileMap tile size must be positive");
+	}
+
+	TileMap::~TileMap()
+	{
+	}
+
+	auto TileMap::get(int x_, int y_) const -> tile_t
+	{
+		if (x_ < 0 || y_ < 0 || x_ >= _width || y_ >= _height)
+			return EMPTY_TILE;
+		const Chunk* chunk = chunk_at(x_ / CHUNK_SIZE, y_ / CHUNK_SIZE);
+		return chunk ? chunk->_tiles[(y_ % CHUNK_SIZE) * CHUNK_SIZE + x_ % CHUNK_SIZE] : EMPTY_TILE;
+	}
+
+	void TileMap::set(int x_, int y_, tile_t tile_)
+	{
+		if (x_ < 0 || y_ < 0 || x_ >= _width || y_ >= _height)
+			return;
+
+		const int cx = x_ / CHUNK_SIZE, cy = y_ / CHUNK_SIZE;
+		unique_ptr<Chunk>& chunk = _chunks[size_t(cy) * _chunks_x + cx];
+		if (!chunk) {
+			if (tile_ == EMPTY_TILE)
+				return; // still all empty
+			chunk.reset(new Chunk());
+			std::fill(chunk->_tiles, chunk->_tiles + CHUNK_SIZE * CHUNK_SIZE, EMPTY_TILE);
+			chunk->_dirty = true;
+			chunk->_last_drawn = 0;
+			chunk->_cx = cx;
+			chunk->_cy = cy;
+			++_stats._allocated_chunks;
+			_stats._tile_bytes += sizeof(Chunk);
+		}
+
+		tile_t& tile = chunk->_tiles[(y_ % CHUNK_SIZE) * CHUNK_SIZE + x_ % CHUNK_SIZE];
+		if (tile != tile_) {
+			tile = tile_;
+			chunk->_dirty = true;
+		}
+	}
+
+	void TileMap::fill(const Rect& tiles_, tile_t tile_)
+	{
+		for (int y = tiles_._y; y < tiles_._y + tiles_._height; ++y)
+			for (int x = tiles_._x; x < tiles_._x + tiles_._width; ++x)
+				set(x, y, tile_);
+	}
+
+	void TileMap::render(Renderer& renderer_, const Rect& dst_, int scroll_x_, int scroll_y_)
+	{
+		if (dst_._width <= 0 || dst_._height <= 0)
+			return;
+
+		const int chunk_w = CHUNK_SIZE * _tile_width, chunk_h = CHUNK_SIZE * _tile_height;
+		const int cx0 = std::max(floor_div(scroll_x_, chunk_w), 0);
+		const int cy0 = std::max(floor_div(scroll_y_, chunk_h), 0);
+		const int cx1 = std::min(floor_div(scroll_x_ + dst_._width - 1, chunk_w), _chunks_x - 1);
+		const int cy1 = std::min(floor_div(scroll_y_ + dst_._height - 1, chunk_h), _chunks_y - 1);
+		if (cx0 > cx1 || cy0 > cy1)
+			return;
+
+		// without render targets (i.e. the software rasterizer) visible tiles are drawn directly:
+		const bool bake_chunks = renderer_.supports_render_targets();
+		const uint64_t frame = renderer_.frame();
+
+		for (int cy = cy0; cy <= cy1; ++cy)
+			for (int cx = cx0; cx <= cx1; ++cx) {
+				Chunk* chunk = chunk_at(cx, cy);
+				if (!chunk)
+					continue;
+
+				// visible part of the chunk in chunk pixels:
+				const int px = cx * chunk_w, py = cy * chunk_h;
+				int x0 = std::max(scroll_x_, px), y0 = std::max(scroll_y_, py);
+				int x1 = std::min(scroll_x_ + dst_._width, px + chunk_w), y1 = std::min(scroll_y_ + dst_._height, py + chunk_h);
+				Rect visible(x0 - px, y0 - py, x1 - x0, y1 - y0);
+				const int dx = dst_._x + x0 - scroll_x_, dy = dst_._y + y0 - scroll_y_;
+
+				if (bake_chunks) {
+					if (chunk->_dirty || !chunk->_baked)
+						bake(renderer_, *chunk);
+					renderer_.render(chunk->_baked.get(), Rect(dx, dy, visible._width, visible._height), &visible);
+				}
+				else
+					draw_tiles(renderer_, *chunk, dx - visible._x, dy - visible._y, &visible);
+				chunk->_last_drawn = frame;
+				++_stats._chunks_drawn;
+			}
+
+		if (bake_chunks)
+			trim_cache(frame, size_t(cx1 - cx0 + 1) * (cy1 - cy0 + 1));
+	}
+
+	void TileMap::bake(Renderer& renderer_, Chunk& chunk_)
+	{
+		if (!chunk_._baked) {
+			chunk_._baked.reset(new Texture(renderer_.create_target_texture(CHUNK_SIZE * _tile_width, CHUNK_SIZE * _tile_height)));
+			_baked.push_back(&chunk_);
+			++_stats._baked_chunks;
+			_stats._texture_bytes += chunk_._baked->texture_bytes();
+		}
+
+		SDL_Texture* prev_target = renderer_.render_target();
+		renderer_.set_render_target(chunk_._baked->texture_for_render(renderer_));
+		renderer_.clear(Color(0, 0, 0, 0));
+		draw_tiles(renderer_, chunk_, 0, 0, nullptr);
+		renderer_.set_render_target(prev_target);
+
+		chunk_._dirty = false;
+		++_stats._bakes;
+	}
+
+	void TileMap::draw_tiles(Renderer& renderer_, const Chunk& chunk_, int x0_, int y0_, const Rect* only_)
+	{
+		// only_ limits drawing to tiles intersecting a rect in chunk pixels:
+		int tx0 = 0, ty0 = 0, tx1 = CHUNK_SIZE, ty1 = CHUNK_SIZE;
+		if (only_) {
+			tx0 = only_->_x / _tile_width;
+			ty0 = only_->_y / _tile_height;
+			tx1 = std::min((only_->_x + only_->_width + _tile_width - 1) / _tile_width, CHUNK_SIZE);
+			ty1 = std::min((only_->_y + only_->_height + _tile_height - 1) / _tile_height, CHUNK_SIZE);
+		}
+		// the last chunk in each direction may extend beyond the map:
+		tx1 = std::min(tx1, _width - chunk_._cx * CHUNK_SIZE);
+		ty1 = std::min(ty1, _height - chunk_._cy * CHUNK_SIZE);
+
+		for (int ty = ty0; ty < ty1; ++ty)
+			for (int tx = tx0; tx < tx1; ++tx) {
+				tile_t tile = chunk_._tiles[ty * CHUNK_SIZE + tx];
+				if (tile != EMPTY_TILE)
+					draw_tile(renderer_, tile, Rect(x0_ + tx * _tile_width, y0_ + ty * _tile_height, _tile_width, _tile_height));
+			}
+	}
+
+	void TileMap::draw_tile(Renderer& renderer_, tile_t tile_, const Rect& dst_)
+	{
+		if (!_tileset) {
+			if (tile_ > _colors.size())
+				return;
+			Color prev = renderer_.draw_color();
+			renderer_.draw_color(_colors[tile_ - 1]);
+			renderer_.fill_rect(dst_);
+			renderer_.draw_color(prev);
+			return;
+		}
+
+		Rect atlas;
+		_tileset->fill_bounding_rect(renderer_, atlas);
+		const int columns = std::max(atlas._width / _tile_width, 1);
+		Rect cell(((tile_ - 1) % columns) * _tile_width, ((tile_ - 1) / columns) * _tile_height, _tile_width, _tile_height);
+		renderer_.render(_tileset, dst_, &cell);
+	}
+
+	void TileMap::release_baked(Chunk& chunk_)
+	{
+		_stats._texture_bytes -= chunk_._baked->texture_bytes();
+		--_stats._baked_chunks;
+		chunk_._baked.reset();
+		chunk_._dirty = true;
+	}
+
+	void TileMap::trim_cache(uint64_t frame_, size_t visible_)
+	{
+		const size_t limit = _cache_limit ? _cache_limit : 2 * visible_;
+		if (_baked.size() <= limit)
+			return;
+
+		// least recently drawn first, chunks drawn this frame are never released:
+		std::sort(_baked.begin(), _baked.end(), [](const Chunk* a_, const Chunk* b_) { return a_->_last_drawn < b_->_last_drawn; });
+		size_t excess = _baked.size() - limit, released = 0;
+		while (released < excess && _baked[released]->_last_drawn < frame_)
+			release_baked(*_baked[released++]);
+		_baked.erase(_baked.begin(), _baked.begin() + released);
+	}
+
+}
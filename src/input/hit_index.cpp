@@ -0,0 +1,192 @@
+#include <sally/input/hit_index.hpp>
+#include <algorithm>
+
+namespace sally {
+
+	HitIndex::HitIndex(int cell_size_)
+		: _cell_size(cell_size_ > 0 ? cell_size_ : DEFAULT_CELL_SIZE), _seq(0)
+	{}
+
+	int HitIndex::cell_of(int v_) const
+	{
+		// floor division, objects may be partially off screen
+		return v_ >= 0 ? v_ / _cell_size : -((-v_ + _cell_size - 1) / _cell_size);
+	}
+
+	void HitIndex::erase_slot(std::vector<slot_t>& slots_, slot_t slot_)
+	{
+		auto it = std::find(slots_.begin(), slots_.end(), slot_);
+		if (it != slots_.end()) {
+			*it = slots_.back();
+			slots_.pop_back();
+		}
+	}
+
+	void HitIndex::link(slot_t slot_)
+	{
+		Entry& e = _entries[slot_];
+		if (e._cx1 < e._cx0) {
+			_large.push_back(slot_);
+			return;
+		}
+		for (int cy = e._cy0; cy <= e._cy1; ++cy)
+			for (int cx = e._cx0; cx <= e._cx1; ++cx)
+				_cells[cell_key(cx, cy)].push_back(slot_);
+	}
+
+	void HitIndex::unlink(slot_t slot_)
+	{
+		const Entry& e = _entries[slot_];
+		if (e._cx1 < e._cx0) {
+			erase_slot(_large, slot_);
+			return;
+		}
+		for (int cy = e._cy0; cy <= e._cy1; ++cy)
+			for (int cx = e._cx0; cx <= e._cx1; ++cx) {
+				auto it = _cells.find(cell_key(cx, cy));
+				if (it == _cells.end())
+					continue;
+				erase_slot(it->second, slot_);
+				if (it->second.empty())
+					_cells.erase(it);
+			}
+	}
+
+	void HitIndex::update(object_t obj_, const Rect& rect_, int z_)
+	{
+		if (!obj_)
+			return;
+
+		int cx0 = cell_of(rect_._x), cy0 = cell_of(rect_._y);
+		int cx1 = cell_of(rect_._x + std::max(rect_._width, 1) - 1);
+		int cy1 = cell_of(rect_._y + std::max(rect_._height, 1) - 1);
+		if (int64_t(cx1 - cx0 + 1) * (cy1 - cy0 + 1) > MAX_OBJECT_CELLS)
+			cx1 = cx0 - 1; // large object
+
+		spinlock::Guard lg(_lock);
+		auto found = _slots.find(obj_);
+		if (found != _slots.end()) {
+			Entry& e = _entries[found->second];
+			e._rect = rect_;
+			e._z = z_;
+			if (e._cx0 == cx0 && e._cy0 == cy0 && e._cx1 == cx1 && e._cy1 == cy1)
+				return; // moved within the same cells
+			unlink(found->second);
+			e._cx0 = cx0; e._cy0 = cy0; e._cx1 = cx1; e._cy1 = cy1;
+			link(found->second);
+			return;
+		}
+
+		slot_t slot;
+		if (!_free.empty()) {
+			slot = _free.back();
+			_free.pop_back();
+		}
+		else {
+			slot = static_cast<slot_t>(_entries.size());
+			_entries.emplace_back();
+		}
+		Entry& e = _entries[slot];
+		e._obj = obj_;
+		e._rect = rect_;
+		e._z = z_;
+		e._seq = ++_seq;
+		e._cx0 = cx0; e._cy0 = cy0; e._cx1 = cx1; e._cy1 = cy1;
+		_slots[obj_] = slot;
+		link(slot);
+	}
+
+	void HitIndex::remove(object_t obj_)
+	{
+		spinlock::Guard lg(_lock);
+		auto found = _slots.find(obj_);
+		if (found == _slots.end())
+			return;
+		slot_t slot = found->second;
+		unlink(slot);
+		_entries[slot]._obj = nullptr;
+		_free.push_back(slot);
+		_slots.erase(found);
+	}
+
+	void HitIndex::clear()
+	{
+		spinlock::Guard lg(_lock);
+		_entries.clear();
+		_free.clear();
+		_slots.clear();
+		_cells.clear();
+		_large.clear();
+	}
+
+	bool HitIndex::contains(object_t obj_) const
+	{
+		spinlock::Guard lg(_lock);
+		return _slots.find(obj_) != _slots.end();
+	}
+
+	size_t HitIndex::size() const
+	{
+		spinlock::Guard lg(_lock);
+		return _slots.size();
+	}
+
+	HitIndex::object_t HitIndex::pick(int x_, int y_) const
+	{
+		spinlock::Guard lg(_lock);
+		const Entry* best = nullptr;
+		auto consider = [&](slot_t slot_) {
+			const Entry& e = _entries[slot_];
+			if (rect_contains(e._rect, x_, y_) && (!best || above(e, *best)))
+				best = &e;
+		};
+
+		auto it = _cells.find(cell_key(cell_of(x_), cell_of(y_)));
+		if (it != _cells.end())
+			for (slot_t slot : it->second)
+				consider(slot);
+		for (slot_t slot : _large)
+			consider(slot);
+		return best ? best->_obj : nullptr;
+	}
+
+	void HitIndex::query(const Rect& rect_, std::vector<object_t>& out_) const
+	{
+		if (rect_._width <= 0 || rect_._height <= 0)
+			return;
+
+		auto intersects = [&](const Rect& r_) {
+			return r_._x < rect_._x + rect_._width && rect_._x < r_._x + r_._width
+				&& r_._y < rect_._y + rect_._height && rect_._y < r_._y + r_._height;
+		};
+
+		const int qx0 = cell_of(rect_._x), qy0 = cell_of(rect_._y);
+		const int qx1 = cell_of(rect_._x + rect_._width - 1), qy1 = cell_of(rect_._y + rect_._height - 1);
+
+		spinlock::Guard lg(_lock);
+		if (int64_t(qx1 - qx0 + 1) * (qy1 - qy0 + 1) >= int64_t(_cells.size())) {
+			// query covers more cells than are occupied, scanning the objects is cheaper
+			for (const Entry& e : _entries)
+				if (e._obj && intersects(e._rect))
+					out_.push_back(e._obj);
+			return;
+		}
+
+		for (int cy = qy0; cy <= qy1; ++cy)
+			for (int cx = qx0; cx <= qx1; ++cx) {
+				auto it = _cells.find(cell_key(cx, cy));
+				if (it == _cells.end())
+					continue;
+				for (slot_t slot : it->second) {
+					const Entry& e = _entries[slot];
+					// objects spanning several cells are only reported from the first cell shared with the query
+					if (cx == std::max(e._cx0, qx0) && cy == std::max(e._cy0, qy0) && intersects(e._rect))
+						out_.push_back(e._obj);
+				}
+			}
+		for (slot_t slot : _large)
+			if (intersects(_entries[slot]._rect))
+				out_.push_back(_entries[slot]._obj);
+	}
+
+}
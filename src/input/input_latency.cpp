@@ -0,0 +1,114 @@
+#include <sally/input/input_latency.hpp>
+#include <sally/util/logger.hpp>
+#include <SDL_timer.h>
+
+namespace sally {
+
+	InputLatency::InputLatency()
+		: _in_event(false), _probe_count(0), _unclaimed(0), _event_start(0), _frequency(SDL_GetPerformanceFrequency()), _unseen(0)
+	{}
+
+	// static
+	const char* InputLatency::stage_name(stage_t stage_)
+	{
+		static const char* names[STAGES] = { "queue", "handler", "step", "render", "present", "total" };
+		return names[stage_];
+	}
+
+	void InputLatency::reset()
+	{
+		for (histogram& hist : _stages)
+			hist.reset();
+		_unseen = 0;
+	}
+
+	void InputLatency::log_summary() const
+	{
+		auto msg = logi();
+		msg << "input latency (us) over " << _stages[STAGE_TOTAL].count() << " events, " << _unseen << " without visible effect:";
+		for (int ss = 0; ss < STAGES; ++ss) {
+			const histogram& hist = _stages[ss];
+			msg << "\n  " << stage_name(static_cast<stage_t>(ss)) << " p50 " << hist.percentile(50)
+				<< " p90 " << hist.percentile(90) << " p99 " << hist.percentile(99) << " max " << hist.max();
+		}
+	}
+
+	void InputLatency::event_begin(ticks_t timestamp_)
+	{
+		const ticks_t now = clock_tick();
+		_current._queue_us = now > timestamp_ ? (now - timestamp_) * 1000 : 0;
+		_current._window = 0;
+		_in_event = true;
+		_event_start = SDL_GetPerformanceCounter();
+	}
+
+	void InputLatency::event_end()
+	{
+		_in_event = false;
+		if (_probe_count == MAX_PENDING) {
+			++_unseen;
+			return;
+		}
+		_current._handled_at = SDL_GetPerformanceCounter();
+		_current._handler_us = static_cast<uint32_t>(to_us(_current._handled_at - _event_start));
+		_probes[_probe_count++] = _current;
+		if (!_current._window)
+			++_unclaimed;
+	}
+
+	void InputLatency::invalidated(unsigned int window_id_)
+	{
+		if (_in_event && !_current._window)
+			_current._window = window_id_;
+		if (!_unclaimed)
+			return;
+		for (int ii = 0; ii < _probe_count; ++ii)
+			if (!_probes[ii]._window)
+				_probes[ii]._window = window_id_;
+		_unclaimed = 0;
+	}
+
+	void InputLatency::presented(unsigned int window_id_, uint64_t render_start_, uint64_t present_ticks_)
+	{
+		if (!_probe_count)
+			return;
+		const uint64_t end = SDL_GetPerformanceCounter();
+		const uint64_t present_us = to_us(present_ticks_);
+		const uint64_t draw_us = to_us(end - render_start_);
+		const uint64_t render_us = draw_us > present_us ? draw_us - present_us : 0;
+		for (int ii = 0; ii < _probe_count; ) {
+			const Probe& probe = _probes[ii];
+			// handled after drawing began (a handler rendering directly), the next present shows it
+			if (probe._window != window_id_ || probe._handled_at > render_start_) {
+				++ii;
+				continue;
+			}
+			const uint64_t step_us = to_us(render_start_ - probe._handled_at);
+			_stages[STAGE_QUEUE].record(probe._queue_us);
+			_stages[STAGE_HANDLER].record(probe._handler_us);
+			_stages[STAGE_STEP].record(step_us);
+			_stages[STAGE_RENDER].record(render_us);
+			_stages[STAGE_PRESENT].record(present_us);
+			_stages[STAGE_TOTAL].record(probe._queue_us + probe._handler_us + step_us + draw_us);
+			remove(ii);
+		}
+	}
+
+	void InputLatency::expire()
+	{
+		if (!_probe_count)
+			return;
+		const uint64_t oldest = SDL_GetPerformanceCounter() - _frequency * EXPIRE_MS / 1000;
+		for (int ii = 0; ii < _probe_count; ) {
+			if (static_cast<int64_t>(_probes[ii]._handled_at - oldest) >= 0) {
+				++ii;
+				continue;
+			}
+			if (!_probes[ii]._window)
+				--_unclaimed;
+			++_unseen;
+			remove(ii);
+		}
+	}
+
+}
@@ -0,0 +1,282 @@
+#include <sally/net/rollback.hpp>
+#include <sally/util/logger.hpp>
+#include <SDL_timer.h>
+#include <algorithm>
+#include <cstddef>
+
+namespace sally {
+
+	// one datagram per tick and direction carrying every local input the other side has not
+	// acknowledged yet, so a lost packet is repaired by the next one without resending.
+	// fields are in host byte order, both peers are expected to share the endianness.
+	struct RollbackSession::Packet {
+		static const uint32_t MAGIC = 0x31425253; // "SRB1"
+
+		uint32_t _magic;
+		uint8_t _player;       // sender
+		uint8_t _pad;
+		uint16_t _count;       // inputs following the header
+		int32_t _first;        // frame of _inputs[0]
+		int32_t _ack;          // last frame of the receiver's inputs the sender has
+		int32_t _frame;        // sender's next frame
+		int32_t _advantage;    // sender's frame minus the receiver's frame as the sender sees it
+		int32_t _sync_frame;   // frame of _checksum, -1 for none
+		uint32_t _checksum;    // of the sender's confirmed state before _sync_frame
+		input_t _inputs[MAX_INPUTS_PER_PACKET];
+
+		static size_t header_bytes() { return offsetof(Packet, _inputs); }
+	};
+
+	RollbackSession::RollbackSession(RollbackGame& game_, const Config& config_)
+		: _game(game_), _config(config_), _socket(config_.local_port), _state_size(game_.state_size()),
+		  _pending(0), _frame(0), _remote_confirmed(-1), _remote_ack(-1), _remote_frame(0), _remote_advantage(0),
+		  _rollback_to(-1), _remote_sync_frame(-1), _remote_checksum(0), _sync_cooldown(0), _next_tick(clock_tick()),
+		  _drop_state(0x9e3779b9u + config_.local_player), _attached(false), _prev_step(nullptr), _prev_keyboard(nullptr),
+		  _rollbacks(0), _rollback_frames_total(0), _stalls(0), _bytes_sent(0), _bytes_received(0), _desyncs(0)
+	{
+		if (_config.local_player != 0 && _config.local_player != 1)
+			throw general_exception("RollbackSession: local_player must be 0 or 1");
+		if (_config.max_prediction < 1 || _config.max_prediction > MAX_PREDICTION)
+			throw general_exception("RollbackSession: max_prediction out of range");
+		if (_config.tick_ms < 1 || _config.remote._port == 0 || _state_size == 0)
+			throw general_exception("RollbackSession: invalid configuration");
+
+		_snapshots.resize(FRAME_RING * _state_size);
+		std::fill(_local, _local + FRAME_RING, input_t(0));
+		std::fill(_remote, _remote + FRAME_RING, input_t(0));
+
+		metrics_registry& metrics = System::metrics();
+		_bytes_sent_counter = &metrics.add_counter("sally_net_bytes_sent_total", "rollback session UDP payload sent");
+		_bytes_received_counter = &metrics.add_counter("sally_net_bytes_received_total", "rollback session UDP payload received");
+		_rollback_frames_counter = &metrics.add_counter("sally_net_rollback_frames_total", "ticks re-simulated after mispredicted remote input");
+		_stalls_counter = &metrics.add_counter("sally_net_stalls_total", "ticks waited for the remote player");
+		_resim_gauge = &metrics.add_gauge("sally_net_resim_us", "time the last tick spent restoring and re-simulating");
+	}
+
+	RollbackSession::~RollbackSession()
+	{
+		detach();
+	}
+
+	void RollbackSession::attach()
+	{
+		if (_attached)
+			return;
+		_prev_step = System::set_step_event_handler(this);
+		_prev_keyboard = System::set_keyboard_event_handler(this);
+		_next_tick = clock_tick();
+		_attached = true;
+	}
+
+	void RollbackSession::detach()
+	{
+		if (!_attached)
+			return;
+		System::set_step_event_handler(_prev_step);
+		System::set_keyboard_event_handler(_prev_keyboard);
+		_attached = false;
+	}
+
+	void RollbackSession::on_step_event()
+	{
+		const int MAX_CATCH_UP = 4;
+		int ticks = 0;
+		ticks_t now = clock_tick();
+		while (static_cast<int32_t>(now - _next_tick) >= 0 && ticks < MAX_CATCH_UP) {
+			tick();
+			_next_tick += _config.tick_ms;
+			++ticks;
+		}
+		if (static_cast<int32_t>(now - _next_tick) >= 0)
+			_next_tick = now + _config.tick_ms; // too far behind (i.e. a breakpoint), drop the backlog
+
+		// time sync: both sides see the other one latency ticks behind, the difference of the two
+		// views is twice how far this side really runs ahead. waiting a tick lets the other side
+		// catch up instead of this one predicting (and rolling back) all the time.
+		if (_sync_cooldown > 0)
+			_sync_cooldown -= ticks;
+		else if (connected() && (_frame - _remote_frame) - _remote_advantage >= 2) {
+			_next_tick += _config.tick_ms;
+			_sync_cooldown = 30;
+		}
+		if (ticks)
+			_game.on_state_changed();
+	}
+
+	int RollbackSession::next_step_in_ms()
+	{
+		const int32_t due = static_cast<int32_t>(_next_tick - clock_tick());
+		return due > 0 ? due : 0;
+	}
+
+	void RollbackSession::on_key_event(const keyboard_event& event_, Window* win_)
+	{
+		_pending = _game.on_local_key(event_, _pending);
+		if (_prev_keyboard)
+			_prev_keyboard->on_key_event(event_, win_);
+	}
+
+	void RollbackSession::tick()
+	{
+		poll();
+		if (_rollback_to >= 0)
+			rollback();
+
+		if (_remote_sync_frame >= 0 && _remote_sync_frame < _frame && _remote_sync_frame <= _remote_confirmed + 1) {
+			if (_remote_sync_frame > _frame - FRAME_RING && checksum(_remote_sync_frame) != _remote_checksum) {
+				if (!_desyncs)
+					logw() << "rollback session desynchronized at frame " << _remote_sync_frame << ", the game is not deterministic";
+				++_desyncs;
+			}
+			_remote_sync_frame = -1;
+		}
+
+		if (_frame - _remote_confirmed > _config.max_prediction) {
+			// too far ahead of the remote player, the oldest snapshot needed would be lost
+			_current.stalled = true;
+			++_stalls;
+			_stalls_counter->add();
+		}
+		else {
+			_local[slot(_frame)] = _pending;
+			_pending = 0;
+			if (_frame > _remote_confirmed)
+				_remote[slot(_frame)] = _game.predict(_remote_confirmed >= 0 ? _remote[slot(_remote_confirmed)] : input_t(0));
+			simulate(_frame);
+			++_frame;
+		}
+		send();
+		finish_frame();
+	}
+
+	void RollbackSession::poll()
+	{
+		Packet packet;
+		NetAddress from;
+		int bytes;
+		while ((bytes = _socket.receive(&packet, sizeof(packet), &from)) >= 0) {
+			if (from != _config.remote)
+				continue;
+			_current.bytes_received += bytes;
+			_bytes_received += bytes;
+			_bytes_received_counter->add(bytes);
+			receive(packet, bytes);
+		}
+	}
+
+	void RollbackSession::receive(const Packet& packet_, int bytes_)
+	{
+		if (bytes_ < static_cast<int>(Packet::header_bytes()) || packet_._magic != Packet::MAGIC || packet_._player != 1 - _config.local_player
+			|| packet_._count > MAX_INPUTS_PER_PACKET || bytes_ < static_cast<int>(Packet::header_bytes() + packet_._count * sizeof(input_t)))
+			return;
+
+		_remote_ack = std::max(_remote_ack, packet_._ack);
+		if (packet_._frame >= _remote_frame) {
+			_remote_frame = packet_._frame;
+			_remote_advantage = packet_._advantage;
+		}
+		if (packet_._sync_frame >= 0 && packet_._sync_frame > _remote_sync_frame) {
+			_remote_sync_frame = packet_._sync_frame;
+			_remote_checksum = packet_._checksum;
+		}
+
+		for (int ii = 0; ii < packet_._count; ++ii) {
+			const int32_t frame = packet_._first + ii;
+			if (frame <= _remote_confirmed)
+				continue; // already have it
+			if (frame != _remote_confirmed + 1 || frame >= _frame + MAX_PREDICTION)
+				break; // a gap, or too far ahead for the ring: the sender repeats it
+			const input_t input = packet_._inputs[ii];
+			if (frame < _frame && _remote[slot(frame)] != input && (_rollback_to < 0 || frame < _rollback_to))
+				_rollback_to = frame;
+			_remote[slot(frame)] = input;
+			_remote_confirmed = frame;
+		}
+	}
+
+	void RollbackSession::rollback()
+	{
+		const Uint64 start = SDL_GetPerformanceCounter();
+		const int32_t from = _rollback_to;
+		_rollback_to = -1;
+		_game.load_state(snapshot(from));
+		const input_t last = _remote[slot(_remote_confirmed)];
+		for (int32_t frame = from; frame < _frame; ++frame) {
+			if (frame > _remote_confirmed)
+				_remote[slot(frame)] = _game.predict(last);
+			simulate(frame);
+		}
+		const double us = (SDL_GetPerformanceCounter() - start) * 1e6 / SDL_GetPerformanceFrequency();
+
+		const int frames = _frame - from;
+		_current.rollback_frames += frames;
+		_current.resim_us += us;
+		++_rollbacks;
+		_rollback_frames_total += frames;
+		_rollback_frames_counter->add(frames);
+		_resim_time.record(static_cast<uint64_t>(us));
+		_rollback_depth.record(frames);
+	}
+
+	void RollbackSession::simulate(int32_t frame_)
+	{
+		_game.save_state(snapshot(frame_));
+		const input_t local = _local[slot(frame_)], remote = _remote[slot(frame_)];
+		if (_config.local_player == 0)
+			_game.advance(local, remote);
+		else
+			_game.advance(remote, local);
+	}
+
+	// FNV-1a over the snapshot taken before frame_
+	uint32_t RollbackSession::checksum(int32_t frame_)
+	{
+		const uint8_t* data = snapshot(frame_);
+		uint32_t hash = 2166136261u;
+		for (size_t ii = 0; ii < _state_size; ++ii)
+			hash = (hash ^ data[ii]) * 16777619u;
+		return hash;
+	}
+
+	void RollbackSession::send()
+	{
+		Packet packet;
+		packet._magic = Packet::MAGIC;
+		packet._player = static_cast<uint8_t>(_config.local_player);
+		packet._pad = 0;
+		packet._first = std::max(_remote_ack + 1, _frame - MAX_INPUTS_PER_PACKET);
+		packet._count = static_cast<uint16_t>(std::max(_frame - packet._first, 0));
+		packet._ack = _remote_confirmed;
+		packet._frame = _frame;
+		packet._advantage = _frame - _remote_frame;
+		// the latest snapshot which no remote input can change any more
+		packet._sync_frame = std::min(_remote_confirmed + 1, _frame - 1);
+		packet._checksum = packet._sync_frame >= 0 ? checksum(packet._sync_frame) : 0;
+		for (int ii = 0; ii < packet._count; ++ii)
+			packet._inputs[ii] = _local[slot(packet._first + ii)];
+
+		if (_config.drop_percent > 0) {
+			_drop_state ^= _drop_state << 13;
+			_drop_state ^= _drop_state >> 17;
+			_drop_state ^= _drop_state << 5;
+			if (static_cast<int>(_drop_state % 100) < _config.drop_percent)
+				return;
+		}
+		const size_t bytes = Packet::header_bytes() + packet._count * sizeof(input_t);
+		if (!_socket.send_to(_config.remote, &packet, bytes))
+			return;
+		_current.bytes_sent += static_cast<int>(bytes);
+		_bytes_sent += bytes;
+		_bytes_sent_counter->add(bytes);
+	}
+
+	void RollbackSession::finish_frame()
+	{
+		_current.frame = _frame;
+		_current.predicted_frames = std::max(_frame - 1 - _remote_confirmed, 0);
+		_resim_gauge->set(static_cast<int64_t>(_current.resim_us));
+		_last = _current;
+		_current = FrameStats();
+	}
+
+}
@@ -0,0 +1,149 @@
+#include <sally/net/udp_socket.hpp>
+#include <string>
+
+#ifdef SALLY_WINDOWS
+# include <winsock2.h>
+# include <ws2tcpip.h>
+# ifdef _MSC_VER
+#  pragma comment(lib, "ws2_32.lib")
+# endif
+  typedef int socklen_t;
+#else
+# include <sys/socket.h>
+# include <netinet/in.h>
+# include <arpa/inet.h>
+# include <netdb.h>
+# include <fcntl.h>
+# include <unistd.h>
+# include <cerrno>
+#endif
+
+namespace sally {
+
+	namespace {
+
+#ifdef SALLY_WINDOWS
+		// winsock has to be started once per process before the first socket
+		struct winsock_init {
+			bool _ok;
+			winsock_init() { WSADATA data; _ok = WSAStartup(MAKEWORD(2, 2), &data) == 0; }
+			~winsock_init() { if (_ok) WSACleanup(); }
+		};
+
+		void close_socket(intptr_t fd_) { closesocket(static_cast<SOCKET>(fd_)); }
+#else
+		void close_socket(intptr_t fd_) { close(static_cast<int>(fd_)); }
+#endif
+
+		sockaddr_in to_sockaddr(const NetAddress& addr_) {
+			sockaddr_in sa;
+			memset(&sa, 0, sizeof(sa));
+			sa.sin_family = AF_INET;
+			sa.sin_addr.s_addr = htonl(addr_._host);
+			sa.sin_port = htons(addr_._port);
+			return sa;
+		}
+
+		void fail(const char* what_, intptr_t fd_) {
+			if (fd_ >= 0)
+				close_socket(fd_);
+			throw general_exception(what_);
+		}
+
+	}
+
+	// static
+	NetAddress NetAddress::resolve(const char* host_, uint16_t port_)
+	{
+#ifdef SALLY_WINDOWS
+		static winsock_init winsock;
+#endif
+		in_addr addr;
+		if (inet_pton(AF_INET, host_, &addr) == 1)
+			return NetAddress(ntohl(addr.s_addr), port_);
+
+		addrinfo hints;
+		memset(&hints, 0, sizeof(hints));
+		hints.ai_family = AF_INET;
+		hints.ai_socktype = SOCK_DGRAM;
+		addrinfo* res = nullptr;
+		if (getaddrinfo(host_, nullptr, &hints, &res) != 0 || !res)
+			throw general_exception((std::string("cannot resolve host ") + host_).c_str());
+		const uint32_t host = ntohl(reinterpret_cast<const sockaddr_in*>(res->ai_addr)->sin_addr.s_addr);
+		freeaddrinfo(res);
+		return NetAddress(host, port_);
+	}
+
+	UdpSocket::UdpSocket(uint16_t port_)
+		: _fd(-1), _port(port_)
+	{
+#ifdef SALLY_WINDOWS
+		static winsock_init winsock;
+		if (!winsock._ok)
+			throw general_exception("WSAStartup failed");
+		const SOCKET fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+		if (fd == INVALID_SOCKET)
+			fail("cannot create UDP socket", -1);
+		_fd = static_cast<intptr_t>(fd);
+		u_long nonblocking = 1;
+		if (ioctlsocket(fd, FIONBIO, &nonblocking) != 0)
+			fail("cannot make UDP socket non blocking", _fd);
+#else
+		const int fd = socket(AF_INET, SOCK_DGRAM, 0);
+		if (fd < 0)
+			fail("cannot create UDP socket", -1);
+		_fd = fd;
+		if (fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK) != 0)
+			fail("cannot make UDP socket non blocking", _fd);
+#endif
+		sockaddr_in local = to_sockaddr(NetAddress(INADDR_ANY, port_));
+		if (bind(fd, reinterpret_cast<sockaddr*>(&local), sizeof(local)) != 0)
+			fail((std::string("cannot bind UDP port ") + std::to_string(port_)).c_str(), _fd);
+		socklen_t len = sizeof(local);
+		if (getsockname(fd, reinterpret_cast<sockaddr*>(&local), &len) == 0)
+			_port = ntohs(local.sin_port);
+	}
+
+	UdpSocket::~UdpSocket()
+	{
+		close_socket(_fd);
+	}
+
+	bool UdpSocket::send_to(const NetAddress& to_, const void* data_, size_t bytes_)
+	{
+		const sockaddr_in sa = to_sockaddr(to_);
+#ifdef SALLY_WINDOWS
+		const int res = sendto(static_cast<SOCKET>(_fd), static_cast<const char*>(data_), static_cast<int>(bytes_), 0,
+			reinterpret_cast<const sockaddr*>(&sa), sizeof(sa));
+#else
+		const ssize_t res = sendto(static_cast<int>(_fd), data_, bytes_, 0, reinterpret_cast<const sockaddr*>(&sa), sizeof(sa));
+#endif
+		return res >= 0 && static_cast<size_t>(res) == bytes_;
+	}
+
+	int UdpSocket::receive(void* buf_, size_t capacity_, NetAddress* from_)
+	{
+		sockaddr_in sa;
+		socklen_t len = sizeof(sa);
+		for (;;) {
+#ifdef SALLY_WINDOWS
+			const int res = recvfrom(static_cast<SOCKET>(_fd), static_cast<char*>(buf_), static_cast<int>(capacity_), 0,
+				reinterpret_cast<sockaddr*>(&sa), &len);
+			if (res < 0 && WSAGetLastError() == WSAEMSGSIZE)
+				return static_cast<int>(capacity_); // truncated
+			if (res < 0 && WSAGetLastError() == WSAECONNRESET)
+				continue; // an earlier datagram found no listener, not an error for this one
+#else
+			const ssize_t res = recvfrom(static_cast<int>(_fd), buf_, capacity_, 0, reinterpret_cast<sockaddr*>(&sa), &len);
+			if (res < 0 && (errno == ECONNREFUSED || errno == EINTR))
+				continue; // refused is reported for an earlier datagram which found no listener
+#endif
+			if (res < 0)
+				return -1;
+			if (from_)
+				*from_ = NetAddress(ntohl(sa.sin_addr.s_addr), ntohs(sa.sin_port));
+			return static_cast<int>(res);
+		}
+	}
+
+}
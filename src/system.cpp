@@ -1,6 +1,7 @@
 #include <sally/system.hpp>
 #include <sally/util/logger.hpp>
 #include <sally/input/input_events.hpp>
+#include <sally/input/hit_index.hpp>
 #include <SDL.h>
 #include <SDL_image.h>
 #include <SDL_ttf.h>
@@ -13,6 +14,34 @@ namespace sally {
 	//static
 	FontManager System::_font_mgr;
 	//static
+	AssetManager System::_asset_mgr;
+	//static
+	frame_arena System::_arena;
+	//static
+	InputLatency System::_input_latency;
+	//static
+	metrics_registry System::_metrics;
+	//static
+	main_thread_queue System::_main_queue;
+	//static
+	AudioMixer System::_audio;
+#ifdef SALLY_COROUTINES
+	//static
+	coroutine_scheduler System::_coroutines;
+#endif
+	//static
+	SDL_threadID System::_main_thread = 0;
+	//static
+	bool System::_idle_mode = true;
+	//static
+	uint64_t System::_wakeups = 0;
+	//static
+	uint64_t System::_wakeups_at_last_rate = 0;
+	//static
+	ticks_t System::_last_rate_tick = 0;
+	//static
+	double System::_wakeups_per_second = 0;
+	//static
 	step_event_handler* System::_step_event_handler;
 	//static
 	keyboard_event_handler* System::_keyboard_event_handler;
@@ -30,9 +59,9 @@ namespace sally {
 
 	// we don't really support concurrent inits
 	// additionally, a full solution will allow having init guards on subsystems (i.e. video, audio, etc.)
-	System::InitGuard::InitGuard() {
+	System::InitGuard::InitGuard(bool headless_) {
 		if (SDL_AtomicIncRef(&system_init_count) == 0)
-			System::init();
+			System::init(headless_);
 	}
 
 	System::InitGuard::~InitGuard() {
@@ -40,11 +69,15 @@ namespace sally {
 			System::destroy();
 	}
 
-	void System::init() {
+	void System::init(bool headless_) {
 		bool sdl_inited = false, img_inited = false, ttf_inited = false;
 
 		try {
 			SDL_SetMainReady();
+			_main_thread = SDL_ThreadID();
+
+			if (headless_)
+				SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
 
 			if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS) != 0)
 				throw sdl_exception("SDL_Init failed");
@@ -74,7 +107,13 @@ namespace sally {
 	}
 
 	void System::destroy() {
+		_audio.close();
+		_main_queue.clear();
+#ifdef SALLY_COROUTINES
+		_coroutines.clear();
+#endif
 		font_manger().clear();
+		asset_manager().collect();
 		TTF_Quit();
 		IMG_Quit();
 		SDL_Quit();
@@ -170,14 +209,28 @@ namespace sally {
 		static const Uint32 MIN_FRAME_MS = 5; // if "drawing" a frame takes less than MIN_FRAME_MS millisecond we will delay
 		// notice this should only happend on frames which did not actually draw
 
+		histogram& frame_time = _metrics.add_histogram("sally_frame_time_us", "main loop work per frame (events, step, rendering) excluding waits");
+		gauge& queue_depth = _metrics.add_gauge("sally_event_queue_depth", "SDL events queued at the start of the last frame");
+		const Uint64 frequency = SDL_GetPerformanceFrequency();
+
 		logi() << "starting main event loop...";
 		bool quit = false;
 		while (!quit)
 		{
-			Uint32 frame_start_tick = SDL_GetTicks();
+			_arena.reset();
 
-			// first handle "real" events:
+			// first handle "real" events, when idle wait for the first one (or the next deadline):
 			SDL_Event ev;
+			const int timeout = _idle_mode ? idle_timeout() : 0;
+			if (timeout != 0) {
+				const int got_event = timeout < 0 ? SDL_WaitEvent(&ev) : SDL_WaitEventTimeout(&ev, timeout);
+				count_wakeup();
+				if (got_event)
+					quit = handle_event(ev);
+			}
+			Uint32 frame_start_tick = SDL_GetTicks();
+			const Uint64 frame_start = SDL_GetPerformanceCounter();
+			queue_depth.set(SDL_PeepEvents(nullptr, 0, SDL_PEEKEVENT, SDL_FIRSTEVENT, SDL_LASTEVENT));
 			while (!quit && SDL_PollEvent(&ev))
 				quit = handle_event(ev);
 
@@ -185,15 +238,66 @@ namespace sally {
 			if (!quit && _step_event_handler)
 				_step_event_handler->on_step_event();
 
+			// coroutines waiting for this frame or for a time which has passed
+#ifdef SALLY_COROUTINES
+			if (!quit)
+				_coroutines.run(clock_tick());
+#endif
+
+			// main thread only work (i.e. texture uploads) as far as this frame's budget allows
+			if (!quit)
+				_main_queue.drain();
+			_audio.update(); // releases sounds of finished voices
+
 			if (!quit) {
 				// finally draw whatever is needed:
 				_window_mgr.render_all_pending();
+				_input_latency.expire();
+				frame_time.record((SDL_GetPerformanceCounter() - frame_start) * 1000000 / frequency);
 
-				// if necessary delay until next frame:
-				while (SDL_GetTicks() - frame_start_tick < MIN_FRAME_MS)
-					SDL_Delay(1);
+				// if necessary delay until next frame, a frame which waited for its event already slept:
+				if (timeout == 0)
+					while (SDL_GetTicks() - frame_start_tick < MIN_FRAME_MS) {
+						SDL_Delay(1);
+						count_wakeup();
+					}
 			}
 		}
+		SDL_AtomicSet(&system_shutdown_pending, 0); // consumed, main_loop may be run again
+	}
+
+	// ms main_loop may block before the next frame: 0 if there is work now, -1 for until an event.
+	// other threads wake the loop with an event when they invalidate a window or post a task.
+	//static
+	int System::idle_timeout()
+	{
+		if (_window_mgr.render_pending() || _main_queue.pending())
+			return 0;
+		int timeout = _step_event_handler ? _step_event_handler->next_step_in_ms() : -1;
+#ifdef SALLY_COROUTINES
+		const int due = _coroutines.next_due_in(clock_tick());
+		if (due >= 0 && (timeout < 0 || due < timeout))
+			timeout = due;
+#endif
+		return timeout;
+	}
+
+	//static
+	void System::count_wakeup()
+	{
+		++_wakeups;
+		const ticks_t now = clock_tick();
+		if (now - _last_rate_tick >= 1000) {
+			_wakeups_per_second = (_wakeups - _wakeups_at_last_rate) * 1000.0 / (now - _last_rate_tick);
+			_wakeups_at_last_rate = _wakeups;
+			_last_rate_tick = now;
+		}
+	}
+
+	// topmost registered object under the mouse, if the window keeps a hit index
+	static void* pick(Window* win_, int x_, int y_) {
+		HitIndex* index = win_ ? win_->hit_index() : nullptr;
+		return index ? index->pick(x_, y_) : nullptr;
 	}
 
 	// static
@@ -220,6 +324,7 @@ namespace sally {
 			{
 			case SDL_KEYDOWN:
 			case SDL_KEYUP:
+				_input_latency.event_begin(ev_.key.timestamp);
 				if (_keyboard_event_handler)
 					_keyboard_event_handler->on_key_event(
 						keyboard_event(
@@ -232,37 +337,46 @@ namespace sally {
 						),
 						_window_mgr.window_by_id(ev_.key.windowID)
 					);
+				_input_latency.event_end();
 				break;
 			case SDL_MOUSEBUTTONDOWN:
 			case SDL_MOUSEBUTTONUP:
-				if (_mouse_button_event_handler)
+				_input_latency.event_begin(ev_.button.timestamp);
+				if (_mouse_button_event_handler) {
+					Window* win = _window_mgr.window_by_id(ev_.button.windowID);
 					_mouse_button_event_handler->on_mousebutton__event(
 						mouse_button_event(
 							static_cast<mouse_button_event::event_type>(ev_.type),
 							ev_.button.timestamp,
 							ev_.button.which,
 							static_cast<mouse_button_event::button_type>(ev_.button.button),
-							ev_.button.clicks
+							ev_.button.clicks,
+							pick(win, ev_.button.x, ev_.button.y)
 						),
-						_window_mgr.window_by_id(ev_.button.windowID),
+						win,
 						ev_.button.x,
 						ev_.button.y
 					);
+				}
+				_input_latency.event_end();
 				break;
 			case SDL_MOUSEMOTION:
-				if (_mouse_motion_event_handler)
+				if (_mouse_motion_event_handler) {
+					Window* win = _window_mgr.window_by_id(ev_.motion.windowID);
 					_mouse_motion_event_handler->on_mouse_motion_event(
 						mouse_motion_event(
 							ev_.motion.timestamp,
 							ev_.motion.which,
-							static_cast<mouse_motion_event::button_mask_type>(ev_.motion.state)
+							static_cast<mouse_motion_event::button_mask_type>(ev_.motion.state),
+							pick(win, ev_.motion.x, ev_.motion.y)
 						),
-						_window_mgr.window_by_id(ev_.motion.windowID),
+						win,
 						ev_.motion.x,
 						ev_.motion.y,
 						ev_.motion.xrel,
 						ev_.motion.yrel
 					);
+				}
 				break;
 			}
 		}
@@ -0,0 +1,108 @@
+#include <sally/util/coroutine_scheduler.hpp>
+
+#ifdef SALLY_COROUTINES
+
+#include <sally/util/threading.hpp>
+#include <new>
+
+namespace sally {
+
+	// Frame pool:
+
+	namespace {
+		const size_t FRAME_GRANULE = 64;  // size classes are multiples of this
+		const size_t FRAME_CLASSES = 32;  // pooled frames up to 2 KB
+		const size_t SLAB_BYTES = 64 * 1024;
+
+		struct free_frame {
+			free_frame* _next;
+		};
+
+		struct frame_pool {
+			spinlock _lock;
+			free_frame* _free[FRAME_CLASSES];
+
+			frame_pool() { memset(_free, 0, sizeof(_free)); }
+
+			static frame_pool& instance() {
+				static frame_pool pool;
+				return pool;
+			}
+
+			// _lock must be held
+			void refill(size_t class_) {
+				const size_t bytes = (class_ + 1) * FRAME_GRANULE;
+				const size_t count = SLAB_BYTES / bytes;
+				uint8_t* slab = static_cast<uint8_t*>(::operator new(count * bytes));
+				for (size_t ii = count; ii-- > 0; ) {
+					free_frame* frame = reinterpret_cast<free_frame*>(slab + ii * bytes);
+					frame->_next = _free[class_];
+					_free[class_] = frame;
+				}
+			}
+		};
+	}
+
+	void* coroutine_frame_alloc(size_t bytes_)
+	{
+		const size_t cls = (bytes_ + FRAME_GRANULE - 1) / FRAME_GRANULE - 1;
+		if (!bytes_ || cls >= FRAME_CLASSES)
+			return ::operator new(bytes_);
+		frame_pool& pool = frame_pool::instance();
+		spinlock::Guard lg(pool._lock);
+		if (!pool._free[cls])
+			pool.refill(cls);
+		free_frame* frame = pool._free[cls];
+		pool._free[cls] = frame->_next;
+		return frame;
+	}
+
+	void coroutine_frame_free(void* frame_, size_t bytes_)
+	{
+		const size_t cls = (bytes_ + FRAME_GRANULE - 1) / FRAME_GRANULE - 1;
+		if (!bytes_ || cls >= FRAME_CLASSES) {
+			::operator delete(frame_);
+			return;
+		}
+		frame_pool& pool = frame_pool::instance();
+		spinlock::Guard lg(pool._lock);
+		free_frame* frame = static_cast<free_frame*>(frame_);
+		frame->_next = pool._free[cls];
+		pool._free[cls] = frame;
+	}
+
+	// Scheduler:
+
+	size_t coroutine_scheduler::run(ticks_t now_)
+	{
+		_resuming.clear();
+		_resuming.swap(_next_frame);
+		while (!_timers.empty() && static_cast<int32_t>(_timers.top()._due - now_) <= 0) {
+			_resuming.push_back(_timers.top()._handle);
+			_timers.pop();
+		}
+		for (std::coroutine_handle<> handle : _resuming)
+			handle.resume();
+		return _resuming.size();
+	}
+
+	int coroutine_scheduler::next_due_in(ticks_t now_) const
+	{
+		if (!_next_frame.empty())
+			return 0;
+		if (_timers.empty())
+			return -1;
+		const int32_t due_in = static_cast<int32_t>(_timers.top()._due - now_); // clock_tick() wraps after 49 days
+		return due_in > 0 ? static_cast<int>(due_in) : 0;
+	}
+
+	void coroutine_scheduler::clear()
+	{
+		_next_frame.clear();
+		_resuming.clear();
+		_timers = decltype(_timers)();
+	}
+
+}
+
+#endif
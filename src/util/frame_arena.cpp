@@ -0,0 +1,69 @@
+#include <sally/util/frame_arena.hpp>
+#include <algorithm>
+
+namespace sally {
+
+	frame_arena::frame_arena(size_t block_size_)
+		: _block_size(std::max<size_t>(block_size_, 1024)), _current(0), _begin(nullptr), _top(nullptr), _end(nullptr),
+		  _used(0), _peak(0), _blocks_allocated(0)
+	{
+	}
+
+	void* frame_arena::allocate_slow(size_t bytes_, size_t align_)
+	{
+		if (_top)
+			_used += _top - _begin;
+		// continue in the next kept block if the allocation fits, otherwise in a new one
+		size_t next = _top ? _current + 1 : 0;
+		while (next < _blocks.size() && _blocks[next]._size < bytes_ + align_)
+			++next;
+		if (next == _blocks.size())
+			add_block(bytes_ + align_);
+		use_block(next);
+		return allocate(bytes_, align_);
+	}
+
+	void frame_arena::add_block(size_t min_bytes_)
+	{
+		const size_t words = (std::max(_block_size, min_bytes_) + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t);
+		block blk;
+		blk._data.reset(new std::max_align_t[words]);
+		blk._size = words * sizeof(std::max_align_t);
+		_blocks.push_back(std::move(blk));
+		++_blocks_allocated;
+	}
+
+	void frame_arena::use_block(size_t index_)
+	{
+		_current = index_;
+		_begin = _top = reinterpret_cast<uint8_t*>(_blocks[index_]._data.get());
+		_end = _begin + _blocks[index_]._size;
+	}
+
+	void frame_arena::reset()
+	{
+		_peak = std::max(_peak, used());
+		if (_blocks.size() > 1) {
+			// a frame needed more than one block, from now on a single block holds all of it
+			_block_size = capacity();
+			_blocks.clear();
+			add_block(_block_size);
+		}
+		_used = 0;
+		if (_blocks.empty()) {
+			_current = 0;
+			_begin = _top = _end = nullptr;
+		}
+		else
+			use_block(0);
+	}
+
+	size_t frame_arena::capacity() const
+	{
+		size_t res = 0;
+		for (const block& blk : _blocks)
+			res += blk._size;
+		return res;
+	}
+
+}
@@ -0,0 +1,47 @@
+#include <sally/util/histogram.hpp>
+#include <algorithm>
+
+namespace sally {
+
+	uint64_t histogram::count() const
+	{
+		uint64_t total = 0;
+		for (const std::atomic<uint64_t>& cnt : _counts)
+			total += cnt.load(std::memory_order_relaxed);
+		return total;
+	}
+
+	uint64_t histogram::percentile(double p_) const
+	{
+		const uint64_t total = count();
+		if (!total)
+			return 0;
+		uint64_t rank = static_cast<uint64_t>(p_ / 100.0 * total + 0.5);
+		rank = rank < 1 ? 1 : (rank > total ? total : rank);
+		uint64_t seen = 0;
+		for (int ii = 0; ii < BUCKETS; ++ii) {
+			seen += bucket_count(ii);
+			if (seen >= rank)
+				return std::min(bucket_upper(ii), max());
+		}
+		return max();
+	}
+
+	// static
+	uint64_t histogram::bucket_lower(int bucket_)
+	{
+		if (bucket_ < SUB_BUCKETS)
+			return static_cast<uint64_t>(bucket_);
+		const int shift = bucket_ / SUB_BUCKETS - 1;
+		return static_cast<uint64_t>(SUB_BUCKETS + bucket_ % SUB_BUCKETS) << shift;
+	}
+
+	void histogram::reset()
+	{
+		for (std::atomic<uint64_t>& cnt : _counts)
+			cnt.store(0, std::memory_order_relaxed);
+		_sum.store(0, std::memory_order_relaxed);
+		_max.store(0, std::memory_order_relaxed);
+	}
+
+}
@@ -37,12 +37,39 @@ namespace sally {
 		struct tm now;
 		SALLY_GMTIME(&t, &now);
 		char buf[128];
-		SALLY_SFORMAT(buf, sizeof(buf), "[%s][%02d/%02d/%02d %02d:%02d:%02d] ", type_,
+		SALLY_SFORMAT(buf, "[%s][%02d/%02d/%02d %02d:%02d:%02d] ", type_,
 			now.tm_mday, now.tm_mon + 1, now.tm_year % 100, now.tm_hour, now.tm_min, now.tm_sec);
 		msg << buf;
 		return msg;
 	}
 
+	void generic_logger::message::buffer::take(buffer& other_)
+	{
+		_spill = std::move(other_._spill);
+		const std::ptrdiff_t len = other_.pptr() - other_.pbase();
+		memcpy(_inline, other_._inline, size_t(len));
+		pbump(static_cast<int>(len));
+	}
+
+	auto generic_logger::message::buffer::overflow(int_type ch_) -> int_type
+	{
+		_spill.append(pbase(), pptr() - pbase());
+		setp(_inline, _inline + sizeof(_inline) - 1);
+		if (!traits_type::eq_int_type(ch_, traits_type::eof()))
+			_spill.push_back(traits_type::to_char_type(ch_));
+		return traits_type::not_eof(ch_);
+	}
+
+	const char* generic_logger::message::buffer::c_str()
+	{
+		if (_spill.empty()) {
+			*pptr() = 0;
+			return _inline;
+		}
+		overflow(traits_type::eof());
+		return _spill.c_str();
+	}
+
 	//static
 	null_logger null_logger::_instance;
 
@@ -0,0 +1,68 @@
+#include <sally/util/main_thread_queue.hpp>
+#include <sally/util/logger.hpp>
+#include <SDL_timer.h>
+#include <typeinfo>
+
+namespace sally {
+
+	bool main_thread_queue::post(task_t task_, priority_t priority_)
+	{
+		mutex::Guard lg(_lock);
+		_tasks[priority_].push_back(std::move(task_));
+		return _pending++ == 0;
+	}
+
+	bool main_thread_queue::pop(task_t& task_)
+	{
+		mutex::Guard lg(_lock);
+		for (std::deque<task_t>& tasks : _tasks)
+			if (!tasks.empty()) {
+				task_ = std::move(tasks.front());
+				tasks.pop_front();
+				--_pending;
+				return true;
+			}
+		return false;
+	}
+
+	const main_thread_queue::Report& main_thread_queue::drain()
+	{
+		const Uint64 start = SDL_GetPerformanceCounter();
+		const Uint64 budget = _budget_ms > 0 ? Uint64(_budget_ms * SDL_GetPerformanceFrequency() / 1000) : 0;
+		size_t limit = pending(); // tasks posted while draining run next time
+		task_t task;
+
+		_report = Report();
+		while (limit-- && pop(task)) {
+			try {
+				task();
+			}
+			catch (sally::exception& e) {
+				loge() << typeid(e).name() << " in main thread task : " << e.what();
+			}
+			catch (std::exception& e) {
+				loge() << typeid(e).name() << " in main thread task : " << e.what();
+			}
+			catch (...) {
+				loge() << "unknown exception in main thread task";
+			}
+			task = nullptr; // release captured state now
+			++_report.executed;
+			if (budget && SDL_GetPerformanceCounter() - start >= budget)
+				break;
+		}
+		_report.deferred = pending();
+		_report.ms = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+		return _report;
+	}
+
+	void main_thread_queue::clear()
+	{
+		std::deque<task_t> dropped[PRIORITIES]; // destroyed after unlocking, captured state may post
+		mutex::Guard lg(_lock);
+		for (int pp = 0; pp < PRIORITIES; ++pp)
+			dropped[pp].swap(_tasks[pp]);
+		_pending = 0;
+	}
+
+}
@@ -0,0 +1,78 @@
+#include <sally/util/mapped_file.hpp>
+
+#ifdef SALLY_WINDOWS
+# define WIN32_LEAN_AND_MEAN
+# include <windows.h>
+#else
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <fcntl.h>
+# include <unistd.h>
+#endif
+
+namespace sally {
+
+#ifdef SALLY_WINDOWS
+
+	mapped_file::mapped_file(const std::string& path_)
+		: _path(path_), _data(nullptr), _size(0), _file(INVALID_HANDLE_VALUE), _mapping(nullptr)
+	{
+		_file = CreateFileA(path_.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (_file == INVALID_HANDLE_VALUE)
+			throw general_exception(("cannot open " + path_).c_str());
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(_file, &size) || size.QuadPart == 0) {
+			CloseHandle(_file);
+			throw general_exception(("cannot map empty file " + path_).c_str());
+		}
+		_size = static_cast<size_t>(size.QuadPart);
+
+		_mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		_data = _mapping ? static_cast<const uint8_t*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+		if (!_data) {
+			if (_mapping)
+				CloseHandle(_mapping);
+			CloseHandle(_file);
+			throw general_exception(("cannot map " + path_).c_str());
+		}
+	}
+
+	mapped_file::~mapped_file()
+	{
+		UnmapViewOfFile(_data);
+		CloseHandle(_mapping);
+		CloseHandle(_file);
+	}
+
+#else
+
+	mapped_file::mapped_file(const std::string& path_)
+		: _path(path_), _data(nullptr), _size(0)
+	{
+		int fd = open(path_.c_str(), O_RDONLY);
+		if (fd < 0)
+			throw general_exception(("cannot open " + path_).c_str());
+
+		struct stat st;
+		if (fstat(fd, &st) != 0 || st.st_size == 0) {
+			close(fd);
+			throw general_exception(("cannot map empty file " + path_).c_str());
+		}
+		_size = static_cast<size_t>(st.st_size);
+
+		void* data = mmap(nullptr, _size, PROT_READ, MAP_SHARED, fd, 0);
+		close(fd); // the mapping keeps the file referenced
+		if (data == MAP_FAILED)
+			throw general_exception(("cannot map " + path_).c_str());
+		_data = static_cast<const uint8_t*>(data);
+	}
+
+	mapped_file::~mapped_file()
+	{
+		munmap(const_cast<uint8_t*>(_data), _size);
+	}
+
+#endif
+
+}
@@ -0,0 +1,97 @@
+#include <sally/util/metrics.hpp>
+
+namespace sally {
+
+	namespace {
+		void write_sample(std::ostream& out_, const std::string& name_, const char* suffix_, const std::string& labels_, const char* extra_label_, uint64_t value_) {
+			out_ << name_ << suffix_;
+			if (!labels_.empty() || extra_label_) {
+				out_ << '{' << labels_;
+				if (extra_label_)
+					out_ << (labels_.empty() ? "" : ",") << extra_label_;
+				out_ << '}';
+			}
+			out_ << ' ' << value_ << '\n';
+		}
+	}
+
+	metrics_registry::Series& metrics_registry::series(const std::string& name_, const std::string& help_, const std::string& labels_, type_t type_)
+	{
+		auto inserted = _families.insert(std::make_pair(name_, Family()));
+		Family& family = inserted.first->second;
+		if (inserted.second) {
+			family._type = type_;
+			family._help = help_;
+		}
+		if (family._type != type_)
+			throw general_exception(("metric registered with another type: " + name_).c_str());
+		for (Series& ser : family._series)
+			if (ser._labels == labels_)
+				return ser;
+		family._series.push_back(Series());
+		Series& ser = family._series.back();
+		ser._labels = labels_;
+		switch (type_) {
+		case TYPE_COUNTER: ser._counter.reset(new counter()); break;
+		case TYPE_GAUGE: ser._gauge.reset(new gauge()); break;
+		case TYPE_HISTOGRAM: ser._histogram.reset(new histogram()); break;
+		}
+		return ser;
+	}
+
+	counter& metrics_registry::add_counter(const std::string& name_, const std::string& help_, const std::string& labels_)
+	{
+		mutex::Guard lg(_lock);
+		return *series(name_, help_, labels_, TYPE_COUNTER)._counter;
+	}
+
+	gauge& metrics_registry::add_gauge(const std::string& name_, const std::string& help_, const std::string& labels_)
+	{
+		mutex::Guard lg(_lock);
+		return *series(name_, help_, labels_, TYPE_GAUGE)._gauge;
+	}
+
+	histogram& metrics_registry::add_histogram(const std::string& name_, const std::string& help_, const std::string& labels_)
+	{
+		mutex::Guard lg(_lock);
+		return *series(name_, help_, labels_, TYPE_HISTOGRAM)._histogram;
+	}
+
+	void metrics_registry::write_prometheus(std::ostream& out_) const
+	{
+		static const char* type_names[] = { "counter", "gauge", "summary" };
+		mutex::Guard lg(_lock);
+		for (auto it = _families.begin(); it != _families.end(); ++it) {
+			const std::string& name = it->first;
+			const Family& family = it->second;
+			out_ << "# HELP " << name << ' ' << family._help << '\n';
+			out_ << "# TYPE " << name << ' ' << type_names[family._type] << '\n';
+			for (const Series& ser : family._series) {
+				switch (family._type) {
+				case TYPE_COUNTER:
+					write_sample(out_, name, "", ser._labels, nullptr, ser._counter->value());
+					break;
+				case TYPE_GAUGE: {
+					const int64_t value = ser._gauge->value();
+					out_ << name;
+					if (!ser._labels.empty())
+						out_ << '{' << ser._labels << '}';
+					out_ << ' ' << value << '\n';
+					break;
+				}
+				case TYPE_HISTOGRAM: {
+					const histogram& hist = *ser._histogram;
+					write_sample(out_, name, "", ser._labels, "quantile=\"0.5\"", hist.percentile(50));
+					write_sample(out_, name, "", ser._labels, "quantile=\"0.9\"", hist.percentile(90));
+					write_sample(out_, name, "", ser._labels, "quantile=\"0.99\"", hist.percentile(99));
+					write_sample(out_, name, "", ser._labels, "quantile=\"1\"", hist.max());
+					write_sample(out_, name, "_sum", ser._labels, nullptr, hist.sum());
+					write_sample(out_, name, "_count", ser._labels, nullptr, hist.count());
+					break;
+				}
+				}
+			}
+		}
+	}
+
+}
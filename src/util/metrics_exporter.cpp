@@ -0,0 +1,114 @@
+#include <sally/util/metrics_exporter.hpp>
+#include <sally/util/logger.hpp>
+#include <SDL_thread.h>
+#include <sstream>
+#include <cstdio>
+
+#ifndef SALLY_WINDOWS
+# include <sys/socket.h>
+# include <sys/un.h>
+# include <unistd.h>
+# ifndef MSG_NOSIGNAL
+#  define MSG_NOSIGNAL 0
+# endif
+#endif
+
+namespace sally {
+
+	metrics_exporter::metrics_exporter(metrics_registry& registry_, target_t target_, const std::string& path_, int interval_ms_)
+		: _registry(registry_), _target(target_), _path(path_), _interval_ms(interval_ms_), _quit(false), _logged_failure(false), _thread(nullptr)
+	{
+#ifdef SALLY_WINDOWS
+		if (target_ == TARGET_UNIX_SOCKET)
+			throw general_exception("metrics_exporter: unix domain sockets are not supported on this platform");
+#endif
+		_thread = SDL_CreateThread(&metrics_exporter::thread_main, "sally_metrics", this);
+		if (!_thread)
+			throw sdl_exception("SDL_CreateThread failed");
+	}
+
+	metrics_exporter::~metrics_exporter()
+	{
+		{
+			mutex::Guard lg(_lock);
+			_quit = true;
+		}
+		_wake.notify_all();
+		SDL_WaitThread(_thread, nullptr);
+	}
+
+	// static
+	int metrics_exporter::thread_main(void* self_)
+	{
+		metrics_exporter& self = *static_cast<metrics_exporter*>(self_);
+		mutex::Guard lg(self._lock);
+		while (!self._quit) {
+			if (self._wake.wait_for(self._lock, self._interval_ms) || self._quit)
+				continue; // woken early (spuriously or to quit)
+			lg.unlock();
+			self.export_now();
+			lg.lock();
+		}
+		return 0;
+	}
+
+	bool metrics_exporter::export_now()
+	{
+		std::ostringstream text;
+		_registry.write_prometheus(text);
+		const bool ok = _target == TARGET_FILE ? write_file(text.str()) : send_socket(text.str());
+		if (ok)
+			_exports.add();
+		else {
+			_failures.add();
+			if (!_logged_failure.exchange(true))
+				logw() << "metrics export to " << _path << " failed, will keep retrying";
+		}
+		return ok;
+	}
+
+	bool metrics_exporter::write_file(const std::string& text_)
+	{
+		// readers never see a partial file
+		const std::string tmp = _path + ".tmp";
+		std::FILE* file = std::fopen(tmp.c_str(), "wb");
+		if (!file)
+			return false;
+		bool ok = std::fwrite(text_.data(), 1, text_.size(), file) == text_.size();
+		ok = std::fclose(file) == 0 && ok;
+#ifdef SALLY_WINDOWS
+		std::remove(_path.c_str()); // rename does not replace on windows
+#endif
+		ok = ok && std::rename(tmp.c_str(), _path.c_str()) == 0;
+		if (!ok)
+			std::remove(tmp.c_str());
+		return ok;
+	}
+
+	bool metrics_exporter::send_socket(const std::string& text_)
+	{
+#ifdef SALLY_WINDOWS
+		return false;
+#else
+		sockaddr_un addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		if (_path.size() >= sizeof(addr.sun_path))
+			return false;
+		memcpy(addr.sun_path, _path.c_str(), _path.size() + 1);
+
+		const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (fd < 0)
+			return false;
+		bool ok = connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+		for (size_t sent = 0; ok && sent < text_.size(); ) {
+			const ssize_t res = send(fd, text_.data() + sent, text_.size() - sent, MSG_NOSIGNAL);
+			ok = res > 0;
+			sent += ok ? static_cast<size_t>(res) : 0;
+		}
+		close(fd);
+		return ok;
+#endif
+	}
+
+}
@@ -1,43 +1,228 @@
-#pragma once
-
 #include <sally/util/threading.hpp>
-#include <SDL_mutex.h>
+#include <SDL_timer.h>
+#include <climits>
+
+#if defined(__linux__)
+# define SALLY_FUTEX_LINUX
+# include <linux/futex.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+# include <errno.h>
+# include <time.h>
+#elif defined(SALLY_WINDOWS)
+# define SALLY_FUTEX_WINDOWS
+# include <windows.h>
+# pragma comment(lib, "Synchronization.lib")
+#else
+# include <SDL_mutex.h>
+#endif
+
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+# include <immintrin.h>
+# define SALLY_CPU_RELAX() _mm_pause()
+#else
+# define SALLY_CPU_RELAX() ((void)0)
+#endif
 
 namespace sally {
 
+	static_assert(sizeof(std::atomic<int>) == sizeof(int), "futex words must be plain ints");
+
+	namespace {
+		const int MUTEX_SPINS = 64;     // lock attempts before sleeping
+		const int SPIN_MAX_BACKOFF = 64; // pause instructions, then spinlocks yield
+
+		int* word_ptr(std::atomic<int>& word_) { return reinterpret_cast<int*>(&word_); }
+	}
+
+	// Futex:
+
+#if defined(SALLY_FUTEX_LINUX)
+
+	bool futex::wait(std::atomic<int>& word_, int expected_, int timeout_ms_)
+	{
+		struct timespec ts, *pts = nullptr;
+		if (timeout_ms_ >= 0) {
+			ts.tv_sec = timeout_ms_ / 1000;
+			ts.tv_nsec = (timeout_ms_ % 1000) * 1000000L;
+			pts = &ts;
+		}
+		if (syscall(SYS_futex, word_ptr(word_), FUTEX_WAIT_PRIVATE, expected_, pts, nullptr, 0) == 0)
+			return true;
+		return errno != ETIMEDOUT;
+	}
+
+	void futex::wake_one(std::atomic<int>& word_)
+	{
+		syscall(SYS_futex, word_ptr(word_), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+	}
+
+	void futex::wake_all(std::atomic<int>& word_)
+	{
+		syscall(SYS_futex, word_ptr(word_), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+	}
+
+#elif defined(SALLY_FUTEX_WINDOWS)
+
+	bool futex::wait(std::atomic<int>& word_, int expected_, int timeout_ms_)
+	{
+		if (WaitOnAddress(word_ptr(word_), &expected_, sizeof(int), timeout_ms_ < 0 ? INFINITE : DWORD(timeout_ms_)))
+			return true;
+		return GetLastError() != ERROR_TIMEOUT;
+	}
+
+	void futex::wake_one(std::atomic<int>& word_)
+	{
+		WakeByAddressSingle(word_ptr(word_));
+	}
+
+	void futex::wake_all(std::atomic<int>& word_)
+	{
+		WakeByAddressAll(word_ptr(word_));
+	}
+
+#else
+
+	// words hash to a bucket, waiters sleep on the bucket's condition variable. the value is
+	// checked under the bucket mutex and wakers take it too, so no wakeup is lost.
+	namespace {
+		struct parking_lot {
+			static const int BUCKETS = 64;
+			struct Bucket {
+				SDL_mutex* _mutex;
+				SDL_cond* _cond;
+			} _buckets[BUCKETS];
+
+			parking_lot() {
+				for (Bucket& bucket : _buckets) {
+					bucket._mutex = SDL_CreateMutex();
+					bucket._cond = SDL_CreateCond();
+					if (!bucket._mutex || !bucket._cond)
+						throw sdl_exception("parking_lot: SDL_CreateMutex or SDL_CreateCond failed");
+				}
+			}
+
+			static Bucket& bucket(const void* addr_) {
+				static parking_lot lot;
+				return lot._buckets[(reinterpret_cast<uintptr_t>(addr_) >> 2) % BUCKETS];
+			}
+		};
+	}
+
+	bool futex::wait(std::atomic<int>& word_, int expected_, int timeout_ms_)
+	{
+		parking_lot::Bucket& bucket = parking_lot::bucket(&word_);
+		bool woken = true;
+		SDL_LockMutex(bucket._mutex);
+		if (word_.load(std::memory_order_relaxed) == expected_) {
+			if (timeout_ms_ < 0)
+				SDL_CondWait(bucket._cond, bucket._mutex);
+			else
+				woken = SDL_CondWaitTimeout(bucket._cond, bucket._mutex, Uint32(timeout_ms_)) != SDL_MUTEX_TIMEDOUT;
+		}
+		SDL_UnlockMutex(bucket._mutex);
+		return woken;
+	}
+
+	void futex::wake_one(std::atomic<int>& word_)
+	{
+		wake_all(word_); // a bucket is shared by several words
+	}
+
+	void futex::wake_all(std::atomic<int>& word_)
+	{
+		parking_lot::Bucket& bucket = parking_lot::bucket(&word_);
+		SDL_LockMutex(bucket._mutex);
+		SDL_CondBroadcast(bucket._cond);
+		SDL_UnlockMutex(bucket._mutex);
+	}
+
+#endif
+
 	// Mutex:
 
-	mutex::mutex() : _mutex(SDL_CreateMutex())
+	void mutex::lock_contended()
 	{
-		if (!_mutex)
-			throw sdl_exception("SDL_CreateMutex failed");
+		for (int ii = 0; ii < MUTEX_SPINS; ++ii) {
+			int state = _state.load(std::memory_order_relaxed);
+			if (state == UNLOCKED && _state.compare_exchange_weak(state, LOCKED, std::memory_order_acquire))
+				return;
+			if (state == CONTENDED)
+				break; // others are already sleeping, do not jump the queue
+			SALLY_CPU_RELAX();
+		}
+		// from here on the lock is held as CONTENDED since we cannot know whether others wait
+		while (_state.exchange(CONTENDED, std::memory_order_acquire) != UNLOCKED)
+			futex::wait(_state, CONTENDED);
 	}
 
-	mutex::~mutex()
+	// Condition variable:
+
+	bool condition_variable::wait_for(mutex& mutex_, int timeout_ms_)
 	{
-		SDL_DestroyMutex(_mutex);
+		const int seq = _seq.load(std::memory_order_relaxed);
+		mutex_.unlock();
+		const bool woken = futex::wait(_seq, seq, timeout_ms_);
+		while (mutex_._state.exchange(mutex::CONTENDED, std::memory_order_acquire) != mutex::UNLOCKED)
+			futex::wait(mutex_._state, mutex::CONTENDED);
+		return woken;
 	}
 
-	void mutex::lock()
+	// Shared mutex:
+
+	void shared_mutex::lock()
 	{
-		if (SDL_LockMutex(_mutex) != 0)
-			throw sdl_exception("SDL_LockMutex failed");
+		int state = _state.load(std::memory_order_relaxed);
+		for (;;) {
+			if (!(state & ~WAITING)) {
+				// keep WAITING, other sleepers are woken by unlock
+				if (_state.compare_exchange_weak(state, WRITER | state, std::memory_order_acquire))
+					return;
+				continue;
+			}
+			if (!(state & WAITING)) {
+				if (!_state.compare_exchange_weak(state, state | WAITING, std::memory_order_relaxed))
+					continue;
+				state |= WAITING;
+			}
+			futex::wait(_state, state);
+			state = _state.load(std::memory_order_relaxed);
+		}
 	}
 
-	void mutex::unlock()
+	void shared_mutex::lock_shared_contended()
 	{
-		if (SDL_UnlockMutex(_mutex) != 0)
-			throw sdl_exception("SDL_UnlockMutex failed");
+		int state = _state.load(std::memory_order_relaxed);
+		for (;;) {
+			if (!(state & (WRITER | WAITING))) {
+				if (_state.compare_exchange_weak(state, state + 1, std::memory_order_acquire))
+					return;
+				continue;
+			}
+			if (!(state & WAITING)) {
+				if (!_state.compare_exchange_weak(state, state | WAITING, std::memory_order_relaxed))
+					continue;
+				state |= WAITING;
+			}
+			futex::wait(_state, state);
+			state = _state.load(std::memory_order_relaxed);
+		}
 	}
-	
-	bool mutex::try_lock()
+
+	// Spinlock:
+
+	void spinlock::lock_contended()
 	{
-		int s = SDL_TryLockMutex(_mutex);
-		if (s == 0)
-			return true;
-		if (s == SDL_MUTEX_TIMEDOUT)
-			return false;
-		throw sdl_exception("SDL_TryLockMutex failed");
+		int backoff = 1;
+		while (!SDL_AtomicTryLock(&_lock)) {
+			if (backoff <= SPIN_MAX_BACKOFF) {
+				for (int ii = 0; ii < backoff; ++ii)
+					SALLY_CPU_RELAX();
+				backoff <<= 1;
+			}
+			else
+				SDL_Delay(0);
+		}
 	}
 
 }
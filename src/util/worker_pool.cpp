@@ -0,0 +1,145 @@
+#include <sally/util/worker_pool.hpp>
+#include <SDL_thread.h>
+#include <SDL_mutex.h>
+#include <SDL_cpuinfo.h>
+#include <algorithm>
+
+namespace sally {
+
+	worker_pool::worker_pool(int threads_)
+		: _mutex(nullptr), _wake(nullptr), _done(nullptr), _task(nullptr), _count(0), _next({ 0 }),
+		  _generation(0), _active(0), _quit(false)
+	{
+		if (threads_ < 0)
+			threads_ = std::max(SDL_GetCPUCount() - 1, 0);
+
+		_mutex = SDL_CreateMutex();
+		_wake = SDL_CreateCond();
+		_done = SDL_CreateCond();
+		if (!_mutex || !_wake || !_done) {
+			SDL_DestroyCond(_done);
+			SDL_DestroyCond(_wake);
+			SDL_DestroyMutex(_mutex);
+			throw sdl_exception("worker_pool synchronization objects creation failed");
+		}
+
+		for (int ii = 0; ii < threads_; ++ii) {
+			SDL_Thread* thread = SDL_CreateThread(&worker_pool::thread_main, "sally_worker", this);
+			if (!thread)
+				break; // we can still work with whatever threads we have
+			_threads.push_back(thread);
+		}
+	}
+
+	worker_pool::~worker_pool()
+	{
+		SDL_LockMutex(_mutex);
+		_quit = true;
+		SDL_CondBroadcast(_wake);
+		SDL_UnlockMutex(_mutex);
+
+		for (auto it = _threads.begin(); it != _threads.end(); ++it)
+			SDL_WaitThread(*it, nullptr);
+
+		SDL_DestroyCond(_done);
+		SDL_DestroyCond(_wake);
+		SDL_DestroyMutex(_mutex);
+	}
+
+	//static
+	worker_pool& worker_pool::shared()
+	{
+		static worker_pool pool;
+		return pool;
+	}
+
+	void worker_pool::run(size_t count_, const std::function<void(size_t)>& task_)
+	{
+		if (count_ == 0)
+			return;
+		if (_threads.empty() || count_ == 1) {
+			for (size_t ii = 0; ii < count_; ++ii)
+				task_(ii);
+			return;
+		}
+
+		SDL_LockMutex(_mutex);
+		while (_active) // stragglers of the previous batch may still be looking at it
+			SDL_CondWait(_done, _mutex);
+		_task = &task_;
+		_count = count_;
+		SDL_AtomicSet(&_next, 0);
+		++_generation;
+		SDL_CondBroadcast(_wake);
+		SDL_UnlockMutex(_mutex);
+
+		drain();
+
+		// all tasks are claimed, wait for workers still executing theirs:
+		SDL_LockMutex(_mutex);
+		while (_active)
+			SDL_CondWait(_done, _mutex);
+		_task = nullptr;
+		SDL_UnlockMutex(_mutex);
+	}
+
+	void worker_pool::post(std::function<void()> job_)
+	{
+		if (_threads.empty()) {
+			job_();
+			return;
+		}
+		SDL_LockMutex(_mutex);
+		_jobs.push_back(std::move(job_));
+		SDL_CondSignal(_wake);
+		SDL_UnlockMutex(_mutex);
+	}
+
+	void worker_pool::drain()
+	{
+		for (;;) {
+			size_t ii = static_cast<size_t>(SDL_AtomicAdd(&_next, 1));
+			if (ii >= _count)
+				break;
+			(*_task)(ii);
+		}
+	}
+
+	//static
+	int worker_pool::thread_main(void* self_)
+	{
+		static_cast<worker_pool*>(self_)->worker_loop();
+		return 0;
+	}
+
+	void worker_pool::worker_loop()
+	{
+		unsigned int seen = 0;
+		SDL_LockMutex(_mutex);
+		for (;;) {
+			while (!_quit && (seen == _generation || !_task) && _jobs.empty())
+				SDL_CondWait(_wake, _mutex);
+			if (_quit)
+				break;
+			if (seen == _generation || !_task) {
+				std::function<void()> job = std::move(_jobs.front());
+				_jobs.pop_front();
+				SDL_UnlockMutex(_mutex);
+				job();
+				SDL_LockMutex(_mutex);
+				continue;
+			}
+			seen = _generation;
+			++_active;
+			SDL_UnlockMutex(_mutex);
+
+			drain();
+
+			SDL_LockMutex(_mutex);
+			if (--_active == 0)
+				SDL_CondBroadcast(_done);
+		}
+		SDL_UnlockMutex(_mutex);
+	}
+
+}